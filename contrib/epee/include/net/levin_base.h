@@ -69,6 +69,7 @@ namespace levin
 
 #define LEVIN_DEFAULT_TIMEOUT_PRECONFIGURED 0
 #define LEVIN_DEFAULT_MAX_PACKET_SIZE 100000000      //100MB by default
+#define LEVIN_MAX_POOLED_FRAME_BUFFER_SIZE 4194304   //frame buffers up to 4MB are reused by connection
 
 #define LEVIN_PACKET_REQUEST			0x00000001
 #define LEVIN_PACKET_RESPONSE		0x00000002
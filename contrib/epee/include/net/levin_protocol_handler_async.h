@@ -121,6 +121,7 @@ public:
   t_connection_context& m_connection_context;
 
   std::string m_cache_in_buffer;
+  std::string m_frame_buffer;
   stream_state m_state;
 
   int32_t m_oponent_protocol_ver;
@@ -316,15 +317,19 @@ public:
       return false;
     }
 
-    if(m_cache_in_buffer.size() +  cb > m_config.m_max_packet_size)
+    if(m_cache_in_buffer.size() + m_frame_buffer.size() + cb > m_config.m_max_packet_size)
     {
       LOG_ERROR_CC(m_connection_context, "Maximum packet size exceed!, m_max_packet_size = " << m_config.m_max_packet_size 
-                          << ", packet received " << m_cache_in_buffer.size() +  cb 
+                          << ", packet received " << m_cache_in_buffer.size() + m_frame_buffer.size() + cb 
                           << ", connection will be closed.");
       return false;
     }
 
-    m_cache_in_buffer.append((const char*)ptr, cb);
+    // Header bytes go to m_cache_in_buffer, body bytes go straight to m_frame_buffer, which is handed to the
+    // commands handler without further copying or prefix erasing. A body up to LEVIN_MAX_POOLED_FRAME_BUFFER_SIZE
+    // is reserved up front and copied once; a bigger one grows the buffer, which copies it again amortized.
+    const char* pdata = static_cast<const char*>(ptr);
+    size_t data_left = cb;
 
     bool is_continue = true;
     while(is_continue)
@@ -332,20 +337,20 @@ public:
       switch(m_state)
       {
       case stream_state_body:
-        if(m_cache_in_buffer.size() < m_current_head.m_cb)
         {
-          is_continue = false;
-          break;
+          size_t body_part_size = std::min(data_left, static_cast<size_t>(m_current_head.m_cb - m_frame_buffer.size()));
+          m_frame_buffer.append(pdata, body_part_size);
+          pdata += body_part_size;
+          data_left -= body_part_size;
+          if(m_frame_buffer.size() < m_current_head.m_cb)
+          {
+            is_continue = false;
+            break;
+          }
         }
         {
           std::string buff_to_invoke;
-          if(m_cache_in_buffer.size()  == m_current_head.m_cb)
-            buff_to_invoke.swap(m_cache_in_buffer);
-          else
-          {
-            buff_to_invoke.assign(m_cache_in_buffer, 0, (std::string::size_type)m_current_head.m_cb);
-            m_cache_in_buffer.erase(0, (std::string::size_type)m_current_head.m_cb);
-          }
+          buff_to_invoke.swap(m_frame_buffer);
 
           bool is_response = (m_oponent_protocol_ver == LEVIN_PROTOCOL_VER_1 && m_current_head.m_flags&LEVIN_PACKET_RESPONSE);
 
@@ -403,10 +408,10 @@ public:
               m_current_head.m_have_to_return_data = false;
               m_current_head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
               m_current_head.m_flags = LEVIN_PACKET_RESPONSE;
-              std::string send_buff((const char*)&m_current_head, sizeof(m_current_head));
-              send_buff += return_buff;
               CRITICAL_REGION_BEGIN(m_send_lock);
-              if(!m_pservice_endpoint->do_send(send_buff.data(), send_buff.size()))
+              if(!m_pservice_endpoint->do_send(&m_current_head, sizeof(m_current_head)))
+                return false;
+              if(!m_pservice_endpoint->do_send(return_buff.data(), return_buff.size()))
                 return false;
               CRITICAL_REGION_END();
               LOG_PRINT_CC_L4(m_connection_context, "LEVIN_PACKET_SENT. [len=" << m_current_head.m_cb 
@@ -418,11 +423,23 @@ public:
             else
               m_config.m_pcommands_handler->notify(m_current_head.m_command, buff_to_invoke, m_connection_context);
           }
+
+          // Keep the allocation for the next frame, unless it is too big to hold on an idle connection
+          if(buff_to_invoke.capacity() <= LEVIN_MAX_POOLED_FRAME_BUFFER_SIZE && m_frame_buffer.capacity() < buff_to_invoke.capacity())
+          {
+            buff_to_invoke.clear();
+            m_frame_buffer.swap(buff_to_invoke);
+          }
         }
         m_state = stream_state_head;
         break;
       case stream_state_head:
         {
+          size_t head_part_size = std::min(data_left, sizeof(bucket_head2) - m_cache_in_buffer.size());
+          m_cache_in_buffer.append(pdata, head_part_size);
+          pdata += head_part_size;
+          data_left -= head_part_size;
+
           if(m_cache_in_buffer.size() < sizeof(bucket_head2))
           {
             if(m_cache_in_buffer.size() >= sizeof(uint64_t) && *((uint64_t*)m_cache_in_buffer.data()) != LEVIN_SIGNATURE)
@@ -442,7 +459,7 @@ public:
           }
           m_current_head = *phead;
 
-          m_cache_in_buffer.erase(0, sizeof(bucket_head2));
+          m_cache_in_buffer.clear();
           m_state = stream_state_body;
           m_oponent_protocol_ver = m_current_head.m_protocol_version;
           if(m_current_head.m_cb > m_config.m_max_packet_size)
@@ -452,6 +469,12 @@ public:
               << ", connection will be closed.");
             return false;
           }
+
+          // The header alone must not pin memory: reserve at most the pooled size and let the body grow the buffer
+          m_frame_buffer.clear();
+          size_t reserve_size = static_cast<size_t>(std::min<uint64_t>(m_current_head.m_cb, LEVIN_MAX_POOLED_FRAME_BUFFER_SIZE));
+          if(m_frame_buffer.capacity() < reserve_size)
+            m_frame_buffer.reserve(reserve_size);
         }
         break;
       default:
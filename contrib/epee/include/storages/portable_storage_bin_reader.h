@@ -0,0 +1,486 @@
+// Copyright (c) 2006-2013, Andrey N. Sabelnikov, www.sabelnikov.net
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// * Neither the name of the Andrey N. Sabelnikov nor the
+// names of its contributors may be used to endorse or promote products
+// derived from this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER  BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+
+
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include <boost/mpl/assert.hpp>
+#include <boost/mpl/contains.hpp>
+
+#include "misc_language.h"
+#include "portable_storage_base.h"
+#include "portable_storage_from_bin.h"
+#include "portable_storage_val_converters.h"
+
+namespace epee
+{
+  namespace serialization
+  {
+    /************************************************************************/
+    /* Reads binary portable storage blob without building storage tree.    */
+    /* Blob is scanned once to index entries of all sections, values are    */
+    /* decoded straight into KV_SERIALIZE targets. Source buffer must       */
+    /* outlive the reader.                                                  */
+    /************************************************************************/
+    class portable_storage_bin_reader
+    {
+    public:
+      struct entry_view
+      {
+        const char* m_name;
+        uint8_t m_name_size;
+        uint8_t m_type;
+        const uint8_t* m_value;
+        size_t m_section; //index in m_sections of the section, or of the first one of an array of sections
+      };
+
+      struct section_view
+      {
+        std::vector<entry_view> m_entries;
+      };
+
+      struct array_view
+      {
+        uint8_t m_type;
+        size_t m_remaining;
+        const uint8_t* m_cursor;
+        size_t m_section;
+      };
+
+      typedef section_view* hsection;
+      typedef array_view*   harray;
+      typedef storage_entry meta_entry;
+
+      portable_storage_bin_reader():m_begin(nullptr), m_end(nullptr){}
+
+      bool       load_from_binary(const binarybuffer& source);
+
+      hsection   open_section(const std::string& section_name,  hsection hparent_section, bool create_if_notexist = false);
+      template<class t_value>
+      bool       get_value(const std::string& value_name, t_value& val, hsection hparent_section);
+      bool       get_value(const std::string& value_name, storage_entry& val, hsection hparent_section);
+
+      //serial access for arrays of values --------------------------------------
+      template<class t_value>
+      harray     get_first_value(const std::string& value_name, t_value& target, hsection hparent_section);
+      template<class t_value>
+      bool       get_next_value(harray hval_array, t_value& target);
+      harray     get_first_section(const std::string& sec_name, hsection& h_child_section, hsection hparent_section);
+      bool       get_next_section(harray hsec_array, hsection& h_child_section);
+
+    private:
+      void check_available(const uint8_t* ptr, size_t count) const;
+      size_t read_varint(const uint8_t*& ptr) const;
+      const uint8_t* parse_section(const uint8_t* ptr, section_view& sec, size_t depth);
+      const uint8_t* skip_section(const uint8_t* ptr, size_t depth) const;
+      const uint8_t* skip_value(uint8_t type, const uint8_t* ptr, size_t depth) const;
+      const uint8_t* skip_array(uint8_t type, const uint8_t* ptr, size_t depth) const;
+      const entry_view* find_entry(const std::string& name, hsection hparent_section);
+      template<class t_value>
+      void read_value(uint8_t type, const uint8_t*& ptr, t_value& target) const;
+      void read_value(uint8_t type, const uint8_t*& ptr, std::string& target) const;
+      template<class t_pod_type, class t_value>
+      static void read_pod_value(const uint8_t*& ptr, t_value& target);
+      static size_t pod_value_size(uint8_t type);
+
+      const uint8_t* m_begin;
+      const uint8_t* m_end;
+      section_view m_root;
+      std::deque<section_view> m_sections;
+      std::deque<array_view> m_arrays;
+    };
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    bool portable_storage_bin_reader::load_from_binary(const binarybuffer& source)
+    {
+      m_root.m_entries.clear();
+      m_sections.clear();
+      m_arrays.clear();
+
+      const size_t header_size = 2 * sizeof(uint32_t) + sizeof(uint8_t);
+      if(source.size() < header_size)
+      {
+        LOG_WARNING("portable_storage_bin_reader: wrong binary format, packet size = " << source.size() << " less than expected header size = "
+            << header_size, LOG_LEVEL_2)
+        return false;
+      }
+      uint32_t signature_a = 0;
+      uint32_t signature_b = 0;
+      memcpy(&signature_a, source.data(), sizeof(signature_a));
+      memcpy(&signature_b, source.data() + sizeof(signature_a), sizeof(signature_b));
+      uint8_t ver = static_cast<uint8_t>(source[2 * sizeof(uint32_t)]);
+      if(signature_a != PORTABLE_STORAGE_SIGNATUREA || signature_b != PORTABLE_STORAGE_SIGNATUREB)
+      {
+        LOG_WARNING("portable_storage_bin_reader: wrong binary format - signature missmatch", LOG_LEVEL_2);
+        return false;
+      }
+      if(ver != PORTABLE_STORAGE_FORMAT_VER)
+      {
+        LOG_WARNING("portable_storage_bin_reader: wrong binary format - unknown format ver = " << ver, LOG_LEVEL_2);
+        return false;
+      }
+      TRY_ENTRY();
+      m_begin = reinterpret_cast<const uint8_t*>(source.data());
+      m_end = m_begin + source.size();
+      parse_section(m_begin + header_size, m_root, 0);
+      return true;
+      CATCH_ENTRY("portable_storage_bin_reader::load_from_binary", false);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    void portable_storage_bin_reader::check_available(const uint8_t* ptr, size_t count) const
+    {
+      CHECK_AND_ASSERT_THROW_MES(static_cast<size_t>(m_end - ptr) >= count, " attempt to read " << count << " bytes from buffer with " << (m_end - ptr) << " bytes remained");
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    size_t portable_storage_bin_reader::read_varint(const uint8_t*& ptr) const
+    {
+      check_available(ptr, 1);
+      uint64_t v = 0;
+      size_t size = 0;
+      switch(*ptr & PORTABLE_RAW_SIZE_MARK_MASK)
+      {
+      case PORTABLE_RAW_SIZE_MARK_BYTE:  size = sizeof(uint8_t); break;
+      case PORTABLE_RAW_SIZE_MARK_WORD:  size = sizeof(uint16_t); break;
+      case PORTABLE_RAW_SIZE_MARK_DWORD: size = sizeof(uint32_t); break;
+      case PORTABLE_RAW_SIZE_MARK_INT64: size = sizeof(uint64_t); break;
+      }
+      check_available(ptr, size);
+      memcpy(&v, ptr, size);
+      ptr += size;
+      return static_cast<size_t>(v >> 2);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    size_t portable_storage_bin_reader::pod_value_size(uint8_t type)
+    {
+      switch(type)
+      {
+      case SERIALIZE_TYPE_INT64:  return sizeof(int64_t);
+      case SERIALIZE_TYPE_INT32:  return sizeof(int32_t);
+      case SERIALIZE_TYPE_INT16:  return sizeof(int16_t);
+      case SERIALIZE_TYPE_INT8:   return sizeof(int8_t);
+      case SERIALIZE_TYPE_UINT64: return sizeof(uint64_t);
+      case SERIALIZE_TYPE_UINT32: return sizeof(uint32_t);
+      case SERIALIZE_TYPE_UINT16: return sizeof(uint16_t);
+      case SERIALIZE_TYPE_UINT8:  return sizeof(uint8_t);
+      case SERIALIZE_TYPE_DUOBLE: return sizeof(double);
+      case SERIALIZE_TYPE_BOOL:   return sizeof(bool);
+      default:                    return 0;
+      }
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    const uint8_t* portable_storage_bin_reader::parse_section(const uint8_t* ptr, section_view& sec, size_t depth)
+    {
+      CHECK_AND_ASSERT_THROW_MES(depth < EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL, "Wrong blob data in portable storage: recursion limitation (" << EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL << ") exceeded");
+      size_t count = read_varint(ptr);
+      // every entry takes at least 2 bytes (name length and type), don't trust count blindly
+      sec.m_entries.reserve(std::min(count, static_cast<size_t>(m_end - ptr) / 2));
+      while(count--)
+      {
+        entry_view entry;
+        check_available(ptr, 1);
+        entry.m_name_size = *ptr++;
+        check_available(ptr, entry.m_name_size + 1);
+        entry.m_name = reinterpret_cast<const char*>(ptr);
+        ptr += entry.m_name_size;
+        entry.m_type = *ptr++;
+        entry.m_value = ptr;
+        entry.m_section = 0;
+        if(SERIALIZE_TYPE_OBJECT == entry.m_type)
+        {
+          //nested sections are indexed in the same pass, references to deque elements survive growing it
+          entry.m_section = m_sections.size();
+          m_sections.push_back(section_view());
+          ptr = parse_section(ptr, m_sections.back(), depth + 1);
+        }
+        else if((SERIALIZE_TYPE_OBJECT | SERIALIZE_FLAG_ARRAY) == entry.m_type)
+        {
+          CHECK_AND_ASSERT_THROW_MES(depth + 1 < EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL, "Wrong blob data in portable storage: recursion limitation (" << EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL << ") exceeded");
+          size_t sections_count = read_varint(ptr);
+          // every section takes at least 1 byte (entries count)
+          CHECK_AND_ASSERT_THROW_MES(sections_count <= static_cast<size_t>(m_end - ptr), "array of " << sections_count << " sections goes out of remain storage len " << (m_end - ptr));
+          entry.m_section = m_sections.size();
+          m_sections.resize(m_sections.size() + sections_count);
+          for(size_t i = 0; i != sections_count; ++i)
+            ptr = parse_section(ptr, m_sections[entry.m_section + i], depth + 2);
+        }
+        else
+        {
+          ptr = skip_value(entry.m_type, ptr, depth);
+        }
+        sec.m_entries.push_back(entry);
+      }
+      return ptr;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    const uint8_t* portable_storage_bin_reader::skip_section(const uint8_t* ptr, size_t depth) const
+    {
+      CHECK_AND_ASSERT_THROW_MES(depth < EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL, "Wrong blob data in portable storage: recursion limitation (" << EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL << ") exceeded");
+      size_t count = read_varint(ptr);
+      while(count--)
+      {
+        check_available(ptr, 1);
+        uint8_t name_size = *ptr++;
+        check_available(ptr, name_size + 1);
+        ptr += name_size;
+        uint8_t type = *ptr++;
+        ptr = skip_value(type, ptr, depth);
+      }
+      return ptr;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    const uint8_t* portable_storage_bin_reader::skip_value(uint8_t type, const uint8_t* ptr, size_t depth) const
+    {
+      if(type & SERIALIZE_FLAG_ARRAY)
+        return skip_array(type & ~SERIALIZE_FLAG_ARRAY, ptr, depth + 1);
+
+      size_t pod_size = pod_value_size(type);
+      if(pod_size)
+      {
+        check_available(ptr, pod_size);
+        return ptr + pod_size;
+      }
+
+      switch(type)
+      {
+      case SERIALIZE_TYPE_STRING:
+        {
+          size_t len = read_varint(ptr);
+          CHECK_AND_ASSERT_THROW_MES(len < MAX_STRING_LEN_POSSIBLE, "to big string len value in storage: " << len);
+          check_available(ptr, len);
+          return ptr + len;
+        }
+      case SERIALIZE_TYPE_OBJECT:
+        return skip_section(ptr, depth + 1);
+      case SERIALIZE_TYPE_ARRAY:
+        {
+          check_available(ptr, 1);
+          uint8_t array_type = *ptr++;
+          CHECK_AND_ASSERT_THROW_MES(array_type & SERIALIZE_FLAG_ARRAY, "wrong type sequenses");
+          return skip_array(array_type & ~SERIALIZE_FLAG_ARRAY, ptr, depth + 1);
+        }
+      default:
+        ASSERT_MES_AND_THROW("unknown entry_type code = " << static_cast<int>(type));
+      }
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    const uint8_t* portable_storage_bin_reader::skip_array(uint8_t type, const uint8_t* ptr, size_t depth) const
+    {
+      CHECK_AND_ASSERT_THROW_MES(depth < EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL, "Wrong blob data in portable storage: recursion limitation (" << EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL << ") exceeded");
+      size_t count = read_varint(ptr);
+      size_t pod_size = pod_value_size(type);
+      if(pod_size)
+      {
+        CHECK_AND_ASSERT_THROW_MES(count <= static_cast<size_t>(m_end - ptr) / pod_size, "array of " << count << " elements goes out of remain storage len " << (m_end - ptr));
+        return ptr + count * pod_size;
+      }
+
+      while(count--)
+      {
+        if(SERIALIZE_TYPE_OBJECT == type)
+          ptr = skip_section(ptr, depth + 1);
+        else
+          ptr = skip_value(type, ptr, depth);
+      }
+      return ptr;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    const portable_storage_bin_reader::entry_view* portable_storage_bin_reader::find_entry(const std::string& name, hsection hparent_section)
+    {
+      if(!hparent_section) hparent_section = &m_root;
+      for(const entry_view& entry: hparent_section->m_entries)
+      {
+        if(entry.m_name_size == name.size() && 0 == memcmp(entry.m_name, name.data(), name.size()))
+          return &entry;
+      }
+      return nullptr;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_pod_type, class t_value>
+    void portable_storage_bin_reader::read_pod_value(const uint8_t*& ptr, t_value& target)
+    {
+      t_pod_type v;
+      memcpy(&v, ptr, sizeof(v));
+      ptr += sizeof(v);
+      convert_t(v, target);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    void portable_storage_bin_reader::read_value(uint8_t type, const uint8_t*& ptr, t_value& target) const
+    {
+      switch(type)
+      {
+      case SERIALIZE_TYPE_INT64:  read_pod_value<int64_t>(ptr, target); break;
+      case SERIALIZE_TYPE_INT32:  read_pod_value<int32_t>(ptr, target); break;
+      case SERIALIZE_TYPE_INT16:  read_pod_value<int16_t>(ptr, target); break;
+      case SERIALIZE_TYPE_INT8:   read_pod_value<int8_t>(ptr, target); break;
+      case SERIALIZE_TYPE_UINT64: read_pod_value<uint64_t>(ptr, target); break;
+      case SERIALIZE_TYPE_UINT32: read_pod_value<uint32_t>(ptr, target); break;
+      case SERIALIZE_TYPE_UINT16: read_pod_value<uint16_t>(ptr, target); break;
+      case SERIALIZE_TYPE_UINT8:  read_pod_value<uint8_t>(ptr, target); break;
+      case SERIALIZE_TYPE_DUOBLE: read_pod_value<double>(ptr, target); break;
+      case SERIALIZE_TYPE_BOOL:   read_pod_value<bool>(ptr, target); break;
+      case SERIALIZE_TYPE_STRING:
+        {
+          std::string v;
+          read_value(type, ptr, v);
+          convert_t(v, target);
+        }
+        break;
+      default:
+        ASSERT_MES_AND_THROW("WRONG DATA CONVERSION: from entry type=" << static_cast<int>(type) << " to type " << typeid(t_value).name());
+      }
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    void portable_storage_bin_reader::read_value(uint8_t type, const uint8_t*& ptr, std::string& target) const
+    {
+      CHECK_AND_ASSERT_THROW_MES(SERIALIZE_TYPE_STRING == type, "WRONG DATA CONVERSION: from entry type=" << static_cast<int>(type) << " to type std::string");
+      size_t len = read_varint(ptr);
+      target.assign(reinterpret_cast<const char*>(ptr), len);
+      ptr += len;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    portable_storage_bin_reader::hsection portable_storage_bin_reader::open_section(const std::string& section_name, hsection hparent_section, bool create_if_notexist)
+    {
+      TRY_ENTRY();
+      const entry_view* pentry = find_entry(section_name, hparent_section);
+      if(!pentry || pentry->m_type != SERIALIZE_TYPE_OBJECT)
+      {
+        if(!create_if_notexist)
+          return nullptr;
+        //behave like portable_storage, which creates empty section
+        m_sections.push_back(section_view());
+        return &m_sections.back();
+      }
+
+      return &m_sections[pentry->m_section];
+      CATCH_ENTRY("portable_storage_bin_reader::open_section", nullptr);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    bool portable_storage_bin_reader::get_value(const std::string& value_name, t_value& val, hsection hparent_section)
+    {
+      BOOST_MPL_ASSERT(( boost::mpl::contains<storage_entry::types, t_value> ));
+      const entry_view* pentry = find_entry(value_name, hparent_section);
+      if(!pentry)
+        return false;
+
+      const uint8_t* ptr = pentry->m_value;
+      read_value(pentry->m_type, ptr, val);
+      return true;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    bool portable_storage_bin_reader::get_value(const std::string& value_name, storage_entry& val, hsection hparent_section)
+    {
+      const entry_view* pentry = find_entry(value_name, hparent_section);
+      if(!pentry)
+        return false;
+
+      //rare case, so just let the tree reader materialize this entry; it starts from the type byte
+      throwable_buffer_reader buf_reader(pentry->m_value - 1, m_end - pentry->m_value + 1);
+      val = buf_reader.load_storage_entry();
+      return true;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    portable_storage_bin_reader::harray portable_storage_bin_reader::get_first_value(const std::string& value_name, t_value& target, hsection hparent_section)
+    {
+      BOOST_MPL_ASSERT(( boost::mpl::contains<storage_entry::types, t_value> ));
+      const entry_view* pentry = find_entry(value_name, hparent_section);
+      if(!pentry || !(pentry->m_type & SERIALIZE_FLAG_ARRAY))
+        return nullptr;
+
+      array_view av;
+      av.m_type = pentry->m_type & ~SERIALIZE_FLAG_ARRAY;
+      av.m_cursor = pentry->m_value;
+      av.m_remaining = read_varint(av.m_cursor);
+      av.m_section = 0;
+      m_arrays.push_back(av);
+      if(!get_next_value(&m_arrays.back(), target))
+        return nullptr;
+      return &m_arrays.back();
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    bool portable_storage_bin_reader::get_next_value(harray hval_array, t_value& target)
+    {
+      BOOST_MPL_ASSERT(( boost::mpl::contains<storage_entry::types, t_value> ));
+      CHECK_AND_ASSERT(hval_array, false);
+      if(!hval_array->m_remaining)
+        return false;
+      --hval_array->m_remaining;
+      read_value(hval_array->m_type, hval_array->m_cursor, target);
+      return true;
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    portable_storage_bin_reader::harray portable_storage_bin_reader::get_first_section(const std::string& sec_name, hsection& h_child_section, hsection hparent_section)
+    {
+      TRY_ENTRY();
+      const entry_view* pentry = find_entry(sec_name, hparent_section);
+      if(!pentry || pentry->m_type != (SERIALIZE_TYPE_OBJECT | SERIALIZE_FLAG_ARRAY))
+        return nullptr;
+
+      array_view av;
+      av.m_type = SERIALIZE_TYPE_OBJECT;
+      av.m_cursor = pentry->m_value;
+      av.m_remaining = read_varint(av.m_cursor);
+      av.m_section = pentry->m_section;
+      m_arrays.push_back(av);
+      if(!get_next_section(&m_arrays.back(), h_child_section))
+        return nullptr;
+      return &m_arrays.back();
+      CATCH_ENTRY("portable_storage_bin_reader::get_first_section", nullptr);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    bool portable_storage_bin_reader::get_next_section(harray hsec_array, hsection& h_child_section)
+    {
+      TRY_ENTRY();
+      CHECK_AND_ASSERT(hsec_array, false);
+      if(hsec_array->m_type != SERIALIZE_TYPE_OBJECT || !hsec_array->m_remaining)
+        return false;
+      --hsec_array->m_remaining;
+      h_child_section = &m_sections[hsec_array->m_section++];
+      return true;
+      CATCH_ENTRY("portable_storage_bin_reader::get_next_section", false);
+    }
+  }
+}
@@ -0,0 +1,255 @@
+// Copyright (c) 2006-2013, Andrey N. Sabelnikov, www.sabelnikov.net
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// * Neither the name of the Andrey N. Sabelnikov nor the
+// names of its contributors may be used to endorse or promote products
+// derived from this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER  BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+
+
+#pragma once
+
+#include <cstring>
+#include <deque>
+
+#include "misc_language.h"
+#include "portable_storage_base.h"
+#include "portable_storage_to_bin.h"
+
+namespace epee
+{
+  namespace serialization
+  {
+    template<class t_value> struct bin_writer_type_code;
+#define BIN_WRITER_TYPE_CODE(t_value, code) template<> struct bin_writer_type_code<t_value> { static const uint8_t value = code; };
+    BIN_WRITER_TYPE_CODE(int64_t, SERIALIZE_TYPE_INT64)
+    BIN_WRITER_TYPE_CODE(int32_t, SERIALIZE_TYPE_INT32)
+    BIN_WRITER_TYPE_CODE(int16_t, SERIALIZE_TYPE_INT16)
+    BIN_WRITER_TYPE_CODE(int8_t, SERIALIZE_TYPE_INT8)
+    BIN_WRITER_TYPE_CODE(uint64_t, SERIALIZE_TYPE_UINT64)
+    BIN_WRITER_TYPE_CODE(uint32_t, SERIALIZE_TYPE_UINT32)
+    BIN_WRITER_TYPE_CODE(uint16_t, SERIALIZE_TYPE_UINT16)
+    BIN_WRITER_TYPE_CODE(uint8_t, SERIALIZE_TYPE_UINT8)
+    BIN_WRITER_TYPE_CODE(double, SERIALIZE_TYPE_DUOBLE)
+    BIN_WRITER_TYPE_CODE(bool, SERIALIZE_TYPE_BOOL)
+    BIN_WRITER_TYPE_CODE(std::string, SERIALIZE_TYPE_STRING)
+#undef BIN_WRITER_TYPE_CODE
+
+    /************************************************************************/
+    /* Writes binary portable storage blob directly to the output buffer.   */
+    /* Entries go out in serialization order, entry counts are written as   */
+    /* fixed size varints and patched when section or array is closed.     */
+    /************************************************************************/
+    class portable_storage_bin_writer
+    {
+    public:
+      struct frame
+      {
+        size_t m_count_offset;
+        size_t m_count;
+      };
+
+      typedef frame* hsection;
+      typedef frame* harray;
+      typedef storage_entry meta_entry;
+
+      portable_storage_bin_writer();
+
+      hsection   open_section(const std::string& section_name,  hsection hparent_section, bool create_if_notexist = false);
+      template<class t_value>
+      bool       set_value(const std::string& value_name, const t_value& target, hsection hparent_section);
+      bool       set_value(const std::string& value_name, const storage_entry& target, hsection hparent_section);
+
+      //serial access for arrays of values --------------------------------------
+      template<class t_value>
+      harray     insert_first_value(const std::string& value_name, const t_value& target, hsection hparent_section);
+      template<class t_value>
+      bool       insert_next_value(harray hval_array, const t_value& target);
+      harray     insert_first_section(const std::string& sec_name, hsection& hinserted_childsection, hsection hparent_section);
+      bool       insert_next_section(harray hsec_array, hsection& hinserted_childsection);
+
+      //finishes the blob and hands it out, writer can't be used after that
+      bool       store_to_binary(binarybuffer& target);
+
+      //stream interface for pack_varint/put_string/pack_entry_to_buff
+      void write(const char* data, size_t size) { m_buff.append(data, size); }
+
+    private:
+      frame* push_frame();
+      void close_frames_above(frame* pframe);
+      void begin_entry(const std::string& name, uint8_t type, hsection hparent_section);
+      template<class t_value>
+      void write_value(const t_value& v) { write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+      void write_value(const std::string& v) { put_string(*this, v); }
+
+      binarybuffer m_buff;
+      std::deque<frame> m_frames;
+    };
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    portable_storage_bin_writer::portable_storage_bin_writer()
+    {
+      uint32_t signature_a = PORTABLE_STORAGE_SIGNATUREA;
+      uint32_t signature_b = PORTABLE_STORAGE_SIGNATUREB;
+      uint8_t ver = PORTABLE_STORAGE_FORMAT_VER;
+      write(reinterpret_cast<const char*>(&signature_a), sizeof(signature_a));
+      write(reinterpret_cast<const char*>(&signature_b), sizeof(signature_b));
+      write(reinterpret_cast<const char*>(&ver), sizeof(ver));
+      push_frame();
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    portable_storage_bin_writer::frame* portable_storage_bin_writer::push_frame()
+    {
+      frame f;
+      f.m_count_offset = m_buff.size();
+      f.m_count = 0;
+      uint32_t placeholder = 0;
+      write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+      m_frames.push_back(f);
+      return &m_frames.back();
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    void portable_storage_bin_writer::close_frames_above(frame* pframe)
+    {
+      while(!m_frames.empty() && &m_frames.back() != pframe)
+      {
+        frame& f = m_frames.back();
+        CHECK_AND_ASSERT_THROW_MES(f.m_count <= 1073741823, "failed to pack varint - too big amount = " << f.m_count);
+        uint32_t v = (static_cast<uint32_t>(f.m_count) << 2) | PORTABLE_RAW_SIZE_MARK_DWORD;
+        memcpy(&m_buff[f.m_count_offset], &v, sizeof(v));
+        m_frames.pop_back();
+      }
+      CHECK_AND_ASSERT_THROW_MES(pframe == nullptr || !m_frames.empty(), "portable_storage_bin_writer: section or array handle is already closed");
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    void portable_storage_bin_writer::begin_entry(const std::string& name, uint8_t type, hsection hparent_section)
+    {
+      CHECK_AND_ASSERT_THROW_MES(!m_frames.empty(), "portable_storage_bin_writer: blob is already stored");
+      if(!hparent_section) hparent_section = &m_frames.front();
+      close_frames_above(hparent_section);
+      CHECK_AND_ASSERT_THROW_MES(name.size() < std::numeric_limits<uint8_t>::max(), "storage_entry_name is too long: " << name.size() << ", val: " << name);
+      ++hparent_section->m_count;
+      uint8_t len = static_cast<uint8_t>(name.size());
+      write(reinterpret_cast<const char*>(&len), sizeof(len));
+      write(name.data(), name.size());
+      write(reinterpret_cast<const char*>(&type), sizeof(type));
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    portable_storage_bin_writer::hsection portable_storage_bin_writer::open_section(const std::string& section_name, hsection hparent_section, bool create_if_notexist)
+    {
+      TRY_ENTRY();
+      begin_entry(section_name, SERIALIZE_TYPE_OBJECT, hparent_section);
+      return push_frame();
+      CATCH_ENTRY("portable_storage_bin_writer::open_section", nullptr);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    bool portable_storage_bin_writer::set_value(const std::string& value_name, const t_value& v, hsection hparent_section)
+    {
+      TRY_ENTRY();
+      begin_entry(value_name, bin_writer_type_code<t_value>::value, hparent_section);
+      write_value(v);
+      return true;
+      CATCH_ENTRY("portable_storage_bin_writer::set_value", false);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    bool portable_storage_bin_writer::set_value(const std::string& value_name, const storage_entry& v, hsection hparent_section)
+    {
+      TRY_ENTRY();
+      CHECK_AND_ASSERT_THROW_MES(!m_frames.empty(), "portable_storage_bin_writer: blob is already stored");
+      if(!hparent_section) hparent_section = &m_frames.front();
+      close_frames_above(hparent_section);
+      CHECK_AND_ASSERT_THROW_MES(value_name.size() < std::numeric_limits<uint8_t>::max(), "storage_entry_name is too long: " << value_name.size() << ", val: " << value_name);
+      ++hparent_section->m_count;
+      uint8_t len = static_cast<uint8_t>(value_name.size());
+      write(reinterpret_cast<const char*>(&len), sizeof(len));
+      write(value_name.data(), value_name.size());
+      //visitor writes type code itself
+      return pack_entry_to_buff(*this, v);
+      CATCH_ENTRY("portable_storage_bin_writer::set_value", false);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    portable_storage_bin_writer::harray portable_storage_bin_writer::insert_first_value(const std::string& value_name, const t_value& target, hsection hparent_section)
+    {
+      TRY_ENTRY();
+      begin_entry(value_name, bin_writer_type_code<t_value>::value | SERIALIZE_FLAG_ARRAY, hparent_section);
+      harray hval_array = push_frame();
+      ++hval_array->m_count;
+      write_value(target);
+      return hval_array;
+      CATCH_ENTRY("portable_storage_bin_writer::insert_first_value", nullptr);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    template<class t_value>
+    bool portable_storage_bin_writer::insert_next_value(harray hval_array, const t_value& target)
+    {
+      TRY_ENTRY();
+      CHECK_AND_ASSERT(hval_array, false);
+      close_frames_above(hval_array);
+      ++hval_array->m_count;
+      write_value(target);
+      return true;
+      CATCH_ENTRY("portable_storage_bin_writer::insert_next_value", false);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    portable_storage_bin_writer::harray portable_storage_bin_writer::insert_first_section(const std::string& sec_name, hsection& hinserted_childsection, hsection hparent_section)
+    {
+      TRY_ENTRY();
+      begin_entry(sec_name, SERIALIZE_TYPE_OBJECT | SERIALIZE_FLAG_ARRAY, hparent_section);
+      harray hsec_array = push_frame();
+      ++hsec_array->m_count;
+      hinserted_childsection = push_frame();
+      return hsec_array;
+      CATCH_ENTRY("portable_storage_bin_writer::insert_first_section", nullptr);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    bool portable_storage_bin_writer::insert_next_section(harray hsec_array, hsection& hinserted_childsection)
+    {
+      TRY_ENTRY();
+      CHECK_AND_ASSERT(hsec_array, false);
+      close_frames_above(hsec_array);
+      ++hsec_array->m_count;
+      hinserted_childsection = push_frame();
+      return true;
+      CATCH_ENTRY("portable_storage_bin_writer::insert_next_section", false);
+    }
+    //---------------------------------------------------------------------------------------------------------------
+    inline
+    bool portable_storage_bin_writer::store_to_binary(binarybuffer& target)
+    {
+      TRY_ENTRY();
+      CHECK_AND_ASSERT_MES(!m_frames.empty(), false, "portable_storage_bin_writer: blob is already stored");
+      close_frames_above(nullptr);
+      target.swap(m_buff);
+      m_buff.clear();
+      return true;
+      CATCH_ENTRY("portable_storage_bin_writer::store_to_binary", false);
+    }
+  }
+}
@@ -37,6 +37,14 @@ struct Transfer {
   int64_t amount;
 };
 
+struct TransactionParameters {
+  std::vector<Transfer> transfers;
+  uint64_t fee;
+  std::string extra;
+  uint64_t mixIn;
+  uint64_t unlockTimestamp;
+};
+
 const TransactionId INVALID_TRANSACTION_ID    = std::numeric_limits<TransactionId>::max();
 const TransferId INVALID_TRANSFER_ID          = std::numeric_limits<TransferId>::max();
 const uint64_t UNCONFIRMED_TRANSACTION_HEIGHT = std::numeric_limits<uint64_t>::max();
@@ -76,6 +84,10 @@ public:
   virtual void shutdown() = 0;
 
   virtual void save(std::ostream& destination, bool saveDetailed = true, bool saveCache = true) = 0;
+  //appends what changed since the last save or load to the end of the saved wallet
+  virtual void saveChanges(std::ostream& destination) = 0;
+  //true when a full save to a new file is due: the appended changes have outgrown the saved wallet or can't be appended at all
+  virtual bool needsCompaction() = 0;
 
   virtual std::error_code changePassword(const std::string& oldPassword, const std::string& newPassword) = 0;
 
@@ -94,6 +106,7 @@ public:
 
   virtual TransactionId sendTransaction(const Transfer& transfer, uint64_t fee, const std::string& extra = "", uint64_t mixIn = 0, uint64_t unlockTimestamp = 0) = 0;
   virtual TransactionId sendTransaction(const std::vector<Transfer>& transfers, uint64_t fee, const std::string& extra = "", uint64_t mixIn = 0, uint64_t unlockTimestamp = 0) = 0;
+  virtual std::vector<TransactionId> sendTransactions(const std::vector<TransactionParameters>& transactions) = 0;
   virtual std::error_code cancelTransaction(size_t transferId) = 0;
 };
 
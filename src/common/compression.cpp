@@ -0,0 +1,103 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "compression.h"
+
+#include <algorithm>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace tools
+{
+  namespace compression
+  {
+#ifdef HAVE_ZLIB
+    bool is_available()
+    {
+      return true;
+    }
+
+    bool compress(const std::string& data, std::string& compressed)
+    {
+      uLongf size = compressBound(static_cast<uLong>(data.size()));
+      compressed.resize(size);
+      int res = compress2(reinterpret_cast<Bytef*>(&compressed[0]), &size,
+        reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()), Z_BEST_SPEED);
+      if (Z_OK != res)
+      {
+        compressed.clear();
+        return false;
+      }
+
+      compressed.resize(size);
+      return true;
+    }
+
+    bool decompress(const std::string& compressed, size_t max_size, std::string& data)
+    {
+      z_stream stream = z_stream();
+      if (Z_OK != inflateInit(&stream))
+        return false;
+
+      stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+      stream.avail_in = static_cast<uInt>(compressed.size());
+
+      // One spare byte past max_size lets an oversized stream be detected
+      data.clear();
+      int res = Z_OK;
+      while (Z_OK == res && data.size() <= max_size)
+      {
+        size_t offset = data.size();
+        size_t chunk = std::max<size_t>(compressed.size() * 2, 4096);
+        chunk = std::min(chunk, max_size - offset + 1);
+        data.resize(offset + chunk);
+
+        stream.next_out = reinterpret_cast<Bytef*>(&data[offset]);
+        stream.avail_out = static_cast<uInt>(chunk);
+        res = inflate(&stream, Z_NO_FLUSH);
+        data.resize(offset + chunk - stream.avail_out);
+      }
+
+      inflateEnd(&stream);
+      if (Z_STREAM_END != res || data.size() > max_size)
+      {
+        data.clear();
+        return false;
+      }
+
+      return true;
+    }
+#else
+    bool is_available()
+    {
+      return false;
+    }
+
+    bool compress(const std::string& data, std::string& compressed)
+    {
+      return false;
+    }
+
+    bool decompress(const std::string& compressed, size_t max_size, std::string& data)
+    {
+      return false;
+    }
+#endif
+  }
+}
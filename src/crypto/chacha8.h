@@ -64,6 +64,11 @@ namespace crypto {
     memcpy(&key, &pwd_hash, sizeof(key));
     memset(&pwd_hash, 0, sizeof(pwd_hash));
   }
+
+  inline void generate_chacha8_key(std::string password, chacha8_key& key) {
+    pooled_cn_context context = acquire_cn_context();
+    generate_chacha8_key(*context, password, key);
+  }
 }
 
 #endif
@@ -16,6 +16,7 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "warnings.h"
@@ -1607,6 +1608,37 @@ void ge_tobytes(unsigned char *s, const ge_p2 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+/* Same as ge_tobytes for count points, sharing one field inversion between them.
+ * tmp must have room for count field elements. */
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, fe *tmp, size_t count) {
+  fe inv;
+  fe recip;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (count == 0) {
+    return;
+  }
+  fe_copy(tmp[0], h[0].Z);
+  for (i = 1; i < count; i++) {
+    fe_mul(tmp[i], tmp[i - 1], h[i].Z);
+  }
+  fe_invert(inv, tmp[count - 1]);
+  for (i = count - 1; i > 0; i--) {
+    fe_mul(recip, inv, tmp[i - 1]);
+    fe_mul(inv, inv, h[i].Z);
+    fe_mul(x, h[i].X, recip);
+    fe_mul(y, h[i].Y, recip);
+    fe_tobytes(s + 32 * i, y);
+    s[32 * i + 31] ^= fe_isnegative(x) << 7;
+  }
+  fe_mul(x, h[0].X, inv);
+  fe_mul(y, h[0].Y, inv);
+  fe_tobytes(s, y);
+  s[31] ^= fe_isnegative(x) << 7;
+}
+
 /* From sc_reduce.c */
 
 /*
@@ -1928,11 +1960,31 @@ static void ge_cached_cmov(ge_cached *t, const ge_cached *u, unsigned char b) {
   fe_cmov(t->T2d, u->T2d, b);
 }
 
+void ge_sm_precomp(ge_smp Ai, const ge_p3 *A) {
+  ge_p1p1 t;
+  ge_p3 u;
+  int i;
+
+  ge_p3_to_cached(&Ai[0], A);
+  for (i = 0; i < 7; i++) {
+    ge_add(&t, A, &Ai[i]);
+    ge_p1p1_to_p3(&u, &t);
+    ge_p3_to_cached(&Ai[i + 1], &u);
+  }
+}
+
 /* Assumes that a[31] <= 127 */
 void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
+  ge_smp Ai; /* 1 * A, 2 * A, ..., 8 * A */
+
+  ge_sm_precomp(Ai, A);
+  ge_scalarmult_precomp(r, a, Ai);
+}
+
+/* Assumes that a[31] <= 127 */
+void ge_scalarmult_precomp(ge_p2 *r, const unsigned char *a, const ge_smp Ai) {
   signed char e[64];
   int carry, carry2, i;
-  ge_cached Ai[8]; /* 1 * A, 2 * A, ..., 8 * A */
   ge_p1p1 t;
   ge_p3 u;
 
@@ -1949,13 +2001,6 @@ void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
   e[62] = carry - (carry2 << 4); /* -8..7 */
   e[63] = carry2; /* 0..8 */
 
-  ge_p3_to_cached(&Ai[0], A);
-  for (i = 0; i < 7; i++) {
-    ge_add(&t, A, &Ai[i]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[i + 1], &u);
-  }
-
   ge_p2_0(r);
   for (i = 63; i >= 0; i--) {
     signed char b = e[i];
@@ -2039,6 +2084,22 @@ void ge_mul8(ge_p1p1 *r, const ge_p2 *t) {
   ge_p2_dbl(r, &u);
 }
 
+/* Returns 1 if p and q are the same point, without converting either of them to bytes. */
+int ge_p2_p3_eq(const ge_p2 *p, const ge_p3 *q) {
+  fe l, r, d;
+
+  fe_mul(l, p->X, q->Z);
+  fe_mul(r, q->X, p->Z);
+  fe_sub(d, l, r);
+  if (fe_isnonzero(d)) {
+    return 0;
+  }
+  fe_mul(l, p->Y, q->Z);
+  fe_mul(r, q->Y, p->Z);
+  fe_sub(d, l, r);
+  return !fe_isnonzero(d);
+}
+
 void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   fe u, v, w, x, y, z;
   unsigned char sign;
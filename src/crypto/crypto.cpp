@@ -16,13 +16,13 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <alloca.h>
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
-#include <mutex>
 
 #include "common/varint.h"
 #include "warnings.h"
@@ -34,8 +34,6 @@ namespace crypto {
   using std::abort;
   using std::int32_t;
   using std::int64_t;
-  using std::lock_guard;
-  using std::mutex;
   using std::size_t;
   using std::uint32_t;
   using std::uint64_t;
@@ -45,8 +43,6 @@ namespace crypto {
 #include "random.h"
   }
 
-  mutex random_lock;
-
   static inline unsigned char *operator &(ec_point &point) {
     return &reinterpret_cast<unsigned char &>(point);
   }
@@ -76,7 +72,6 @@ namespace crypto {
   }
 
   void crypto_ops::generate_keys(public_key &pub, secret_key &sec) {
-    lock_guard<mutex> lock(random_lock);
     ge_p3 point;
     random_scalar(sec);
     ge_scalarmult_base(&point, &sec);
@@ -113,6 +108,39 @@ namespace crypto {
     return true;
   }
 
+  void crypto_ops::generate_key_derivations(const public_key *keys1, size_t count, const secret_key &key2,
+    key_derivation *derivations, bool *valid) {
+    std::vector<ge_p2> points;
+    std::vector<size_t> indices;
+    points.reserve(count);
+    indices.reserve(count);
+    assert(sc_check(&key2) == 0);
+    for (size_t i = 0; i < count; ++i) {
+      ge_p3 point;
+      ge_p2 point2;
+      ge_p1p1 point3;
+      valid[i] = ge_frombytes_vartime(&point, &keys1[i]) == 0;
+      if (!valid[i]) {
+        continue;
+      }
+      ge_scalarmult(&point2, &key2, &point);
+      ge_mul8(&point3, &point2);
+      ge_p1p1_to_p2(&point2, &point3);
+      points.push_back(point2);
+      indices.push_back(i);
+    }
+    if (points.empty()) {
+      return;
+    }
+
+    std::vector<key_derivation> encoded(points.size());
+    std::unique_ptr<fe[]> tmp(new fe[points.size()]);
+    ge_tobytes_batch(&encoded[0], points.data(), tmp.get(), points.size());
+    for (size_t j = 0; j < indices.size(); ++j) {
+      derivations[indices[j]] = encoded[j];
+    }
+  }
+
   static void derivation_to_scalar(const key_derivation &derivation, size_t output_index, ec_scalar &res) {
     struct {
       key_derivation derivation;
@@ -145,6 +173,74 @@ namespace crypto {
     return true;
   }
 
+  bool crypto_ops::scan_outputs(const public_key &tx_key, const secret_key *view_keys, const public_key *spend_keys,
+    size_t keys_count, const public_key *outs, const size_t *out_indices, size_t outs_count, bool *matches) {
+    ge_p3 tx_point;
+    ge_smp tx_precomp;
+    std::fill(matches, matches + keys_count * outs_count, false);
+    if (keys_count == 0 || outs_count == 0) {
+      return true;
+    }
+    if (ge_frombytes_vartime(&tx_point, &tx_key) != 0) {
+      return false;
+    }
+    ge_sm_precomp(tx_precomp, &tx_point);
+
+    // An output key that is not a valid point can't be equal to any derived key
+    std::vector<ge_p3> out_points(outs_count);
+    std::vector<char> out_valid(outs_count);
+    bool any_valid = false;
+    for (size_t j = 0; j < outs_count; ++j) {
+      out_valid[j] = ge_frombytes_vartime(&out_points[j], &outs[j]) == 0;
+      any_valid = any_valid || out_valid[j];
+    }
+    if (!any_valid) {
+      return true;
+    }
+
+    std::vector<ge_p2> points(keys_count);
+    std::vector<key_derivation> derivations(keys_count);
+    std::unique_ptr<fe[]> tmp(new fe[keys_count]);
+    for (size_t i = 0; i < keys_count; ++i) {
+      ge_p2 point;
+      ge_p1p1 point2;
+      assert(sc_check(&view_keys[i]) == 0);
+      ge_scalarmult_precomp(&point, &view_keys[i], tx_precomp);
+      ge_mul8(&point2, &point);
+      ge_p1p1_to_p2(&points[i], &point2);
+    }
+    ge_tobytes_batch(&derivations[0], points.data(), tmp.get(), keys_count);
+
+    for (size_t i = 0; i < keys_count; ++i) {
+      ge_p3 spend_point;
+      ge_cached spend_cached;
+      if (ge_frombytes_vartime(&spend_point, &spend_keys[i]) != 0) {
+        continue;
+      }
+      ge_p3_to_cached(&spend_cached, &spend_point);
+      for (size_t j = 0; j < outs_count; ++j) {
+        if (!out_valid[j]) {
+          continue;
+        }
+        ec_scalar scalar;
+        ge_p3 point;
+        ge_p1p1 point2;
+        ge_p2 point3;
+        derivation_to_scalar(derivations[i], out_indices[j], scalar);
+        ge_scalarmult_base(&point, &scalar);
+        ge_add(&point2, &point, &spend_cached);
+        ge_p1p1_to_p2(&point3, &point2);
+        if (ge_p2_p3_eq(&point3, &out_points[j])) {
+          // Confirm on the encoding, as derive_public_key callers compare bytes
+          public_key derived_key;
+          ge_tobytes(&derived_key, &point3);
+          matches[i * outs_count + j] = derived_key == outs[j];
+        }
+      }
+    }
+    return true;
+  }
+
   void crypto_ops::derive_secret_key(const key_derivation &derivation, size_t output_index,
     const secret_key &base, secret_key &derived_key) {
     ec_scalar scalar;
@@ -160,7 +256,6 @@ namespace crypto {
   };
 
   void crypto_ops::generate_signature(const hash &prefix_hash, const public_key &pub, const secret_key &sec, signature &sig) {
-    lock_guard<mutex> lock(random_lock);
     ge_p3 tmp3;
     ec_scalar k;
     s_comm buf;
@@ -204,6 +299,40 @@ namespace crypto {
     return sc_isnonzero(&c) == 0;
   }
 
+  bool crypto_ops::check_multisignature(const hash &prefix_hash, const public_key *pubs, size_t pubs_count,
+    const signature *sigs, size_t sigs_count) {
+    size_t i, j;
+    s_comm buf;
+    // a malformed signature fails for every key, reject it before any point arithmetic
+    for (i = 0; i < sigs_count; i++) {
+      if (sc_check(&sigs[i].c) != 0 || sc_check(&sigs[i].r) != 0) {
+        return false;
+      }
+    }
+    buf.h = prefix_hash;
+    for (i = 0, j = 0; i < sigs_count; j++) {
+      ge_p2 tmp2;
+      ge_p3 tmp3;
+      ec_scalar c;
+      // stop as soon as the remaining keys are too few for the remaining signatures
+      if (pubs_count - j < sigs_count - i) {
+        return false;
+      }
+      if (ge_frombytes_vartime(&tmp3, &pubs[j]) != 0) {
+        continue;
+      }
+      buf.key = pubs[j];
+      ge_double_scalarmult_base_vartime(&tmp2, &sigs[i].c, &tmp3, &sigs[i].r);
+      ge_tobytes(&buf.comm, &tmp2);
+      hash_to_scalar(&buf, sizeof(s_comm), c);
+      sc_sub(&c, &c, &sigs[i].c);
+      if (sc_isnonzero(&c) == 0) {
+        i++;
+      }
+    }
+    return true;
+  }
+
   static void hash_to_ec(const public_key &key, ge_p3 &res) {
     hash h;
     ge_p2 point;
@@ -241,7 +370,6 @@ POP_WARNINGS
     const public_key *const *pubs, size_t pubs_count,
     const secret_key &sec, size_t sec_index,
     signature *sig) {
-    lock_guard<mutex> lock(random_lock);
     size_t i;
     ge_p3 image_unp;
     ge_dsmp image_pre;
@@ -18,7 +18,6 @@
 #pragma once
 
 #include <cstddef>
-#include <mutex>
 #include <vector>
 
 #include "common/pod-class.h"
@@ -31,8 +30,6 @@ namespace crypto {
 #include "random.h"
   }
 
-  extern std::mutex random_lock;
-
 #pragma pack(push, 1)
   POD_CLASS ec_point {
     char data[32];
@@ -83,14 +80,22 @@ namespace crypto {
     friend bool secret_key_to_public_key(const secret_key &, public_key &);
     static bool generate_key_derivation(const public_key &, const secret_key &, key_derivation &);
     friend bool generate_key_derivation(const public_key &, const secret_key &, key_derivation &);
+    static void generate_key_derivations(const public_key *, std::size_t, const secret_key &, key_derivation *, bool *);
+    friend void generate_key_derivations(const public_key *, std::size_t, const secret_key &, key_derivation *, bool *);
     static bool derive_public_key(const key_derivation &, std::size_t, const public_key &, public_key &);
     friend bool derive_public_key(const key_derivation &, std::size_t, const public_key &, public_key &);
+    static bool scan_outputs(const public_key &, const secret_key *, const public_key *, std::size_t,
+      const public_key *, const std::size_t *, std::size_t, bool *);
+    friend bool scan_outputs(const public_key &, const secret_key *, const public_key *, std::size_t,
+      const public_key *, const std::size_t *, std::size_t, bool *);
     static void derive_secret_key(const key_derivation &, std::size_t, const secret_key &, secret_key &);
     friend void derive_secret_key(const key_derivation &, std::size_t, const secret_key &, secret_key &);
     static void generate_signature(const hash &, const public_key &, const secret_key &, signature &);
     friend void generate_signature(const hash &, const public_key &, const secret_key &, signature &);
     static bool check_signature(const hash &, const public_key &, const signature &);
     friend bool check_signature(const hash &, const public_key &, const signature &);
+    static bool check_multisignature(const hash &, const public_key *, std::size_t, const signature *, std::size_t);
+    friend bool check_multisignature(const hash &, const public_key *, std::size_t, const signature *, std::size_t);
     static void generate_key_image(const public_key &, const secret_key &, key_image &);
     friend void generate_key_image(const public_key &, const secret_key &, key_image &);
     static void generate_ring_signature(const hash &, const key_image &,
@@ -108,7 +113,6 @@ namespace crypto {
   template<typename T>
   typename std::enable_if<std::is_pod<T>::value, T>::type rand() {
     typename std::remove_cv<T>::type res;
-    std::lock_guard<std::mutex> lock(random_lock);
     generate_random_bytes(sizeof(T), &res);
     return res;
   }
@@ -140,6 +144,15 @@ namespace crypto {
   inline bool generate_key_derivation(const public_key &key1, const secret_key &key2, key_derivation &derivation) {
     return crypto_ops::generate_key_derivation(key1, key2, derivation);
   }
+
+  /* Derivations of count keys with the same secret key, e.g. the view key and the transactions of a block portion.
+   * They share one field inversion. valid[i] tells whether keys1[i] is a point, as generate_key_derivation returns.
+   */
+  inline void generate_key_derivations(const public_key *keys1, std::size_t count, const secret_key &key2,
+    key_derivation *derivations, bool *valid) {
+    crypto_ops::generate_key_derivations(keys1, count, key2, derivations, valid);
+  }
+
   inline bool derive_public_key(const key_derivation &derivation, std::size_t output_index,
     const public_key &base, public_key &derived_key) {
     return crypto_ops::derive_public_key(derivation, output_index, base, derived_key);
@@ -149,6 +162,17 @@ namespace crypto {
     crypto_ops::derive_secret_key(derivation, output_index, base, derived_key);
   }
 
+  /* Batched generate_key_derivation and derive_public_key for checking one transaction against many accounts.
+   * Sets matches[i * outs_count + j] if outs[j] is the key derived for output index out_indices[j] and
+   * account (view_keys[i], spend_keys[i]). The transaction key and the output keys are decompressed once,
+   * and all the derivations share a single field inversion.
+   * Returns false if the transaction key is not a valid point.
+   */
+  inline bool scan_outputs(const public_key &tx_key, const secret_key *view_keys, const public_key *spend_keys,
+    std::size_t keys_count, const public_key *outs, const std::size_t *out_indices, std::size_t outs_count, bool *matches) {
+    return crypto_ops::scan_outputs(tx_key, view_keys, spend_keys, keys_count, outs, out_indices, outs_count, matches);
+  }
+
   /* Generation and checking of a standard signature.
    */
   inline void generate_signature(const hash &prefix_hash, const public_key &pub, const secret_key &sec, signature &sig) {
@@ -158,6 +182,14 @@ namespace crypto {
     return crypto_ops::check_signature(prefix_hash, pub, sig);
   }
 
+  /* Checking of the signatures of a multisignature input: every signature has to be valid for one of the keys,
+   * the signatures follow the order of the keys, keys without a signature are skipped.
+   */
+  inline bool check_multisignature(const hash &prefix_hash, const public_key *pubs, std::size_t pubs_count,
+    const signature *sigs, std::size_t sigs_count) {
+    return crypto_ops::check_multisignature(prefix_hash, pubs, pubs_count, sigs, sigs_count);
+  }
+
   /* To send money to a key:
    * * The sender generates an ephemeral key and includes it in transaction output.
    * * To spend the money, the receiver generates a key image from it.
@@ -63,12 +63,21 @@ void hash_process(union hash_state *state, const uint8_t *buf, size_t count);
 enum {
   HASH_SIZE = 32,
   HASH_DATA_AREA = 136,
-  SLOW_HASH_CONTEXT_SIZE = 2097552
+  SLOW_HASH_CONTEXT_SIZE = 2097552,
+  SLOW_HASH_MAX_LANES = 4,
+  SLOW_HASH_DEFAULT_LANES = 2
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
+// hashes count independent messages, several at once where the cpu has avx2 or avx-512;
+// hashes[i] may overwrite data[j] for j <= i
+void cn_fast_hash_multi(const void *const *data, const size_t *lengths, char (*hashes)[HASH_SIZE], size_t count);
 
 void cn_slow_hash_f(void *, const void *, size_t, void *);
+// hashes count independent inputs, interleaving them when the cpu allows it; every input needs its own context
+void cn_slow_hash_multi_f(void *const *contexts, const void *const *data, const size_t *lengths, void *const *hashes, size_t count);
+// number of inputs cn_slow_hash_multi_f should be given at once to run at full speed
+size_t cn_slow_hash_lanes_f(void);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
 void hash_extra_groestl(const void *data, size_t length, char *hash);
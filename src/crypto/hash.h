@@ -19,6 +19,8 @@
 
 #include <stddef.h>
 
+#include <memory>
+
 #include "common/pod-class.h"
 #include "generic-ops.h"
 
@@ -50,26 +52,82 @@ namespace crypto {
     return h;
   }
 
+  inline void cn_fast_hash_multi(const void *const *data, const std::size_t *lengths, hash *hashes, std::size_t count) {
+    cn_fast_hash_multi(data, lengths, reinterpret_cast<char (*)[HASH_SIZE]>(hashes), count);
+  }
+
   class cn_context {
   public:
 
+    enum page_mode {
+      normal_pages,
+      // 2 MB pages keep the random scratchpad accesses inside a single tlb entry,
+      // falls back to normal pages when the system has none to give
+      large_pages
+    };
+
     cn_context();
+    // local_node places the scratchpad on the numa node of the calling thread
+    cn_context(page_mode mode, bool local_node);
     ~cn_context();
 #if !defined(_MSC_VER) || _MSC_VER >= 1800
     cn_context(const cn_context &) = delete;
     void operator=(const cn_context &) = delete;
 #endif
 
+    bool has_large_pages() const {
+      return large;
+    }
+
   private:
 
+    void init(page_mode mode, bool local_node);
+
     void *data;
+    std::size_t size;
+    bool large;
     friend inline void cn_slow_hash(cn_context &, const void *, std::size_t, hash &);
+    friend inline void cn_slow_hash_multi(cn_context *const *, const void *const *, const std::size_t *, hash *, std::size_t);
+    friend struct cn_context_release;
   };
 
+  struct cn_context_release {
+    void operator()(cn_context *context) const;
+  };
+
+  // a context borrowed from a process wide pool and given back to it on release, for occasional
+  // slow hashes that should not map and populate a fresh scratchpad every time. The scratchpad is
+  // zeroed on release, the hashes are of passwords and what they leave behind would give their keys away
+  typedef std::unique_ptr<cn_context, cn_context_release> pooled_cn_context;
+  pooled_cn_context acquire_cn_context();
+
   inline void cn_slow_hash(cn_context &context, const void *data, std::size_t length, hash &hash) {
     (*cn_slow_hash_f)(context.data, data, length, reinterpret_cast<void *>(&hash));
   }
 
+  inline std::size_t cn_slow_hash_lanes() {
+    return cn_slow_hash_lanes_f();
+  }
+
+  // hashes count inputs, each one with its own context, interleaving them when the cpu allows it
+  inline void cn_slow_hash_multi(cn_context *const *contexts, const void *const *data, const std::size_t *lengths, hash *hashes, std::size_t count) {
+    void *contextData[SLOW_HASH_MAX_LANES];
+    void *hashData[SLOW_HASH_MAX_LANES];
+    while (count > 0) {
+      std::size_t n = count < SLOW_HASH_MAX_LANES ? count : static_cast<std::size_t>(SLOW_HASH_MAX_LANES);
+      for (std::size_t i = 0; i < n; ++i) {
+        contextData[i] = contexts[i]->data;
+        hashData[i] = &hashes[i];
+      }
+      cn_slow_hash_multi_f(contextData, data, lengths, hashData, n);
+      contexts += n;
+      data += n;
+      lengths += n;
+      hashes += n;
+      count -= n;
+    }
+  }
+
   inline void tree_hash(const hash *hashes, std::size_t count, hash &root_hash) {
     tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
   }
@@ -0,0 +1,152 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include "hash-ops.h"
+#include "initializer.h"
+#include "keccak.h"
+
+#if defined(_MSC_VER)
+#define ALIGNED_DECL(t, x) __declspec(align(x)) t
+#define TARGET(x)
+#else
+#define ALIGNED_DECL(t, x) t __attribute__((aligned(x)))
+#define TARGET(x) __attribute__((target(x)))
+#endif
+
+extern const uint64_t keccakf_rndc[24];
+extern const int keccakf_rotc[24];
+extern const int keccakf_piln[24];
+
+static void (*cn_fast_hash_x4_fp)(const void *const *, const size_t *, char (*)[HASH_SIZE]);
+static void (*cn_fast_hash_x8_fp)(const void *const *, const size_t *, char (*)[HASH_SIZE]);
+
+#define KECCAK_LANES 4
+#define KECCAK_TARGET TARGET("avx2")
+#define KECCAK_FN(name) name##_avx2
+#define vec_t __m256i
+#define V_ZERO() _mm256_setzero_si256()
+#define V_SET1(x) _mm256_set1_epi64x((long long) (x))
+#define V_LOAD(p) _mm256_load_si256((const __m256i *) (p))
+#define V_STORE(p, v) _mm256_store_si256((__m256i *) (p), (v))
+#define V_XOR(a, b) _mm256_xor_si256((a), (b))
+#define V_ANDNOT(a, b) _mm256_andnot_si256((a), (b))
+#define V_ROL(x, n) _mm256_or_si256(_mm256_slli_epi64((x), (n)), _mm256_srli_epi64((x), 64 - (n)))
+#include "keccak-multi.inl"
+#undef KECCAK_LANES
+#undef KECCAK_TARGET
+#undef KECCAK_FN
+#undef vec_t
+#undef V_ZERO
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_XOR
+#undef V_ANDNOT
+#undef V_ROL
+
+#define KECCAK_LANES 8
+#define KECCAK_TARGET TARGET("avx512f")
+#define KECCAK_FN(name) name##_avx512
+#define vec_t __m512i
+#define V_ZERO() _mm512_setzero_si512()
+#define V_SET1(x) _mm512_set1_epi64((long long) (x))
+#define V_LOAD(p) _mm512_load_si512((const void *) (p))
+#define V_STORE(p, v) _mm512_store_si512((void *) (p), (v))
+#define V_XOR(a, b) _mm512_xor_si512((a), (b))
+#define V_ANDNOT(a, b) _mm512_andnot_si512((a), (b))
+#define V_ROL(x, n) _mm512_rolv_epi64((x), _mm512_set1_epi64(n))
+#include "keccak-multi.inl"
+
+void cn_fast_hash_multi(const void *const *data, const size_t *lengths, char (*hashes)[HASH_SIZE], size_t count) {
+  size_t i;
+  if (cn_fast_hash_x8_fp != NULL) {
+    for (; count >= 8; data += 8, lengths += 8, hashes += 8, count -= 8) {
+      (*cn_fast_hash_x8_fp)(data, lengths, hashes);
+    }
+  }
+
+  if (cn_fast_hash_x4_fp != NULL) {
+    for (; count >= 4; data += 4, lengths += 4, hashes += 4, count -= 4) {
+      (*cn_fast_hash_x4_fp)(data, lengths, hashes);
+    }
+  }
+
+  for (i = 0; i < count; i++) {
+    cn_fast_hash(data[i], lengths[i], hashes[i]);
+  }
+}
+
+static void cpuid_count(int leaf, int subleaf, int regs[4]) {
+#if defined(_MSC_VER)
+  __cpuidex(regs, leaf, subleaf);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t xgetbv0(void) {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t lo, hi;
+  __asm__ __volatile__("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+  return ((uint64_t) hi << 32) | lo;
+#endif
+}
+
+INITIALIZER(detect_simd) {
+  int regs[4];
+  uint64_t xcr0;
+
+  cn_fast_hash_x4_fp = NULL;
+  cn_fast_hash_x8_fp = NULL;
+
+  cpuid_count(0, 0, regs);
+  if (regs[0] < 7) {
+    return;
+  }
+
+  // the os has to save the ymm/zmm registers too, not only the cpu support them
+  cpuid_count(1, 0, regs);
+  if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0) {
+    return;
+  }
+  xcr0 = xgetbv0();
+  if ((xcr0 & 0x6) != 0x6) {
+    return;
+  }
+
+  cpuid_count(7, 0, regs);
+  if (regs[1] & (1 << 5)) {
+    cn_fast_hash_x4_fp = &cn_fast_hash_avx2;
+  }
+  if ((regs[1] & (1 << 16)) && (xcr0 & 0xe6) == 0xe6) {
+    cn_fast_hash_x8_fp = &cn_fast_hash_avx512;
+  }
+}
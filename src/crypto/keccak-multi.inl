@@ -0,0 +1,119 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+// Keccak-f[1600] over KECCAK_LANES independent states, one state word of every lane per vector.
+// Expects vec_t, KECCAK_TARGET and the V_* operations to be defined by the includer.
+
+static void KECCAK_TARGET KECCAK_FN(keccakf)(vec_t st[25])
+{
+  int i, j, round;
+  vec_t t, bc[5];
+
+  for (round = 0; round < KECCAK_ROUNDS; round++) {
+
+    // Theta
+    for (i = 0; i < 5; i++)
+      bc[i] = V_XOR(V_XOR(V_XOR(V_XOR(st[i], st[i + 5]), st[i + 10]), st[i + 15]), st[i + 20]);
+
+    for (i = 0; i < 5; i++) {
+      t = V_XOR(bc[(i + 4) % 5], V_ROL(bc[(i + 1) % 5], 1));
+      for (j = 0; j < 25; j += 5)
+        st[j + i] = V_XOR(st[j + i], t);
+    }
+
+    // Rho Pi
+    t = st[1];
+    for (i = 0; i < 24; i++) {
+      j = keccakf_piln[i];
+      bc[0] = st[j];
+      st[j] = V_ROL(t, keccakf_rotc[i]);
+      t = bc[0];
+    }
+
+    //  Chi
+    for (j = 0; j < 25; j += 5) {
+      for (i = 0; i < 5; i++)
+        bc[i] = st[j + i];
+      for (i = 0; i < 5; i++)
+        st[j + i] = V_XOR(st[j + i], V_ANDNOT(bc[(i + 1) % 5], bc[(i + 2) % 5]));
+    }
+
+    //  Iota
+    st[0] = V_XOR(st[0], V_SET1(keccakf_rndc[round]));
+  }
+}
+
+// cn_fast_hash of KECCAK_LANES messages. The lanes absorb in lock-step, a lane that runs out of
+// blocks keeps being permuted but its digest was already taken after its last block.
+static void KECCAK_TARGET KECCAK_FN(cn_fast_hash)(const void *const *data, const size_t *lengths, char (*hashes)[HASH_SIZE])
+{
+  vec_t st[25];
+  ALIGNED_DECL(uint64_t words[HASH_DATA_AREA / 8][KECCAK_LANES], 64);
+  ALIGNED_DECL(uint64_t digest[HASH_SIZE / 8][KECCAK_LANES], 64);
+  char out[KECCAK_LANES][HASH_SIZE];
+  size_t blocks[KECCAK_LANES];
+  size_t maxBlocks = 0;
+  size_t b, i, l;
+
+  for (l = 0; l < KECCAK_LANES; l++) {
+    blocks[l] = lengths[l] / HASH_DATA_AREA + 1;
+    if (blocks[l] > maxBlocks)
+      maxBlocks = blocks[l];
+  }
+
+  for (i = 0; i < 25; i++)
+    st[i] = V_ZERO();
+
+  for (b = 0; b < maxBlocks; b++) {
+    for (l = 0; l < KECCAK_LANES; l++) {
+      uint8_t temp[HASH_DATA_AREA];
+      if (b + 1 < blocks[l]) {
+        memcpy(temp, (const uint8_t *) data[l] + b * HASH_DATA_AREA, HASH_DATA_AREA);
+      } else if (b + 1 == blocks[l]) {
+        // last block and padding
+        size_t tail = lengths[l] - b * HASH_DATA_AREA;
+        memcpy(temp, (const uint8_t *) data[l] + b * HASH_DATA_AREA, tail);
+        temp[tail++] = 1;
+        memset(temp + tail, 0, HASH_DATA_AREA - tail);
+        temp[HASH_DATA_AREA - 1] |= 0x80;
+      } else {
+        memset(temp, 0, HASH_DATA_AREA);
+      }
+
+      for (i = 0; i < HASH_DATA_AREA / 8; i++)
+        memcpy(&words[i][l], temp + i * 8, 8);
+    }
+
+    for (i = 0; i < HASH_DATA_AREA / 8; i++)
+      st[i] = V_XOR(st[i], V_LOAD(words[i]));
+
+    KECCAK_FN(keccakf)(st);
+
+    for (i = 0; i < HASH_SIZE / 8; i++)
+      V_STORE(digest[i], st[i]);
+
+    for (l = 0; l < KECCAK_LANES; l++) {
+      if (b + 1 == blocks[l]) {
+        for (i = 0; i < HASH_SIZE / 8; i++)
+          memcpy(out[l] + i * 8, &digest[i][l], 8);
+      }
+    }
+  }
+
+  // written only now, so a hash may overwrite the message of its own lane
+  memcpy(hashes, out, sizeof(out));
+}
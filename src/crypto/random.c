@@ -77,49 +77,49 @@ static void generate_system_random_bytes(size_t n, void *result) {
 
 #endif
 
-static union hash_state state;
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+/* Every thread permutes its own state, seeded from the system source on first use, so no locking is needed. */
+static THREAD_LOCAL union hash_state state;
+static THREAD_LOCAL int seeded;
 
-#if !defined(NDEBUG)
-static volatile int curstate; /* To catch thread safety problems. */
+#if !defined(_WIN32)
+#include <pthread.h>
+
+/* The child of a fork would otherwise repeat the output of its parent. */
+static void reseed_after_fork(void) {
+  seeded = 0;
+}
 #endif
 
 FINALIZER(deinit_random) {
-#if !defined(NDEBUG)
-  assert(curstate == 1);
-  curstate = 0;
-#endif
   memset(&state, 0, sizeof(union hash_state));
+  seeded = 0;
 }
 
 INITIALIZER(init_random) {
-  generate_system_random_bytes(32, &state);
-  REGISTER_FINALIZER(deinit_random);
-#if !defined(NDEBUG)
-  assert(curstate == 0);
-  curstate = 1;
+#if !defined(_WIN32)
+  pthread_atfork(NULL, NULL, reseed_after_fork);
 #endif
+  REGISTER_FINALIZER(deinit_random);
 }
 
 void generate_random_bytes(size_t n, void *result) {
-#if !defined(NDEBUG)
-  assert(curstate == 1);
-  curstate = 2;
-#endif
+  if (!seeded) {
+    generate_system_random_bytes(32, &state);
+    seeded = 1;
+  }
   if (n == 0) {
-#if !defined(NDEBUG)
-    assert(curstate == 2);
-    curstate = 1;
-#endif
     return;
   }
   for (;;) {
     hash_permutation(&state);
     if (n <= HASH_DATA_AREA) {
       memcpy(result, &state, n);
-#if !defined(NDEBUG)
-      assert(curstate == 2);
-      curstate = 1;
-#endif
       return;
     } else {
       memcpy(result, &state, HASH_DATA_AREA);
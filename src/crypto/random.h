@@ -19,4 +19,5 @@
 
 #include <stddef.h>
 
+/* Thread safe, every thread draws from its own generator. */
 void generate_random_bytes(size_t n, void *result);
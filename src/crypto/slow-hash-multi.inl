@@ -0,0 +1,169 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+// Interleaves LANES independent hashes so that the latency of aesenc, the
+// 64-bit multiply and the scratchpad loads of one lane overlaps the others.
+// Every lane works on its own context, so the per-lane state stays the same
+// as in cn_slow_hash_aesni.
+
+static void
+#if LANES == 2
+cn_slow_hash_aesni_x2
+#elif LANES == 4
+cn_slow_hash_aesni_x4
+#endif
+(void *const *contexts, const void *const *data, const size_t *lengths, void *const *hashes)
+{
+  struct cn_ctx *lane[LANES];
+  ALIGNED_DECL(uint8_t ExpandedKey[LANES][256], 16);
+  __m128i *longoutput[LANES], *expkey[LANES], *xmminput[LANES], b_x[LANES];
+  ALIGNED_DECL(uint64_t a[LANES][2], 16);
+  size_t i, j, l;
+
+  for (l = 0; l < LANES; l++)
+  {
+    lane[l] = (struct cn_ctx *) contexts[l];
+    hash_process(&lane[l]->state.hs, (const uint8_t*) data[l], lengths[l]);
+    memcpy(lane[l]->text, lane[l]->state.init, INIT_SIZE_BYTE);
+    memcpy(ExpandedKey[l], lane[l]->state.hs.b, AES_KEY_SIZE);
+    ExpandAESKey256(ExpandedKey[l]);
+
+    longoutput[l] = (__m128i *) lane[l]->long_state;
+    expkey[l] = (__m128i *) ExpandedKey[l];
+    xmminput[l] = (__m128i *) lane[l]->text;
+  }
+
+  for (i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE)
+  {
+    for (j = 0; j < 10; j++)
+    {
+      for (l = 0; l < LANES; l++)
+      {
+        xmminput[l][0] = _mm_aesenc_si128(xmminput[l][0], expkey[l][j]);
+        xmminput[l][1] = _mm_aesenc_si128(xmminput[l][1], expkey[l][j]);
+        xmminput[l][2] = _mm_aesenc_si128(xmminput[l][2], expkey[l][j]);
+        xmminput[l][3] = _mm_aesenc_si128(xmminput[l][3], expkey[l][j]);
+        xmminput[l][4] = _mm_aesenc_si128(xmminput[l][4], expkey[l][j]);
+        xmminput[l][5] = _mm_aesenc_si128(xmminput[l][5], expkey[l][j]);
+        xmminput[l][6] = _mm_aesenc_si128(xmminput[l][6], expkey[l][j]);
+        xmminput[l][7] = _mm_aesenc_si128(xmminput[l][7], expkey[l][j]);
+      }
+    }
+
+    for (l = 0; l < LANES; l++)
+    {
+      for (j = 0; j < 8; j++)
+      {
+        _mm_store_si128(&(longoutput[l][(i >> 4) + j]), xmminput[l][j]);
+      }
+    }
+  }
+
+  for (l = 0; l < LANES; l++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      lane[l]->a[i] = ((uint64_t *)lane[l]->state.k)[i] ^  ((uint64_t *)lane[l]->state.k)[i+4];
+      lane[l]->b[i] = ((uint64_t *)lane[l]->state.k)[i+2] ^  ((uint64_t *)lane[l]->state.k)[i+6];
+    }
+
+    b_x[l] = _mm_load_si128((__m128i *)lane[l]->b);
+    a[l][0] = lane[l]->a[0];
+    a[l][1] = lane[l]->a[1];
+  }
+
+  for(i = 0; likely(i < 0x80000); i++)
+  {
+    __m128i c_x[LANES];
+    ALIGNED_DECL(uint64_t c[LANES][2], 16);
+
+    for (l = 0; l < LANES; l++)
+    {
+      c_x[l] = _mm_load_si128((__m128i *)&lane[l]->long_state[a[l][0] & 0x1FFFF0]);
+    }
+
+    for (l = 0; l < LANES; l++)
+    {
+      c_x[l] = _mm_aesenc_si128(c_x[l], _mm_load_si128((__m128i *)a[l]));
+    }
+
+    for (l = 0; l < LANES; l++)
+    {
+      _mm_store_si128((__m128i *)c[l], c_x[l]);
+      b_x[l] = _mm_xor_si128(b_x[l], c_x[l]);
+      _mm_store_si128((__m128i *)&lane[l]->long_state[a[l][0] & 0x1FFFF0], b_x[l]);
+    }
+
+    for (l = 0; l < LANES; l++)
+    {
+      uint64_t *nextblock = (uint64_t *)&lane[l]->long_state[c[l][0] & 0x1FFFF0];
+      uint64_t b0 = nextblock[0];
+      uint64_t b1 = nextblock[1];
+      uint64_t hi, lo;
+
+      lo = cn_mul128(c[l][0], b0, &hi);
+      a[l][0] += hi;
+      a[l][1] += lo;
+      nextblock[0] = a[l][0];
+      nextblock[1] = a[l][1];
+
+      a[l][0] ^= b0;
+      a[l][1] ^= b1;
+      b_x[l] = c_x[l];
+    }
+  }
+
+  for (l = 0; l < LANES; l++)
+  {
+    memcpy(lane[l]->text, lane[l]->state.init, INIT_SIZE_BYTE);
+    memcpy(ExpandedKey[l], &lane[l]->state.hs.b[32], AES_KEY_SIZE);
+    ExpandAESKey256(ExpandedKey[l]);
+  }
+
+  for (i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE)
+  {
+    for (l = 0; l < LANES; l++)
+    {
+      for (j = 0; j < 8; j++)
+      {
+        xmminput[l][j] = _mm_xor_si128(longoutput[l][(i >> 4) + j], xmminput[l][j]);
+      }
+    }
+
+    for (j = 0; j < 10; j++)
+    {
+      for (l = 0; l < LANES; l++)
+      {
+        xmminput[l][0] = _mm_aesenc_si128(xmminput[l][0], expkey[l][j]);
+        xmminput[l][1] = _mm_aesenc_si128(xmminput[l][1], expkey[l][j]);
+        xmminput[l][2] = _mm_aesenc_si128(xmminput[l][2], expkey[l][j]);
+        xmminput[l][3] = _mm_aesenc_si128(xmminput[l][3], expkey[l][j]);
+        xmminput[l][4] = _mm_aesenc_si128(xmminput[l][4], expkey[l][j]);
+        xmminput[l][5] = _mm_aesenc_si128(xmminput[l][5], expkey[l][j]);
+        xmminput[l][6] = _mm_aesenc_si128(xmminput[l][6], expkey[l][j]);
+        xmminput[l][7] = _mm_aesenc_si128(xmminput[l][7], expkey[l][j]);
+      }
+    }
+  }
+
+  for (l = 0; l < LANES; l++)
+  {
+    memcpy(lane[l]->state.init, lane[l]->text, INIT_SIZE_BYTE);
+    hash_permutation(&lane[l]->state.hs);
+    extra_hashes[lane[l]->state.hs.b[0] & 3](&lane[l]->state, 200, hashes[l]);
+  }
+}
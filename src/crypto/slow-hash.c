@@ -36,10 +36,33 @@
 
 void (*cn_slow_hash_fp)(void *, const void *, size_t, void *);
 
+void (*cn_slow_hash_x2_fp)(void *const *, const void *const *, const size_t *, void *const *);
+void (*cn_slow_hash_x4_fp)(void *const *, const void *const *, const size_t *, void *const *);
+size_t cn_slow_hash_lanes_n;
+
 void cn_slow_hash_f(void * a, const void * b, size_t c, void * d){
 (*cn_slow_hash_fp)(a, b, c, d);
 }
 
+void cn_slow_hash_multi_f(void *const *contexts, const void *const *data, const size_t *lengths, void *const *hashes, size_t count) {
+  while (count > 0) {
+    if (count >= 4 && cn_slow_hash_x4_fp != NULL) {
+      (*cn_slow_hash_x4_fp)(contexts, data, lengths, hashes);
+      contexts += 4; data += 4; lengths += 4; hashes += 4; count -= 4;
+    } else if (count >= 2 && cn_slow_hash_x2_fp != NULL) {
+      (*cn_slow_hash_x2_fp)(contexts, data, lengths, hashes);
+      contexts += 2; data += 2; lengths += 2; hashes += 2; count -= 2;
+    } else {
+      (*cn_slow_hash_fp)(contexts[0], data[0], lengths[0], hashes[0]);
+      contexts += 1; data += 1; lengths += 1; hashes += 1; count -= 1;
+    }
+  }
+}
+
+size_t cn_slow_hash_lanes_f(void) {
+  return cn_slow_hash_lanes_n;
+}
+
 #if defined(__GNUC__)
 #define likely(x) (__builtin_expect(!!(x), 1))
 #define unlikely(x) (__builtin_expect(!!(x), 0))
@@ -170,6 +193,23 @@ static inline void ExpandAESKey256(uint8_t *keybuf)
   keys[14] = tmp1;
 }
 
+static inline uint64_t cn_mul128(uint64_t multiplier, uint64_t multiplicand, uint64_t* product_hi)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+  uint64_t hi, lo;
+  __asm__("mulq %3\n\t"
+    : "=d" (hi),
+    "=a" (lo)
+    : "%a" (multiplier),
+    "rm" (multiplicand)
+    : "cc" );
+  *product_hi = hi;
+  return lo;
+#else
+  return mul128(multiplier, multiplicand, product_hi);
+#endif
+}
+
 static void (*const extra_hashes[4])(const void *, size_t, char *) =
 {
     hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein
@@ -178,6 +218,12 @@ static void (*const extra_hashes[4])(const void *, size_t, char *) =
 #include "slow-hash.inl"
 #define AESNI
 #include "slow-hash.inl"
+#define LANES 2
+#include "slow-hash-multi.inl"
+#undef LANES
+#define LANES 4
+#include "slow-hash-multi.inl"
+#undef LANES
 
 INITIALIZER(detect_aes) {
   int ecx;
@@ -189,5 +235,16 @@ INITIALIZER(detect_aes) {
   int a, b, d;
   __cpuid(1, a, b, ecx, d);
 #endif
-  cn_slow_hash_fp = (ecx & (1 << 25)) ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni;
+  if (ecx & (1 << 25)) {
+    cn_slow_hash_fp = &cn_slow_hash_aesni;
+    cn_slow_hash_x2_fp = &cn_slow_hash_aesni_x2;
+    cn_slow_hash_x4_fp = &cn_slow_hash_aesni_x4;
+    cn_slow_hash_lanes_n = SLOW_HASH_DEFAULT_LANES;
+  } else {
+    // the table based AES gains nothing from interleaving, it is bound by the lookups
+    cn_slow_hash_fp = &cn_slow_hash_noaesni;
+    cn_slow_hash_x2_fp = NULL;
+    cn_slow_hash_x4_fp = NULL;
+    cn_slow_hash_lanes_n = 1;
+  }
 }
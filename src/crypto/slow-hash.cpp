@@ -15,7 +15,13 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <new>
+#include <thread>
+#include <vector>
 
 #include "hash.h"
 
@@ -23,6 +29,10 @@
 #include <Windows.h>
 #else
 #include <sys/mman.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #endif
 
 using std::bad_alloc;
@@ -30,13 +40,98 @@ using std::bad_alloc;
 namespace crypto {
 
   enum {
-    MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff)
+    MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff),
+    LARGE_PAGE_SIZE = 1 << 21
   };
 
+  namespace {
+    std::size_t round_up(std::size_t size, std::size_t alignment) {
+      return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // idle contexts beyond one per hardware thread are unmapped on release
+    struct context_pool {
+      std::mutex mutex;
+      std::vector<cn_context *> idle;
+
+      ~context_pool() {
+        for (cn_context *context : idle) {
+          delete context;
+        }
+      }
+    };
+
+    context_pool &get_context_pool() {
+      static context_pool pool;
+      return pool;
+    }
+  }
+
+  pooled_cn_context acquire_cn_context() {
+    context_pool &pool = get_context_pool();
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      if (!pool.idle.empty()) {
+        pooled_cn_context context(pool.idle.back());
+        pool.idle.pop_back();
+        return context;
+      }
+    }
+
+    return pooled_cn_context(new cn_context());
+  }
+
+  void cn_context_release::operator()(cn_context *context) const {
+    memset(context->data, 0, context->size);
+
+    context_pool &pool = get_context_pool();
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      if (pool.idle.size() < std::max(std::thread::hardware_concurrency(), 1u)) {
+        pool.idle.push_back(context);
+        return;
+      }
+    }
+
+    delete context;
+  }
+
 #if defined(WIN32)
 
   cn_context::cn_context() {
-    data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
+    init(normal_pages, false);
+  }
+
+  cn_context::cn_context(page_mode mode, bool local_node) {
+    init(mode, local_node);
+  }
+
+  void cn_context::init(page_mode mode, bool local_node) {
+    DWORD node = NUMA_NO_PREFERRED_NODE;
+    if (local_node) {
+      UCHAR processorNode;
+      if (GetNumaProcessorNode(static_cast<UCHAR>(GetCurrentProcessorNumber()), &processorNode)) {
+        node = processorNode;
+      }
+    }
+
+    data = nullptr;
+    large = false;
+    if (mode == large_pages) {
+      // needs the "lock pages in memory" privilege, fails otherwise
+      SIZE_T minimum = GetLargePageMinimum();
+      if (minimum != 0) {
+        size = round_up(MAP_SIZE, minimum);
+        data = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, node);
+        large = data != nullptr;
+      }
+    }
+
+    if (data == nullptr) {
+      size = MAP_SIZE;
+      data = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+    }
+
     if (data == nullptr) {
       throw bad_alloc();
     }
@@ -50,20 +145,108 @@ namespace crypto {
 
 #else
 
+  namespace {
+#if defined(__linux__)
+    void* map_hugetlb(std::size_t size) {
+#if defined(MAP_HUGETLB)
+      return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#else
+      return MAP_FAILED;
+#endif
+    }
+
+    // transparent huge pages only back the 2 MB aligned parts of a mapping, so trim an oversized one to alignment
+    void* map_transparent(std::size_t size) {
+#if defined(MADV_HUGEPAGE)
+      void* area = mmap(nullptr, size + LARGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (area == MAP_FAILED) {
+        return MAP_FAILED;
+      }
+
+      uintptr_t begin = reinterpret_cast<uintptr_t>(area);
+      uintptr_t aligned = round_up(begin, LARGE_PAGE_SIZE);
+      if (aligned != begin) {
+        munmap(area, aligned - begin);
+      }
+
+      std::size_t tail = begin + size + LARGE_PAGE_SIZE - (aligned + size);
+      if (tail != 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+      }
+
+      area = reinterpret_cast<void*>(aligned);
+      if (madvise(area, size, MADV_HUGEPAGE) != 0) {
+        munmap(area, size);
+        return MAP_FAILED;
+      }
+
+      return area;
+#else
+      return MAP_FAILED;
+#endif
+    }
+
+    // prefer the node of the current cpu, the kernel still falls back to other nodes when it runs out of memory
+    void bind_to_local_node(void* area, std::size_t size) {
+      const int MPOL_PREFERRED_POLICY = 1;
+      unsigned cpu;
+      unsigned node;
+      if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= sizeof(unsigned long) * 8) {
+        return;
+      }
+
+      unsigned long nodemask = 1UL << node;
+      syscall(SYS_mbind, area, size, MPOL_PREFERRED_POLICY, &nodemask, sizeof(nodemask) * 8, 0);
+    }
+#endif
+  }
+
   cn_context::cn_context() {
-#if !defined(__APPLE__)
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    init(normal_pages, false);
+  }
+
+  cn_context::cn_context(page_mode mode, bool local_node) {
+    init(mode, local_node);
+  }
+
+  void cn_context::init(page_mode mode, bool local_node) {
+    data = MAP_FAILED;
+    size = MAP_SIZE;
+    large = false;
+
+#if defined(__linux__)
+    if (mode == large_pages) {
+      data = map_hugetlb(round_up(MAP_SIZE, LARGE_PAGE_SIZE));
+      if (data != MAP_FAILED) {
+        size = round_up(MAP_SIZE, LARGE_PAGE_SIZE);
+      } else {
+        data = map_transparent(MAP_SIZE);
+      }
+      large = data != MAP_FAILED;
+    }
+
+    if (data == MAP_FAILED) {
+      // the pages are populated by mlock below, after the numa policy is in place
+      int flags = MAP_PRIVATE | MAP_ANONYMOUS | (local_node ? 0 : MAP_POPULATE);
+      data = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    }
+
+    if (data != MAP_FAILED && local_node) {
+      bind_to_local_node(data, size);
+    }
+#elif !defined(__APPLE__)
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
 #else
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
 #endif
     if (data == MAP_FAILED) {
       throw bad_alloc();
     }
-    mlock(data, MAP_SIZE);
+    mlock(data, size);
   }
 
   cn_context::~cn_context() {
-    if (munmap(data, MAP_SIZE) != 0) {
+    if (munmap(data, size) != 0) {
       throw bad_alloc();
     }
   }
@@ -22,6 +22,18 @@
 
 #include "hash-ops.h"
 
+// hashes[j] = H(pairs[2j] || pairs[2j + 1]) for every j below count, several pairs at once
+static void hash_pairs(const char (*pairs)[HASH_SIZE], size_t count, char (*hashes)[HASH_SIZE]) {
+  size_t j;
+  const void **data = alloca(count * sizeof(const void *));
+  size_t *lengths = alloca(count * sizeof(size_t));
+  for (j = 0; j < count; ++j) {
+    data[j] = pairs[2 * j];
+    lengths[j] = 2 * HASH_SIZE;
+  }
+  cn_fast_hash_multi(data, lengths, hashes, count);
+}
+
 void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
   assert(count > 0);
   if (count == 1) {
@@ -38,15 +50,13 @@ void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
     cnt &= ~(cnt >> 1);
     ints = alloca(cnt * HASH_SIZE);
     memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 64, ints[j]);
-    }
-    assert(i == count);
+    i = 2 * cnt - count;
+    j = 2 * cnt - count;
+    hash_pairs(hashes + i, cnt - j, ints + j);
+    assert(i + 2 * (cnt - j) == count);
     while (cnt > 2) {
       cnt >>= 1;
-      for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints[i], 64, ints[j]);
-      }
+      hash_pairs(ints, cnt, ints);
     }
     cn_fast_hash(ints[0], 64, root_hash);
   }
@@ -81,18 +91,16 @@ void tree_branch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[H
   assert(depth == tree_depth(count));
   ints = alloca((cnt - 1) * HASH_SIZE);
   memcpy(ints, hashes + 1, (2 * cnt - count - 1) * HASH_SIZE);
-  for (i = 2 * cnt - count, j = 2 * cnt - count - 1; j < cnt - 1; i += 2, ++j) {
-    cn_fast_hash(hashes[i], 2 * HASH_SIZE, ints[j]);
-  }
-  assert(i == count);
+  i = 2 * cnt - count;
+  j = 2 * cnt - count - 1;
+  hash_pairs(hashes + i, cnt - 1 - j, ints + j);
+  assert(i + 2 * (cnt - 1 - j) == count);
   while (depth > 0) {
     assert(cnt == 1ULL << depth);
     cnt >>= 1;
     --depth;
     memcpy(branch[depth], ints[0], HASH_SIZE);
-    for (i = 1, j = 0; j < cnt - 1; i += 2, ++j) {
-      cn_fast_hash(ints[i], 2 * HASH_SIZE, ints[j]);
-    }
+    hash_pairs(ints + 1, cnt - 1, ints);
   }
 }
 
@@ -90,6 +90,7 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  200;    //by default, blocks count in blocks downloading
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
+const size_t   COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES_MAX_COUNT = 10000;
 
 const int      P2P_DEFAULT_PORT                              =  8080;
 const int      RPC_DEFAULT_PORT                              =  8081;
@@ -107,6 +108,11 @@ const uint64_t P2P_DEFAULT_INVOKE_TIMEOUT                    = 60 * 2 * 1000; //
 const size_t   P2P_DEFAULT_HANDSHAKE_INVOKE_TIMEOUT          = 5000;          // 5 seconds
 const char     P2P_STAT_TRUSTED_PUB_KEY[]                    = "93467628927eaa0b13a4e52e61864a75aa475e67f6b5748eb3fc1d2fe468aed4";
 const size_t   P2P_DEFAULT_WHITELIST_CONNECTIONS_PERCENT     = 70;
+const size_t   P2P_DEFAULT_COMPRESSION_THRESHOLD             = 16 * 1024;     // notifications smaller than this are sent uncompressed
+const size_t   P2P_DEFAULT_PEER_SELECTION_CANDIDATES         = 3;             // random peers compared by metrics per connection attempt
+const uint32_t P2P_PEER_METRICS_DEFAULT_RTT                  = 500;           // ms, assumed for peers never measured
+const uint64_t P2P_PEER_METRICS_REFERENCE_THROUGHPUT         = 100 * 1024;    // bytes per second
+const uint32_t P2P_PEER_METRICS_ATTEMPTS_WINDOW              = 32;
 
 const unsigned THREAD_STACK_SIZE                             = 5 * 1024 * 1024;
 
@@ -0,0 +1,233 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "MultiAccountScanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+namespace {
+  // Accounts checked together against one transaction: enough to amortize the shared
+  // decompression and field inversion, small enough to keep the scratch data in cache
+  const size_t ACCOUNTS_PER_BATCH = 64;
+
+  template <class Func>
+  void runParallel(size_t threadCount, size_t itemCount, Func func) {
+    std::atomic<size_t> nextItem(0);
+    auto worker = [&] {
+      for (size_t item = nextItem++; item < itemCount; item = nextItem++) {
+        func(item);
+      }
+    };
+
+    size_t workers = std::min(threadCount, itemCount);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1; i < workers; ++i) {
+      futures.push_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for (auto& f : futures) {
+      f.get();
+    }
+  }
+}
+
+namespace cryptonote
+{
+  MultiAccountScanner::MultiAccountScanner(const std::vector<account_keys>& accounts, size_t threadCount) :
+    m_threadCount(threadCount) {
+    if (m_threadCount == 0) {
+      m_threadCount = std::thread::hardware_concurrency();
+      if (m_threadCount == 0) {
+        m_threadCount = 4;
+      }
+    }
+
+    m_viewKeys.reserve(accounts.size());
+    m_spendKeys.reserve(accounts.size());
+    for (const account_keys& acc : accounts) {
+      m_viewKeys.push_back(acc.m_view_secret_key);
+      m_spendKeys.push_back(acc.m_account_address.m_spendPublicKey);
+    }
+  }
+  //---------------------------------------------------------------
+  bool MultiAccountScanner::scanBlocks(const std::vector<block_complete_entry>& blocks, uint64_t startHeight,
+    std::vector<std::vector<ScannedOutput>>& outputs) const {
+    std::vector<std::vector<TransactionEntry>> blockEntries(blocks.size());
+    std::atomic<bool> parsed(true);
+
+    runParallel(m_threadCount, blocks.size(), [&](size_t i) {
+      const block_complete_entry& bce = blocks[i];
+      if (bce.block.empty()) {
+        return;
+      }
+
+      Block b;
+      if (!parse_and_validate_block_from_blob(bce.block, b)) {
+        LOG_ERROR("Failed to parse block at height " << startHeight + i);
+        parsed = false;
+        return;
+      }
+
+      std::vector<TransactionEntry>& entries = blockEntries[i];
+      entries.reserve(1 + bce.txs.size());
+      entries.emplace_back();
+      if (!makeEntry(b.minerTx, startHeight + i, entries.back())) {
+        entries.pop_back();
+      }
+
+      for (const blobdata& txBlob : bce.txs) {
+        Transaction tx;
+        if (!parse_and_validate_tx_from_blob(txBlob, tx)) {
+          LOG_ERROR("Failed to parse transaction in block at height " << startHeight + i);
+          parsed = false;
+          return;
+        }
+
+        entries.emplace_back();
+        if (!makeEntry(tx, startHeight + i, entries.back())) {
+          entries.pop_back();
+        }
+      }
+    });
+
+    if (!parsed) {
+      return false;
+    }
+
+    std::vector<TransactionEntry> entries;
+    for (auto& be : blockEntries) {
+      std::move(be.begin(), be.end(), std::back_inserter(entries));
+    }
+
+    scanEntries(entries, outputs);
+    return true;
+  }
+  //---------------------------------------------------------------
+  void MultiAccountScanner::scanTransactions(const std::vector<Transaction>& transactions, uint64_t blockHeight,
+    std::vector<std::vector<ScannedOutput>>& outputs) const {
+    std::vector<TransactionEntry> entries;
+    entries.reserve(transactions.size());
+    for (const Transaction& tx : transactions) {
+      entries.emplace_back();
+      if (!makeEntry(tx, blockHeight, entries.back())) {
+        entries.pop_back();
+      }
+    }
+
+    scanEntries(entries, outputs);
+  }
+  //---------------------------------------------------------------
+  bool MultiAccountScanner::makeEntry(const Transaction& tx, uint64_t blockHeight, TransactionEntry& entry) {
+    entry.publicKey = get_tx_pub_key_from_extra(tx);
+    if (entry.publicKey == null_pkey) {
+      return false;
+    }
+
+    size_t keyIndex = 0;
+    for (size_t outputIndex = 0; outputIndex < tx.vout.size(); ++outputIndex) {
+      const TransactionOutput& o = tx.vout[outputIndex];
+      if (o.target.type() == typeid(TransactionOutputToKey)) {
+        entry.keys.push_back(boost::get<TransactionOutputToKey>(o.target).key);
+        entry.keyIndices.push_back(keyIndex);
+        entry.outputIndices.push_back(outputIndex);
+        entry.amounts.push_back(o.amount);
+        ++keyIndex;
+      } else if (o.target.type() == typeid(TransactionOutputMultisignature)) {
+        keyIndex += boost::get<TransactionOutputMultisignature>(o.target).keys.size();
+      }
+    }
+
+    if (entry.keys.empty()) {
+      return false;
+    }
+
+    entry.blockHeight = blockHeight;
+    entry.hash = get_transaction_hash(tx);
+    return true;
+  }
+  //---------------------------------------------------------------
+  void MultiAccountScanner::scanEntries(const std::vector<TransactionEntry>& entries,
+    std::vector<std::vector<ScannedOutput>>& outputs) const {
+    outputs.clear();
+    outputs.resize(m_viewKeys.size());
+    if (entries.empty() || m_viewKeys.empty()) {
+      return;
+    }
+
+    // With few accounts there are not enough batches to keep every core busy, so the transactions are split too
+    size_t accountBatches = (m_viewKeys.size() + ACCOUNTS_PER_BATCH - 1) / ACCOUNTS_PER_BATCH;
+    size_t entryChunks = 1;
+    if (accountBatches < m_threadCount * 2) {
+      entryChunks = std::min(entries.size(), (m_threadCount * 2 + accountBatches - 1) / accountBatches);
+    }
+    size_t entriesPerChunk = (entries.size() + entryChunks - 1) / entryChunks;
+
+    typedef std::vector<std::pair<size_t, ScannedOutput>> Found;
+    std::vector<Found> found(accountBatches * entryChunks);
+
+    runParallel(m_threadCount, found.size(), [&](size_t item) {
+      size_t firstAccount = (item / entryChunks) * ACCOUNTS_PER_BATCH;
+      size_t accountCount = std::min(ACCOUNTS_PER_BATCH, m_viewKeys.size() - firstAccount);
+      size_t firstEntry = (item % entryChunks) * entriesPerChunk;
+      size_t lastEntry = std::min(firstEntry + entriesPerChunk, entries.size());
+
+      std::unique_ptr<bool[]> matches;
+      size_t matchesSize = 0;
+      for (size_t e = firstEntry; e < lastEntry; ++e) {
+        const TransactionEntry& entry = entries[e];
+        size_t keyCount = entry.keys.size();
+        if (matchesSize < accountCount * keyCount) {
+          matchesSize = accountCount * keyCount;
+          matches.reset(new bool[matchesSize]);
+        }
+
+        if (!crypto::scan_outputs(entry.publicKey, &m_viewKeys[firstAccount], &m_spendKeys[firstAccount], accountCount,
+          entry.keys.data(), entry.keyIndices.data(), keyCount, matches.get())) {
+          continue;
+        }
+
+        for (size_t a = 0; a < accountCount; ++a) {
+          for (size_t k = 0; k < keyCount; ++k) {
+            if (matches[a * keyCount + k]) {
+              ScannedOutput out;
+              out.blockHeight = entry.blockHeight;
+              out.transactionHash = entry.hash;
+              out.transactionPublicKey = entry.publicKey;
+              out.outputIndex = entry.outputIndices[k];
+              out.amount = entry.amounts[k];
+              found[item].push_back(std::make_pair(firstAccount + a, out));
+            }
+          }
+        }
+      }
+    });
+
+    // Items are ordered by account batch, then by transaction chunk, so each account keeps blockchain order
+    for (const Found& f : found) {
+      for (const auto& p : f) {
+        outputs[p.first].push_back(p.second);
+      }
+    }
+  }
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "cryptonote_core/account.h"
+#include "cryptonote_core/cryptonote_basic.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+
+namespace cryptonote
+{
+  struct ScannedOutput {
+    uint64_t blockHeight;
+    crypto::hash transactionHash;
+    crypto::public_key transactionPublicKey;
+    size_t outputIndex;
+    uint64_t amount;
+  };
+
+  // Scans the same blocks for many accounts at once. Blocks and transactions are parsed and the transaction
+  // public keys extracted once, then each transaction is checked against batches of accounts on all cores.
+  class MultiAccountScanner {
+  public:
+    explicit MultiAccountScanner(const std::vector<account_keys>& accounts, size_t threadCount = 0);
+
+    size_t accountCount() const { return m_viewKeys.size(); }
+
+    // outputs[i] receives the outputs of accounts[i], in blockchain order.
+    // Returns false if a block or a transaction can't be parsed.
+    bool scanBlocks(const std::vector<block_complete_entry>& blocks, uint64_t startHeight,
+      std::vector<std::vector<ScannedOutput>>& outputs) const;
+    void scanTransactions(const std::vector<Transaction>& transactions, uint64_t blockHeight,
+      std::vector<std::vector<ScannedOutput>>& outputs) const;
+
+  private:
+    struct TransactionEntry {
+      uint64_t blockHeight;
+      crypto::hash hash;
+      crypto::public_key publicKey;
+      std::vector<crypto::public_key> keys;
+      std::vector<size_t> keyIndices;
+      std::vector<size_t> outputIndices;
+      std::vector<uint64_t> amounts;
+    };
+
+    static bool makeEntry(const Transaction& tx, uint64_t blockHeight, TransactionEntry& entry);
+    void scanEntries(const std::vector<TransactionEntry>& entries, std::vector<std::vector<ScannedOutput>>& outputs) const;
+
+    std::vector<crypto::secret_key> m_viewKeys;
+    std::vector<crypto::public_key> m_spendKeys;
+    size_t m_threadCount;
+  };
+}
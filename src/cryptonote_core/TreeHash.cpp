@@ -0,0 +1,200 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TreeHash.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace {
+  const size_t NOTHING_MOVED = std::numeric_limits<size_t>::max();
+
+  // the number of nodes of the first level, the largest power of two below the hash count
+  size_t firstLevelSize(size_t count) {
+    size_t size = 1;
+    while (2 * size < count) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // hashes[j] = H(pairs[2j] || pairs[2j + 1]) for every j below count
+  void hashPairs(const crypto::hash* pairs, size_t count, crypto::hash* hashes) {
+    std::vector<const void*> data(count);
+    std::vector<size_t> lengths(count, 2 * sizeof(crypto::hash));
+    for (size_t j = 0; j < count; ++j) {
+      data[j] = &pairs[2 * j];
+    }
+    crypto::cn_fast_hash_multi(data.data(), lengths.data(), hashes, count);
+  }
+
+  void sortUnique(std::vector<size_t>& nodes) {
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+  }
+}
+
+namespace cryptonote
+{
+  TreeHash::TreeHash() : m_levelsSize(0), m_movedFrom(NOTHING_MOVED) {
+  }
+
+  void TreeHash::assign(const std::vector<crypto::hash>& hashes) {
+    size_t common = std::min(m_hashes.size(), hashes.size());
+    for (size_t i = 0; i < common; ++i) {
+      replace(i, hashes[i]);
+    }
+
+    if (hashes.size() != m_hashes.size()) {
+      m_hashes.resize(common);
+      m_hashes.insert(m_hashes.end(), hashes.begin() + common, hashes.end());
+      m_movedFrom = std::min(m_movedFrom, common);
+    }
+  }
+
+  void TreeHash::replace(size_t index, const crypto::hash& hash) {
+    assert(index < m_hashes.size());
+    if (m_hashes[index] == hash) {
+      return;
+    }
+
+    m_hashes[index] = hash;
+    if (m_replaced.size() < m_hashes.size()) {
+      m_replaced.push_back(index);
+    } else {
+      // rehashing the paths one by one would cost more than the whole tree
+      m_movedFrom = 0;
+    }
+  }
+
+  void TreeHash::insert(size_t index, const crypto::hash& hash) {
+    assert(index <= m_hashes.size());
+    m_hashes.insert(m_hashes.begin() + index, hash);
+    m_movedFrom = std::min(m_movedFrom, index);
+  }
+
+  void TreeHash::erase(size_t index) {
+    assert(index < m_hashes.size());
+    m_hashes.erase(m_hashes.begin() + index);
+    m_movedFrom = std::min(m_movedFrom, index);
+  }
+
+  void TreeHash::clear() {
+    m_hashes.clear();
+    m_levels.clear();
+    m_levelsSize = 0;
+    m_movedFrom = NOTHING_MOVED;
+    m_replaced.clear();
+  }
+
+  crypto::hash TreeHash::root() {
+    assert(!m_hashes.empty());
+    size_t count = m_hashes.size();
+    size_t size = firstLevelSize(count);
+    if (m_levels.empty() || m_levels[0].size() != size) {
+      rebuild();
+      return m_levels.back()[0];
+    }
+
+    size_t copied = 2 * size - count;
+    // every node from this one on is stale, so are the nodes listed before it
+    size_t from = size;
+    if (m_movedFrom < count) {
+      from = nodeIndex(m_movedFrom);
+    }
+    if (m_levelsSize != count) {
+      // the pairs were shifted by one
+      from = std::min(from, std::min(copied, 2 * size - m_levelsSize));
+    }
+
+    std::vector<size_t> nodes;
+    for (size_t index : m_replaced) {
+      if (index < count && nodeIndex(index) < from) {
+        nodes.push_back(nodeIndex(index));
+      }
+    }
+    sortUnique(nodes);
+
+    std::vector<crypto::hash>& first = m_levels[0];
+    for (size_t node : nodes) {
+      if (node < copied) {
+        first[node] = m_hashes[node];
+      } else {
+        crypto::cn_fast_hash(&m_hashes[2 * node - copied], 2 * sizeof(crypto::hash), first[node]);
+      }
+    }
+    for (size_t node = from; node < copied; ++node) {
+      first[node] = m_hashes[node];
+    }
+    size_t pairsFrom = std::max(from, copied);
+    if (pairsFrom < size) {
+      hashPairs(&m_hashes[2 * pairsFrom - copied], size - pairsFrom, &first[pairsFrom]);
+    }
+
+    for (size_t level = 1; level < m_levels.size(); ++level) {
+      const std::vector<crypto::hash>& below = m_levels[level - 1];
+      std::vector<crypto::hash>& current = m_levels[level];
+      from /= 2;
+      for (size_t& node : nodes) {
+        node /= 2;
+      }
+      sortUnique(nodes);
+
+      for (size_t node : nodes) {
+        if (node < from) {
+          crypto::cn_fast_hash(&below[2 * node], 2 * sizeof(crypto::hash), current[node]);
+        }
+      }
+      if (from < current.size()) {
+        hashPairs(&below[2 * from], current.size() - from, &current[from]);
+      }
+    }
+
+    m_levelsSize = count;
+    m_movedFrom = NOTHING_MOVED;
+    m_replaced.clear();
+    return m_levels.back()[0];
+  }
+
+  void TreeHash::rebuild() {
+    size_t count = m_hashes.size();
+    size_t size = firstLevelSize(count);
+    size_t copied = 2 * size - count;
+
+    m_levels.clear();
+    m_levels.emplace_back(size);
+    std::copy(m_hashes.begin(), m_hashes.begin() + copied, m_levels[0].begin());
+    if (copied < size) {
+      hashPairs(&m_hashes[copied], size - copied, &m_levels[0][copied]);
+    }
+    while (size > 1) {
+      size /= 2;
+      m_levels.emplace_back(size);
+      hashPairs(m_levels[m_levels.size() - 2].data(), size, m_levels.back().data());
+    }
+
+    m_levelsSize = count;
+    m_movedFrom = NOTHING_MOVED;
+    m_replaced.clear();
+  }
+
+  size_t TreeHash::nodeIndex(size_t hashIndex) const {
+    size_t copied = 2 * m_levels[0].size() - m_hashes.size();
+    return hashIndex < copied ? hashIndex : copied + (hashIndex - copied) / 2;
+  }
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "crypto/hash.h"
+
+namespace cryptonote
+{
+  // The transaction tree of a block (see crypto::tree_hash) with all its levels kept, so that the root is
+  // updated rather than recomputed after a change. A replaced hash rehashes its path to the root only.
+  // The tree pairs up the trailing hashes, so an insertion or a removal rehashes every level from the
+  // first moved node to its end, and a size crossing a power of two rebuilds the whole tree.
+  class TreeHash {
+  public:
+    TreeHash();
+
+    size_t size() const { return m_hashes.size(); }
+    bool empty() const { return m_hashes.empty(); }
+    const std::vector<crypto::hash>& hashes() const { return m_hashes; }
+
+    // Replaces the hashes, only the positions that differ from the current ones count as changed
+    void assign(const std::vector<crypto::hash>& hashes);
+    void replace(size_t index, const crypto::hash& hash);
+    void insert(size_t index, const crypto::hash& hash);
+    void erase(size_t index);
+    void push_back(const crypto::hash& hash) { insert(m_hashes.size(), hash); }
+    void pop_back() { erase(m_hashes.size() - 1); }
+    void clear();
+
+    // Requires at least one hash
+    crypto::hash root();
+
+  private:
+    void rebuild();
+    size_t nodeIndex(size_t hashIndex) const;
+
+    std::vector<crypto::hash> m_hashes;
+    // m_levels[0] holds the hashes copied as is followed by the hashes of the paired ones,
+    // every next level half as many nodes, the last one is the root
+    std::vector<std::vector<crypto::hash>> m_levels;
+    // the hash count the levels were built for
+    size_t m_levelsSize;
+    // hashes from this position on were moved
+    size_t m_movedFrom;
+    // positions of the hashes replaced in place
+    std::vector<size_t> m_replaced;
+  };
+}
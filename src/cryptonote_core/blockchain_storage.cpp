@@ -282,6 +282,7 @@ BOOST_CLASS_VERSION(cryptonote::BlockCacheSerializer, CURRENT_BLOCKCACHE_STORAGE
 blockchain_storage::blockchain_storage(const Currency& currency, tx_memory_pool& tx_pool):
       m_currency(currency),
       m_tx_pool(tx_pool),
+      m_cn_context(crypto::cn_context::large_pages, false),
       m_current_block_cumul_sz_limit(0),
       m_is_in_checkpoint_zone(false),
       m_is_blockchain_storing(false),
@@ -387,16 +388,43 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
         m_spent_keys.clear();
         m_outputs.clear();
         m_multisignatureOutputs.clear();
+        // the ids are computed a chunk of blocks at a time, so that many blobs get hashed at once;
+        // the chunk keeps pointers into the m_blocks cache, so it has to stay well below its size
+        const uint32_t REBUILD_CHUNK_SIZE = 256;
+        std::vector<const Block*> chunkBlocks;
+        std::vector<const Transaction*> chunkTransactions;
+        std::vector<crypto::hash> blockHashes;
+        std::vector<crypto::hash> transactionHashes;
+        size_t transactionHashIndex = 0;
         for (uint32_t b = 0; b < m_blocks.size(); ++b) {
           if (b % 1000 == 0) {
             std::cout << "Height " << b << " of " << m_blocks.size() << '\r';
           }
+
+          if (b % REBUILD_CHUNK_SIZE == 0) {
+            chunkBlocks.clear();
+            chunkTransactions.clear();
+            for (uint32_t c = b; c < m_blocks.size() && c < b + REBUILD_CHUNK_SIZE; ++c) {
+              const BlockEntry& chunkBlock = m_blocks[c];
+              chunkBlocks.push_back(&chunkBlock.bl);
+              for (const TransactionEntry& transaction : chunkBlock.transactions) {
+                chunkTransactions.push_back(&transaction.tx);
+              }
+            }
+
+            if (!get_block_hashes(chunkBlocks, blockHashes) || !get_transaction_hashes(chunkTransactions, transactionHashes)) {
+              LOG_ERROR("Failed to compute block and transaction hashes");
+              return false;
+            }
+            transactionHashIndex = 0;
+          }
+
           const BlockEntry& block = m_blocks[b];
-          crypto::hash blockHash = get_block_hash(block.bl);
+          crypto::hash blockHash = blockHashes[b % REBUILD_CHUNK_SIZE];
           m_blockIndex.push(blockHash);
           for (uint16_t t = 0; t < block.transactions.size(); ++t) {
             const TransactionEntry& transaction = block.transactions[t];
-            crypto::hash transactionHash = get_transaction_hash(transaction.tx);
+            crypto::hash transactionHash = transactionHashes[transactionHashIndex++];
             TransactionIndex transactionIndex = { b, t };
             m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
             for (auto& i : transaction.tx.vin) {
@@ -1364,15 +1392,34 @@ bool blockchain_storage::get_tx_outputs_gindexs(const crypto::hash& tx_id, std::
 }
 
 bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t& max_used_block_height, crypto::hash& max_used_block_id, BlockInfo* tail) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  crypto::hash tx_prefix_hash = get_transaction_prefix_hash(tx);
+  std::vector<MultisignatureCheck> multisignatureChecks;
+  uint64_t maxUsedBlockHeight = 0;
+  crypto::hash maxUsedBlockId;
+
+  {
+    CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
-  if (tail)
-    tail->id = get_tail_id(tail->height);
+    if (tail)
+      tail->id = get_tail_id(tail->height);
 
-  bool res = check_tx_inputs(tx, &max_used_block_height);
-  if (!res) return false;
-  CHECK_AND_ASSERT_MES(max_used_block_height < m_blocks.size(), false, "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size());
-  get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+    bool res = check_tx_inputs(tx, tx_prefix_hash, &maxUsedBlockHeight, &multisignatureChecks);
+    if (!res) return false;
+    CHECK_AND_ASSERT_MES(maxUsedBlockHeight < m_blocks.size(), false, "internal error: max used block index=" << maxUsedBlockHeight << " is not less then blockchain size = " << m_blocks.size());
+    get_block_hash(m_blocks[maxUsedBlockHeight].bl, maxUsedBlockId);
+  }
+
+  // the keys are copies and the signatures belong to tx, a chain switch meanwhile shows up in the block id above
+  for (const MultisignatureCheck& check : multisignatureChecks) {
+    if (!crypto::check_multisignature(tx_prefix_hash, check.keys.data(), check.keys.size(), check.signatures->data(), check.signatures->size())) {
+      LOG_PRINT_L1("Transaction << " << get_transaction_hash(tx) << " contains multisignature input with invalid signatures.");
+      return false;
+    }
+  }
+
+  // callers cache a non-empty block as "inputs checked", so publish it only after every check passed
+  max_used_block_height = maxUsedBlockHeight;
+  max_used_block_id = maxUsedBlockId;
   return true;
 }
 
@@ -1393,7 +1440,7 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t* pmax_u
   return check_tx_inputs(tx, tx_prefix_hash, pmax_used_block_height);
 }
 
-bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height) {
+bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height, std::vector<MultisignatureCheck>* multisignatureChecks) {
   size_t inputIndex = 0;
   if (pmax_used_block_height) {
     *pmax_used_block_height = 0;
@@ -1418,7 +1465,7 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::ha
 
       ++inputIndex;
     } else if (txin.type() == typeid(TransactionInputMultisignature)) {
-      if (!validateInput(::boost::get<TransactionInputMultisignature>(txin), transactionHash, tx_prefix_hash, tx.signatures[inputIndex])) {
+      if (!validateInput(::boost::get<TransactionInputMultisignature>(txin), transactionHash, tx_prefix_hash, tx.signatures[inputIndex], multisignatureChecks)) {
         return false;
       }
 
@@ -1972,7 +2019,7 @@ void blockchain_storage::popTransactions(const BlockEntry& block, const crypto::
   popTransaction(block.bl.minerTx, minerTransactionHash);
 }
 
-bool blockchain_storage::validateInput(const TransactionInputMultisignature& input, const crypto::hash& transactionHash, const crypto::hash& transactionPrefixHash, const std::vector<crypto::signature>& transactionSignatures) {
+bool blockchain_storage::validateInput(const TransactionInputMultisignature& input, const crypto::hash& transactionHash, const crypto::hash& transactionPrefixHash, const std::vector<crypto::signature>& transactionSignatures, std::vector<MultisignatureCheck>* multisignatureChecks) {
   assert(input.signatures == transactionSignatures.size());
   MultisignatureOutputsContainer::const_iterator amountOutputs = m_multisignatureOutputs.find(input.amount);
   if (amountOutputs == m_multisignatureOutputs.end()) {
@@ -2005,19 +2052,14 @@ bool blockchain_storage::validateInput(const TransactionInputMultisignature& inp
     return false;
   }
 
-  std::size_t inputSignatureIndex = 0;
-  std::size_t outputKeyIndex = 0;
-  while (inputSignatureIndex < input.signatures) {
-    if (outputKeyIndex == output.keys.size()) {
-      LOG_PRINT_L1("Transaction << " << transactionHash << " contains multisignature input with invalid signatures.");
-      return false;
-    }
-
-    if (crypto::check_signature(transactionPrefixHash, output.keys[outputKeyIndex], transactionSignatures[inputSignatureIndex])) {
-      ++inputSignatureIndex;
-    }
+  if (multisignatureChecks != NULL) {
+    multisignatureChecks->push_back(MultisignatureCheck{output.keys, &transactionSignatures});
+    return true;
+  }
 
-    ++outputKeyIndex;
+  if (!crypto::check_multisignature(transactionPrefixHash, output.keys.data(), output.keys.size(), transactionSignatures.data(), transactionSignatures.size())) {
+    LOG_PRINT_L1("Transaction << " << transactionHash << " contains multisignature input with invalid signatures.");
+    return false;
   }
 
   return true;
@@ -186,6 +186,12 @@ namespace cryptonote {
       template<class Archive> void serialize(Archive& archive, unsigned int version);
     };
 
+    // signatures of a multisignature input left to check once the blockchain lock is released
+    struct MultisignatureCheck {
+      std::vector<crypto::public_key> keys;
+      const std::vector<crypto::signature>* signatures;
+    };
+
     typedef google::sparse_hash_set<crypto::key_image> key_images_container;
     typedef std::unordered_map<crypto::hash, BlockEntry> blocks_ext_by_hash;
     typedef google::sparse_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //crypto::hash - tx hash, size_t - index of out in transaction
@@ -242,7 +248,7 @@ namespace cryptonote {
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
     bool check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height = NULL);
-    bool check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height = NULL);
+    bool check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height = NULL, std::vector<MultisignatureCheck>* multisignatureChecks = NULL);
     bool check_tx_inputs(const Transaction& tx, uint64_t* pmax_used_block_height = NULL);
     bool have_tx_keyimg_as_spent(const crypto::key_image &key_im);
     const TransactionEntry& transactionByIndex(TransactionIndex index);
@@ -252,7 +258,7 @@ namespace cryptonote {
     bool pushTransaction(BlockEntry& block, const crypto::hash& transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction& transaction, const crypto::hash& transactionHash);
     void popTransactions(const BlockEntry& block, const crypto::hash& minerTransactionHash);
-    bool validateInput(const TransactionInputMultisignature& input, const crypto::hash& transactionHash, const crypto::hash& transactionPrefixHash, const std::vector<crypto::signature>& transactionSignatures);
+    bool validateInput(const TransactionInputMultisignature& input, const crypto::hash& transactionHash, const crypto::hash& transactionPrefixHash, const std::vector<crypto::signature>& transactionSignatures, std::vector<MultisignatureCheck>* multisignatureChecks = NULL);
 
     friend class LockedBlockchainStorage;
   };
@@ -15,7 +15,10 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <atomic>
+#include <future>
 #include <set>
+#include <thread>
 
 // epee
 #include "include_base_utils.h"
@@ -25,6 +28,7 @@
 #include "crypto/hash.h"
 #include "cryptonote_core/account.h"
 #include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/TreeHash.h"
 #include "serialization/binary_utils.h"
 #include "cryptonote_config.h"
 
@@ -241,6 +245,11 @@ namespace cryptonote
   }
   //---------------------------------------------------------------
   bool construct_tx(const account_keys& sender_account_keys, const std::vector<tx_source_entry>& sources, const std::vector<tx_destination_entry>& destinations, std::vector<uint8_t> extra, Transaction& tx, uint64_t unlock_time)
+  {
+    return construct_tx(sender_account_keys, sources, destinations, std::move(extra), tx, unlock_time, 1);
+  }
+  //---------------------------------------------------------------
+  bool construct_tx(const account_keys& sender_account_keys, const std::vector<tx_source_entry>& sources, const std::vector<tx_destination_entry>& destinations, std::vector<uint8_t> extra, Transaction& tx, uint64_t unlock_time, size_t sign_threads)
   {
     tx.vin.clear();
     tx.vout.clear();
@@ -340,21 +349,54 @@ namespace cryptonote
     crypto::hash tx_prefix_hash;
     get_transaction_prefix_hash(tx, tx_prefix_hash);
 
+    size_t ring_keys_count = 0;
+    tx.signatures.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+      tx.signatures[i].resize(sources[i].outputs.size());
+      ring_keys_count += sources[i].outputs.size();
+    }
+
+    //inputs are signed independently of each other, so the signatures of big transactions are spread over several threads
+    std::atomic<size_t> next_input(0);
+    auto sign_inputs = [&] {
+      std::vector<const crypto::public_key*> keys_ptrs;
+      for (size_t i = next_input++; i < sources.size(); i = next_input++) {
+        const tx_source_entry& src_entr = sources[i];
+        keys_ptrs.clear();
+        for (const tx_source_entry::output_entry& o : src_entr.outputs) {
+          keys_ptrs.push_back(&o.second);
+        }
+
+        crypto::generate_ring_signature(tx_prefix_hash, boost::get<TransactionInputToKey>(tx.vin[i]).keyImage, keys_ptrs,
+          in_contexts[i].in_ephemeral.sec, src_entr.real_output, tx.signatures[i].data());
+      }
+    };
+
+    const size_t min_ring_keys_per_thread = 4;
+    size_t thread_count = std::min(sign_threads, std::min(sources.size(), ring_keys_count / min_ring_keys_per_thread));
+    if (thread_count > 1) {
+      std::vector<std::future<void>> signers;
+      for (size_t t = 1; t < thread_count; ++t) {
+        signers.push_back(std::async(std::launch::async, sign_inputs));
+      }
+
+      sign_inputs();
+      for (auto& signer : signers) {
+        signer.get();
+      }
+    } else {
+      sign_inputs();
+    }
+
     std::stringstream ss_ring_s;
     size_t i = 0;
     for (const tx_source_entry& src_entr : sources) {
       ss_ring_s << "pub_keys:" << ENDL;
-      std::vector<const crypto::public_key*> keys_ptrs;
       for (const tx_source_entry::output_entry& o : src_entr.outputs) {
-        keys_ptrs.push_back(&o.second);
         ss_ring_s << o.second << ENDL;
       }
 
-      tx.signatures.push_back(std::vector<crypto::signature>());
-      std::vector<crypto::signature>& sigs = tx.signatures.back();
-      sigs.resize(src_entr.outputs.size());
-      crypto::generate_ring_signature(tx_prefix_hash, boost::get<TransactionInputToKey>(tx.vin[i]).keyImage, keys_ptrs,
-        in_contexts[i].in_ephemeral.sec, src_entr.real_output, sigs.data());
+      const std::vector<crypto::signature>& sigs = tx.signatures[i];
       ss_ring_s << "signatures:" << ENDL;
       std::for_each(sigs.begin(), sigs.end(), [&](const crypto::signature& s){ss_ring_s << s << ENDL;});
       ss_ring_s << "prefix_hash:" << tx_prefix_hash << ENDL << "in_ephemeral_key: " << in_contexts[i].in_ephemeral.sec <<
@@ -530,14 +572,18 @@ namespace cryptonote
   }
   //---------------------------------------------------------------
   bool lookup_acc_outs(const account_keys& acc, const Transaction& tx, const crypto::public_key& tx_pub_key, std::vector<size_t>& outs, uint64_t& money_transfered)
+  {
+    crypto::key_derivation derivation;
+    generate_key_derivation(tx_pub_key, acc.m_view_secret_key, derivation);
+    return lookup_acc_outs(acc, tx, derivation, outs, money_transfered);
+  }
+  //---------------------------------------------------------------
+  bool lookup_acc_outs(const account_keys& acc, const Transaction& tx, const crypto::key_derivation& derivation, std::vector<size_t>& outs, uint64_t& money_transfered)
   {
     money_transfered = 0;
     size_t keyIndex = 0;
     size_t outputIndex = 0;
 
-    crypto::key_derivation derivation;
-    generate_key_derivation(tx_pub_key, acc.m_view_secret_key, derivation);
-
     for (const TransactionOutput& o : tx.vout) {
       assert(o.target.type() == typeid(TransactionOutputToKey) || o.target.type() == typeid(TransactionOutputMultisignature));
       if (o.target.type() == typeid(TransactionOutputToKey)) {
@@ -568,6 +614,61 @@ namespace cryptonote
     return h;
   }
   //---------------------------------------------------------------
+  void get_blob_hashes(const std::vector<blobdata>& blobs, std::vector<crypto::hash>& hashes)
+  {
+    std::vector<const void*> data(blobs.size());
+    std::vector<size_t> lengths(blobs.size());
+    for (size_t i = 0; i < blobs.size(); ++i) {
+      data[i] = blobs[i].data();
+      lengths[i] = blobs[i].size();
+    }
+
+    hashes.resize(blobs.size());
+    crypto::cn_fast_hash_multi(data.data(), lengths.data(), hashes.data(), blobs.size());
+  }
+  //---------------------------------------------------------------
+  bool get_transaction_hashes(const std::vector<const Transaction*>& txs, std::vector<crypto::hash>& hashes)
+  {
+    std::vector<blobdata> blobs(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+      if (!t_serializable_object_to_blob(*txs[i], blobs[i])) {
+        return false;
+      }
+    }
+
+    get_blob_hashes(blobs, hashes);
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool get_block_hashes(const std::vector<const Block*>& blocks, std::vector<crypto::hash>& hashes)
+  {
+    std::vector<const Transaction*> minerTxs;
+    minerTxs.reserve(blocks.size());
+    for (const Block* b : blocks) {
+      minerTxs.push_back(&b->minerTx);
+    }
+
+    std::vector<crypto::hash> minerTxHashes;
+    if (!get_transaction_hashes(minerTxs, minerTxHashes)) {
+      return false;
+    }
+
+    std::vector<blobdata> blobs(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      blobdata blob;
+      if (!get_block_id_blob(*blocks[i], minerTxHashes[i], blob)) {
+        return false;
+      }
+      // get_block_hash hashes the blob as a serialized object, with its length in front
+      if (!t_serializable_object_to_blob(blob, blobs[i])) {
+        return false;
+      }
+    }
+
+    get_blob_hashes(blobs, hashes);
+    return true;
+  }
+  //---------------------------------------------------------------
   crypto::hash get_transaction_hash(const Transaction& t)
   {
     crypto::hash h = null_hash;
@@ -588,24 +689,54 @@ namespace cryptonote
   }
   //---------------------------------------------------------------
   bool get_block_hashing_blob(const Block& b, blobdata& blob) {
+    crypto::hash minerTxHash;
+    if (!get_transaction_hash(b.minerTx, minerTxHash)) {
+      return false;
+    }
+
+    return get_block_hashing_blob(b, minerTxHash, blob);
+  }
+  //---------------------------------------------------------------
+  static bool get_block_hashing_blob(const Block& b, const crypto::hash& tree_root_hash, size_t tx_count, blobdata& blob) {
     if (!t_serializable_object_to_blob(static_cast<const BlockHeader&>(b), blob)) {
       return false;
     }
-    crypto::hash tree_root_hash = get_tx_tree_hash(b);
+
     blob.append(reinterpret_cast<const char*>(&tree_root_hash), sizeof(tree_root_hash));
-    blob.append(tools::get_varint_data(b.txHashes.size() + 1));
+    blob.append(tools::get_varint_data(tx_count));
 
     return true;
   }
   //---------------------------------------------------------------
+  bool get_block_hashing_blob(const Block& b, const crypto::hash& minerTxHash, blobdata& blob) {
+    std::vector<crypto::hash> txs_ids;
+    txs_ids.reserve(b.txHashes.size() + 1);
+    txs_ids.push_back(minerTxHash);
+    txs_ids.insert(txs_ids.end(), b.txHashes.begin(), b.txHashes.end());
+    return get_block_hashing_blob(b, get_tx_tree_hash(txs_ids), txs_ids.size(), blob);
+  }
+  //---------------------------------------------------------------
+  bool get_block_hashing_blob(const Block& b, TreeHash& txTree, blobdata& blob) {
+    crypto::hash minerTxHash;
+    if (!get_transaction_hash(b.minerTx, minerTxHash)) {
+      return false;
+    }
+
+    std::vector<crypto::hash> txs_ids;
+    txs_ids.reserve(b.txHashes.size() + 1);
+    txs_ids.push_back(minerTxHash);
+    txs_ids.insert(txs_ids.end(), b.txHashes.begin(), b.txHashes.end());
+    txTree.assign(txs_ids);
+    return get_block_hashing_blob(b, txTree.root(), txs_ids.size(), blob);
+  }
+  //---------------------------------------------------------------
   bool get_parent_block_hashing_blob(const Block& b, blobdata& blob) {
     auto serializer = makeParentBlockSerializer(b, true, true);
     return t_serializable_object_to_blob(serializer, blob);
   }
   //---------------------------------------------------------------
-  bool get_block_hash(const Block& b, crypto::hash& res) {
-    blobdata blob;
-    if (!get_block_hashing_blob(b, blob)) {
+  bool get_block_id_blob(const Block& b, const crypto::hash& minerTxHash, blobdata& blob) {
+    if (!get_block_hashing_blob(b, minerTxHash, blob)) {
       return false;
     }
 
@@ -618,6 +749,20 @@ namespace cryptonote
       blob.append(parent_blob);
     }
 
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool get_block_hash(const Block& b, crypto::hash& res) {
+    crypto::hash minerTxHash;
+    if (!get_transaction_hash(b.minerTx, minerTxHash)) {
+      return false;
+    }
+
+    blobdata blob;
+    if (!get_block_id_blob(b, minerTxHash, blob)) {
+      return false;
+    }
+
     return get_object_hash(blob, res);
   }
   //---------------------------------------------------------------
@@ -636,17 +781,48 @@ namespace cryptonote
     return get_object_hash(blob, res);
   }
   //---------------------------------------------------------------
-  bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res) {
-    blobdata bd;
+  bool get_block_longhash_blob(const Block& b, blobdata& blob) {
     if (b.majorVersion == BLOCK_MAJOR_VERSION_1) {
-      if (!get_block_hashing_blob(b, bd)) {
-        return false;
-      }
+      return get_block_hashing_blob(b, blob);
     } else if (b.majorVersion == BLOCK_MAJOR_VERSION_2) {
-      if (!get_parent_block_hashing_blob(b, bd)) {
+      return get_parent_block_hashing_blob(b, blob);
+    } else {
+      return false;
+    }
+  }
+  //---------------------------------------------------------------
+  bool get_block_longhash_blob(const Block& b, blobdata& blob, size_t& nonce_offset) {
+    if (!get_block_longhash_blob(b, blob) || !get_longhash_blob_nonce_offset(blob, nonce_offset)) {
+      return false;
+    }
+
+    assert(memcmp(&blob[nonce_offset], &b.nonce, sizeof(b.nonce)) == 0);
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool get_longhash_blob_nonce_offset(const blobdata& blob, size_t& nonce_offset) {
+    // major version, minor version and timestamp varints, then the previous block id and the nonce
+    auto it = blob.begin();
+    auto end = blob.end();
+    for (size_t i = 0; i < 3; ++i) {
+      uint64_t value;
+      if (tools::read_varint<std::numeric_limits<uint64_t>::digits>(it, end, value) <= 0) {
         return false;
       }
-    } else {
+    }
+
+    nonce_offset = std::distance(blob.begin(), it) + sizeof(crypto::hash);
+    return nonce_offset + sizeof(uint32_t) <= blob.size();
+  }
+  //---------------------------------------------------------------
+  void set_longhash_blob_nonce(blobdata& blob, size_t nonce_offset, uint32_t nonce) {
+    assert(nonce_offset + sizeof(nonce) <= blob.size());
+    memcpy(&blob[nonce_offset], &nonce, sizeof(nonce));
+  }
+  //---------------------------------------------------------------
+  bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res) {
+    blobdata bd;
+    if (!get_block_longhash_blob(b, bd)) {
       return false;
     }
     crypto::cn_slow_hash(context, bd.data(), bd.size(), res);
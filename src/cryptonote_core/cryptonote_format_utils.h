@@ -32,6 +32,8 @@
 
 namespace cryptonote
 {
+  class TreeHash;
+
   //---------------------------------------------------------------
   void get_transaction_prefix_hash(const TransactionPrefix& tx, crypto::hash& h);
   crypto::hash get_transaction_prefix_hash(const TransactionPrefix& tx);
@@ -60,6 +62,8 @@ namespace cryptonote
 
   //---------------------------------------------------------------
   bool construct_tx(const account_keys& sender_account_keys, const std::vector<tx_source_entry>& sources, const std::vector<tx_destination_entry>& destinations, std::vector<uint8_t> extra, Transaction& tx, uint64_t unlock_time);
+  //sign_threads limits how many threads sign the inputs, the overload above signs on the calling thread
+  bool construct_tx(const account_keys& sender_account_keys, const std::vector<tx_source_entry>& sources, const std::vector<tx_destination_entry>& destinations, std::vector<uint8_t> extra, Transaction& tx, uint64_t unlock_time, size_t sign_threads);
 
   template<typename T>
   bool find_tx_extra_field_by_type(const std::vector<tx_extra_field>& tx_extra_fields, T& field)
@@ -84,22 +88,39 @@ namespace cryptonote
   bool is_out_to_acc(const account_keys& acc, const TransactionOutputToKey& out_key, const crypto::public_key& tx_pub_key, size_t keyIndex);
   bool is_out_to_acc(const account_keys& acc, const TransactionOutputToKey& out_key, const crypto::key_derivation& derivation, size_t keyIndex);
   bool lookup_acc_outs(const account_keys& acc, const Transaction& tx, const crypto::public_key& tx_pub_key, std::vector<size_t>& outs, uint64_t& money_transfered);
+  // derivation of the transaction public key with acc.m_view_secret_key, for callers that derive many at once
+  bool lookup_acc_outs(const account_keys& acc, const Transaction& tx, const crypto::key_derivation& derivation, std::vector<size_t>& outs, uint64_t& money_transfered);
   bool lookup_acc_outs(const account_keys& acc, const Transaction& tx, std::vector<size_t>& outs, uint64_t& money_transfered);
   bool get_tx_fee(const Transaction& tx, uint64_t & fee);
   uint64_t get_tx_fee(const Transaction& tx);
   bool generate_key_image_helper(const account_keys& ack, const crypto::public_key& tx_public_key, size_t real_output_index, KeyPair& in_ephemeral, crypto::key_image& ki);
   void get_blob_hash(const blobdata& blob, crypto::hash& res);
   crypto::hash get_blob_hash(const blobdata& blob);
+  // bulk versions, hash several blobs at once where the cpu allows it
+  void get_blob_hashes(const std::vector<blobdata>& blobs, std::vector<crypto::hash>& hashes);
+  bool get_transaction_hashes(const std::vector<const Transaction*>& txs, std::vector<crypto::hash>& hashes);
+  bool get_block_hashes(const std::vector<const Block*>& blocks, std::vector<crypto::hash>& hashes);
   std::string short_hash_str(const crypto::hash& h);
 
   crypto::hash get_transaction_hash(const Transaction& t);
   bool get_transaction_hash(const Transaction& t, crypto::hash& res);
   bool get_transaction_hash(const Transaction& t, crypto::hash& res, size_t& blob_size);
   bool get_block_hashing_blob(const Block& b, blobdata& blob);
+  bool get_block_hashing_blob(const Block& b, const crypto::hash& minerTxHash, blobdata& blob);
+  // txTree is brought up to the transactions of b and gives the root, for callers hashing many versions of a block
+  bool get_block_hashing_blob(const Block& b, TreeHash& txTree, blobdata& blob);
+  // the blob whose object hash is the block id
+  bool get_block_id_blob(const Block& b, const crypto::hash& minerTxHash, blobdata& blob);
   bool get_parent_block_hashing_blob(const Block& b, blobdata& blob);
   bool get_aux_block_header_hash(const Block& b, crypto::hash& res);
   bool get_block_hash(const Block& b, crypto::hash& res);
   crypto::hash get_block_hash(const Block& b);
+  bool get_block_longhash_blob(const Block& b, blobdata& blob);
+  // The long hash blob of b and the position of its nonce, the blobs of other nonces differ in these 4 bytes only
+  bool get_block_longhash_blob(const Block& b, blobdata& blob, size_t& nonce_offset);
+  // Parent blocks of merge mined blocks and version 1 blocks start their long hash blobs with the same header
+  bool get_longhash_blob_nonce_offset(const blobdata& blob, size_t& nonce_offset);
+  void set_longhash_blob_nonce(blobdata& blob, size_t nonce_offset, uint32_t nonce);
   bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res);
   bool parse_and_validate_block_from_blob(const blobdata& b_blob, Block& b);
   bool get_inputs_money_amount(const Transaction& tx, uint64_t& money);
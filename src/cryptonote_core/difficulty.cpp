@@ -19,8 +19,14 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <limits>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
 #include "common/int-util.h"
 #include "crypto/hash.h"
 #include "cryptonote_config.h"
@@ -75,4 +81,79 @@ namespace cryptonote {
     carry = cadc(high, top, carry);
     return !carry;
   }
+
+  difficulty_target get_difficulty_target(difficulty_type difficulty) {
+    difficulty_target target;
+    if (difficulty == 0) {
+      std::fill(std::begin(target.words), std::end(target.words), std::numeric_limits<uint64_t>::max());
+      return target;
+    }
+    // long division of 2^256 - 1 one bit at a time, the target only changes with the difficulty
+    uint64_t rem = 0;
+    for (int i = 3; i >= 0; --i) {
+      uint64_t q = 0;
+      for (int bit = 0; bit < 64; ++bit) {
+        bool overflow = (rem >> 63) != 0;
+        rem = (rem << 1) | 1;
+        q <<= 1;
+        if (overflow || rem >= difficulty) {
+          rem -= difficulty;
+          q |= 1;
+        }
+      }
+      target.words[i] = q;
+    }
+    return target;
+  }
+
+  bool check_hash(const crypto::hash &hash, const difficulty_target &target) {
+    for (int i = 3; i >= 0; --i) {
+      uint64_t word = swap64le(((const uint64_t *) &hash)[i]);
+      if (word != target.words[i]) {
+        return word < target.words[i];
+      }
+    }
+    return true;
+  }
+
+#if BYTE_ORDER == LITTLE_ENDIAN && (defined(__AVX2__) || defined(__SSE4_2__))
+  // there is no unsigned 64 bit compare, flipping the sign bits of both sides gives the same order
+  static const uint64_t SIGN_BIT = 0x8000000000000000;
+
+  // bit i of the two masks tells whether word i of the hash is above or below the target word,
+  // the highest differing word decides, so the hash is above the target when the above mask is larger
+#if defined(__AVX2__)
+  void check_hashes(const crypto::hash *hashes, size_t count, const difficulty_target &target, bool *results) {
+    const __m256i sign = _mm256_set1_epi64x(SIGN_BIT);
+    const __m256i t = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) target.words), sign);
+    for (size_t i = 0; i < count; ++i) {
+      __m256i h = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) &hashes[i]), sign);
+      int above = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(h, t)));
+      int below = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(t, h)));
+      results[i] = above <= below;
+    }
+  }
+#else
+  void check_hashes(const crypto::hash *hashes, size_t count, const difficulty_target &target, bool *results) {
+    const __m128i sign = _mm_set1_epi64x(SIGN_BIT);
+    const __m128i tlo = _mm_xor_si128(_mm_loadu_si128((const __m128i *) target.words), sign);
+    const __m128i thi = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (target.words + 2)), sign);
+    for (size_t i = 0; i < count; ++i) {
+      __m128i hlo = _mm_xor_si128(_mm_loadu_si128((const __m128i *) &hashes[i]), sign);
+      __m128i hhi = _mm_xor_si128(_mm_loadu_si128((const __m128i *) &hashes[i] + 1), sign);
+      int above = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(hlo, tlo))) |
+        (_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(hhi, thi))) << 2);
+      int below = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(tlo, hlo))) |
+        (_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(thi, hhi))) << 2);
+      results[i] = above <= below;
+    }
+  }
+#endif
+#else
+  void check_hashes(const crypto::hash *hashes, size_t count, const difficulty_target &target, bool *results) {
+    for (size_t i = 0; i < count; ++i) {
+      results[i] = check_hash(hashes[i], target);
+    }
+  }
+#endif
 }
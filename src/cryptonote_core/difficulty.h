@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -27,4 +28,15 @@ namespace cryptonote
     typedef std::uint64_t difficulty_type;
 
     bool check_hash(const crypto::hash &hash, difficulty_type difficulty);
+
+    // (2^256 - 1) / difficulty as little endian words, a hash satisfies the difficulty
+    // exactly when it is not above this number
+    struct difficulty_target {
+      std::uint64_t words[4];
+    };
+
+    difficulty_target get_difficulty_target(difficulty_type difficulty);
+    bool check_hash(const crypto::hash &hash, const difficulty_target &target);
+    // results[i] = check_hash(hashes[i], target), for checking many hashes against one difficulty
+    void check_hashes(const crypto::hash *hashes, std::size_t count, const difficulty_target &target, bool *results);
 }
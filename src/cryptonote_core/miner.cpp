@@ -15,6 +15,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <memory>
 #include <sstream>
 #include <numeric>
 
@@ -56,6 +57,7 @@ namespace cryptonote
     m_currency(currency),
     m_stop(1),
     m_template(boost::value_initialized<Block>()),
+    m_template_nonce_offset(0),
     m_template_no(0),
     m_diffic(0),
     m_thread_index(0),
@@ -79,10 +81,16 @@ namespace cryptonote
     CRITICAL_REGION_LOCAL(m_template_lock);
     m_template = bl;
 
+    // consecutive templates mostly share their transactions, the tree rehashes only what changed
+    blobdata hashing_blob;
+    if (!cryptonote::get_block_hashing_blob(m_template, m_template_tree, hashing_blob)) {
+      return false;
+    }
+
     if (BLOCK_MAJOR_VERSION_2 == m_template.majorVersion) {
       cryptonote::tx_extra_merge_mining_tag mm_tag;
       mm_tag.depth = 0;
-      if (!cryptonote::get_aux_block_header_hash(m_template, mm_tag.merkle_root)) {
+      if (!cryptonote::get_object_hash(hashing_blob, mm_tag.merkle_root)) {
         return false;
       }
 
@@ -90,6 +98,15 @@ namespace cryptonote
       if (!cryptonote::append_mm_tag_to_extra(m_template.parentBlock.minerTx.extra, mm_tag)) {
         return false;
       }
+
+      if (!cryptonote::get_block_longhash_blob(m_template, m_template_blob, m_template_nonce_offset)) {
+        return false;
+      }
+    } else {
+      m_template_blob = hashing_blob;
+      if (!cryptonote::get_longhash_blob_nonce_offset(m_template_blob, m_template_nonce_offset)) {
+        return false;
+      }
     }
 
     m_diffic = di;
@@ -279,6 +296,11 @@ namespace cryptonote
   }
   //-----------------------------------------------------------------------------------------------------
   bool miner::find_nonce_for_given_block(crypto::cn_context &context, Block& bl, const difficulty_type& diffic) {
+    blobdata blob;
+    size_t nonceOffset;
+    if (!get_block_longhash_blob(bl, blob, nonceOffset)) {
+      return false;
+    }
 
     unsigned nthreads = std::thread::hardware_concurrency();
 
@@ -293,14 +315,11 @@ namespace cryptonote
           crypto::cn_context localctx;
           crypto::hash h;
 
-          Block lb(bl); // copy to local block
+          blobdata localBlob(blob);
 
           for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
-
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
+            set_longhash_blob_nonce(localBlob, nonceOffset, nonce);
+            crypto::cn_slow_hash(localctx, localBlob.data(), localBlob.size(), h);
 
             if (check_hash(h, diffic)) {
               foundNonce = nonce;
@@ -323,9 +342,8 @@ namespace cryptonote
     } else {
       for (; bl.nonce != std::numeric_limits<uint32_t>::max(); bl.nonce++) {
         crypto::hash h;
-        if (!get_block_longhash(context, bl, h)) {
-          return false;
-        }
+        set_longhash_blob_nonce(blob, nonceOffset, bl.nonce);
+        crypto::cn_slow_hash(context, blob.data(), blob.size(), h);
 
         if (check_hash(h, diffic)) {
           return true;
@@ -376,7 +394,22 @@ namespace cryptonote
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
-    crypto::cn_context context;
+    // every lane hashes its own nonce with its own scratchpad, the kernel interleaves them;
+    // the scratchpads are allocated here so they land on the numa node this thread runs on
+    const size_t lanes = crypto::cn_slow_hash_lanes();
+    std::vector<std::unique_ptr<crypto::cn_context>> contexts;
+    std::vector<crypto::cn_context*> contextPtrs;
+    for (size_t i = 0; i < lanes; ++i) {
+      contexts.emplace_back(new crypto::cn_context(crypto::cn_context::large_pages, true));
+      contextPtrs.push_back(contexts.back().get());
+    }
+    std::vector<blobdata> blobs(lanes);
+    std::vector<const void*> blobData(lanes);
+    std::vector<size_t> blobSizes(lanes);
+    std::vector<crypto::hash> hashes(lanes);
+    std::unique_ptr<bool[]> found(new bool[lanes]);
+    difficulty_target local_target = get_difficulty_target(local_diff);
+    size_t template_nonce_offset = 0;
     Block b;
     while(!m_stop)
     {
@@ -392,8 +425,13 @@ namespace cryptonote
         CRITICAL_REGION_BEGIN(m_template_lock);
         b = m_template;
         local_diff = m_diffic;
+        template_nonce_offset = m_template_nonce_offset;
+        for (blobdata& blob : blobs) {
+          blob = m_template_blob;
+        }
         CRITICAL_REGION_END();
         local_template_ver = m_template_no;
+        local_target = get_difficulty_target(local_diff);
         nonce = m_starter_nonce + th_local_index;
       }
 
@@ -404,16 +442,23 @@ namespace cryptonote
         continue;
       }
 
-      b.nonce = nonce;
-      crypto::hash h;
-      if (!m_stop && !get_block_longhash(context, b, h)) {
-        LOG_ERROR("Failed to get block long hash");
-        m_stop = true;
+      // the template blob only differs in the nonce from one attempt to the next
+      for (size_t i = 0; i < lanes; ++i) {
+        set_longhash_blob_nonce(blobs[i], template_nonce_offset, nonce + static_cast<uint32_t>(i) * m_threads_total);
+        blobData[i] = blobs[i].data();
+        blobSizes[i] = blobs[i].size();
       }
 
-      if (!m_stop && check_hash(h, local_diff))
-      {
+      crypto::cn_slow_hash_multi(contextPtrs.data(), blobData.data(), blobSizes.data(), hashes.data(), lanes);
+      check_hashes(hashes.data(), lanes, local_target, found.get());
+
+      for (size_t i = 0; i < lanes && !m_stop; ++i) {
+        if (!found[i]) {
+          continue;
+        }
+
         //we lucky!
+        b.nonce = nonce + static_cast<uint32_t>(i) * m_threads_total;
         ++m_config.current_extra_message_index;
         LOG_PRINT_GREEN("Found block for difficulty: " << local_diff, LOG_LEVEL_0);
         if(!m_phandler->handle_block_found(b))
@@ -424,10 +469,12 @@ namespace cryptonote
           //success update, lets update config
           epee::serialization::store_t_to_json_file(m_config, m_config_folder_path + "/" + cryptonote::parameters::MINER_CONFIG_FILE_NAME);
         }
+        // the template changes after a found block, the other lanes are stale
+        break;
       }
 
-      nonce+=m_threads_total;
-      ++m_hashes;
+      nonce += static_cast<uint32_t>(lanes) * m_threads_total;
+      m_hashes += lanes;
     }
     LOG_PRINT_L0("Miner thread stopped ["<< th_local_index << "]");
     return true;
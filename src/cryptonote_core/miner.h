@@ -29,6 +29,7 @@
 #include "cryptonote_core/Currency.h"
 #include "cryptonote_core/difficulty.h"
 #include "cryptonote_core/i_miner_handler.h"
+#include "cryptonote_core/TreeHash.h"
 
 namespace cryptonote {
   class miner {
@@ -71,6 +72,10 @@ namespace cryptonote {
     volatile uint32_t m_stop;
     epee::critical_section m_template_lock;
     Block m_template;
+    TreeHash m_template_tree;
+    // long hash blob of the template, the workers patch the nonce in place
+    blobdata m_template_blob;
+    size_t m_template_nonce_offset;
     std::atomic<uint32_t> m_template_no;
     std::atomic<uint32_t> m_starter_nonce;
     difficulty_type m_diffic;
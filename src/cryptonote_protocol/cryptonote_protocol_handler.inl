@@ -89,16 +89,20 @@ namespace cryptonote
       << std::setw(20) << "Peer id"
       << std::setw(25) << "Recv/Sent (inactive,sec)"
       << std::setw(25) << "State"
-      << std::setw(20) << "Livetime(seconds)" << ENDL;
+      << std::setw(20) << "Livetime(seconds)"
+      << std::setw(25) << "RTT(ms)/Rate(KB/s)" << ENDL;
 
     m_p2p->for_each_connection([&](const connection_context& cntxt, nodetool::peerid_type peer_id)
     {
+      nodetool::peer_metrics metrics = AUTO_VAL_INIT(metrics);
+      bool has_metrics = m_p2p->get_peer_metrics(cntxt, metrics);
       ss << std::setw(25) << std::left << std::string(cntxt.m_is_income ? " [INC]":"[OUT]") + 
         epee::string_tools::get_ip_string_from_int32(cntxt.m_remote_ip) + ":" + std::to_string(cntxt.m_remote_port) 
         << std::setw(20) << std::hex << peer_id
         << std::setw(25) << std::to_string(cntxt.m_recv_cnt)+ "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
         << std::setw(25) << get_protocol_state_string(cntxt.m_state)
-        << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
+        << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started)
+        << std::setw(25) << (has_metrics ? std::to_string(metrics.rtt) + "/" + std::to_string(metrics.throughput / 1024) : std::string("-")) << ENDL;
       return true;
     });
     LOG_PRINT_L0("Connections: " << ENDL << ss.str());
@@ -306,6 +310,19 @@ namespace cryptonote
       return 1;
     }
 
+    if(context.m_objects_request_time)
+    {
+      uint64_t bytes = 0;
+      for (const block_complete_entry& block_entry : arg.blocks) {
+        bytes += block_entry.block.size();
+        for (const auto& tx_blob : block_entry.txs) {
+          bytes += tx_blob.size();
+        }
+      }
+      m_p2p->report_peer_delivery(context, bytes, epee::misc_utils::get_tick_count() - context.m_objects_request_time);
+      context.m_objects_request_time = 0;
+    }
+
     {
       m_core.pause_mining();
       epee::misc_utils::auto_scope_leave_caller scope_exit_handler = epee::misc_utils::create_scope_leave_handler(
@@ -393,6 +410,7 @@ namespace cryptonote
         context.m_needed_objects.erase(it++);
       }
       LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size());
+      context.m_objects_request_time = epee::misc_utils::get_tick_count();
       post_notify<NOTIFY_REQUEST_GET_OBJECTS>(req, context);    
     }else if(context.m_last_response_height < context.m_remote_blockchain_height-1)
     {//we have to fetch more objects ids, request blockchain entry
@@ -31,6 +31,8 @@ namespace mining
     struct job_details_native
     {
       cryptonote::blobdata blob;
+      size_t nonce_offset;
+      uint32_t nonce;
       uint32_t target;
       std::string job_id;
     };
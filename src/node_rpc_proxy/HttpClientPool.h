@@ -0,0 +1,85 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "include_base_utils.h"
+#include "net/http_client.h"
+
+namespace cryptonote {
+
+//Keep-alive connections to the node shared by concurrent requests. A request leases an idle client, or a new one
+//when all of them are busy, and returns it when done so that the next request reuses its connection.
+class HttpClientPool {
+public:
+  typedef epee::net_utils::http::http_simple_client Client;
+
+  class Lease {
+  public:
+    Lease(HttpClientPool& pool) : m_pool(pool), m_client(pool.acquire()) {
+    }
+
+    ~Lease() {
+      m_pool.release(std::move(m_client));
+    }
+
+    Client& client() { return *m_client; }
+
+  private:
+    Lease(const Lease&);
+    Lease& operator=(const Lease&);
+
+    HttpClientPool& m_pool;
+    std::unique_ptr<Client> m_client;
+  };
+
+  void clear() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleClients.clear();
+  }
+
+  size_t idleCount() const {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_idleClients.size();
+  }
+
+private:
+  std::unique_ptr<Client> acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_idleClients.empty()) {
+      return std::unique_ptr<Client>(new Client());
+    }
+
+    std::unique_ptr<Client> client = std::move(m_idleClients.back());
+    m_idleClients.pop_back();
+    return client;
+  }
+
+  void release(std::unique_ptr<Client> client) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleClients.push_back(std::move(client));
+  }
+
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<Client> > m_idleClients;
+};
+
+}
@@ -17,6 +17,7 @@
 
 #include "NodeRpcProxy.h"
 
+#include <algorithm>
 #include <atomic>
 #include <system_error>
 #include <thread>
@@ -44,7 +45,8 @@ namespace {
 }
 
 NodeRpcProxy::NodeRpcProxy(const std::string& nodeHost, unsigned short nodePort)
-  : m_nodeAddress("http://" + nodeHost + ":" + std::to_string(nodePort))
+  : m_requestThreadCount(4)
+  , m_nodeAddress("http://" + nodeHost + ":" + std::to_string(nodePort))
   , m_rpcTimeout(10000)
   , m_pullTimer(m_ioService)
   , m_pullInterval(10000) {
@@ -57,6 +59,7 @@ NodeRpcProxy::~NodeRpcProxy() {
 
 void NodeRpcProxy::resetInternalState() {
   m_ioService.reset();
+  m_requestService.reset();
   m_observerManager.clear();
 
   m_peerCount = 0;
@@ -72,6 +75,7 @@ void NodeRpcProxy::init(const INode::Callback& callback) {
   }
 
   resetInternalState();
+  startRequestThreads();
   m_workerThread = std::thread(std::bind(&NodeRpcProxy::workerThread, this, callback));
 }
 
@@ -84,6 +88,7 @@ bool NodeRpcProxy::shutdown() {
   m_pullTimer.cancel(ignored_ec);
   m_ioService.stop();
   m_workerThread.join();
+  stopRequestThreads();
 
   m_initState.endShutdown();
   return true;
@@ -103,6 +108,27 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
   }
 }
 
+void NodeRpcProxy::startRequestThreads() {
+  m_requestWork.reset(new boost::asio::io_service::work(m_requestService));
+
+  size_t threadCount = std::max<size_t>(m_requestThreadCount, 1);
+  for (size_t i = 0; i < threadCount; ++i) {
+    m_requestThreads.push_back(std::thread([this] { m_requestService.run(); }));
+  }
+}
+
+void NodeRpcProxy::stopRequestThreads() {
+  m_requestWork.reset();
+  m_requestService.stop();
+
+  for (auto& thread: m_requestThreads) {
+    thread.join();
+  }
+
+  m_requestThreads.clear();
+  m_requestClients.clear();
+}
+
 void NodeRpcProxy::pullNodeStatusAndScheduleTheNext() {
   updateNodeStatus();
 
@@ -188,7 +214,7 @@ void NodeRpcProxy::relayTransaction(const cryptonote::Transaction& transaction,
   }
 
   // TODO: m_ioService.stop() won't inkove callback(aborted). Fix it
-  m_ioService.post(std::bind(&NodeRpcProxy::doRelayTransaction, this, transaction, callback));
+  m_requestService.post(std::bind(&NodeRpcProxy::doRelayTransaction, this, transaction, callback));
 }
 
 void NodeRpcProxy::getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint64_t outsCount, std::vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& outs, const Callback& callback) {
@@ -197,7 +223,7 @@ void NodeRpcProxy::getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint6
     return;
   }
 
-  m_ioService.post(std::bind(&NodeRpcProxy::doGetRandomOutsByAmounts, this, std::move(amounts), outsCount, std::ref(outs), callback));
+  m_requestService.post(std::bind(&NodeRpcProxy::doGetRandomOutsByAmounts, this, std::move(amounts), outsCount, std::ref(outs), callback));
 }
 
 void NodeRpcProxy::getNewBlocks(std::list<crypto::hash>&& knownBlockIds, std::list<cryptonote::block_complete_entry>& newBlocks, uint64_t& startHeight, const Callback& callback) {
@@ -206,7 +232,7 @@ void NodeRpcProxy::getNewBlocks(std::list<crypto::hash>&& knownBlockIds, std::li
     return;
   }
 
-  m_ioService.post(std::bind(&NodeRpcProxy::doGetNewBlocks, this, std::move(knownBlockIds), std::ref(newBlocks), std::ref(startHeight), callback));
+  m_requestService.post(std::bind(&NodeRpcProxy::doGetNewBlocks, this, std::move(knownBlockIds), std::ref(newBlocks), std::ref(startHeight), callback));
 }
 
 void NodeRpcProxy::getTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback) {
@@ -215,14 +241,24 @@ void NodeRpcProxy::getTransactionOutsGlobalIndices(const crypto::hash& transacti
     return;
   }
 
-  m_ioService.post(std::bind(&NodeRpcProxy::doGetTransactionOutsGlobalIndices, this, transactionHash, std::ref(outsGlobalIndices), callback));
+  m_requestService.post(std::bind(&NodeRpcProxy::doGetTransactionOutsGlobalIndices, this, transactionHash, std::ref(outsGlobalIndices), callback));
+}
+
+void NodeRpcProxy::getTransactionsOutsGlobalIndices(std::vector<crypto::hash>&& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback) {
+  if (!m_initState.initialized()) {
+    callback(make_error_code(error::NOT_INITIALIZED));
+    return;
+  }
+
+  m_requestService.post(std::bind(&NodeRpcProxy::doGetTransactionsOutsGlobalIndices, this, std::move(transactionHashes), std::ref(outsGlobalIndices), callback));
 }
 
 void NodeRpcProxy::doRelayTransaction(const cryptonote::Transaction& transaction, const Callback& callback) {
   COMMAND_RPC_SEND_RAW_TX::request req;
   COMMAND_RPC_SEND_RAW_TX::response rsp;
   req.tx_as_hex = epee::string_tools::buff_to_hex_nodelimer(cryptonote::tx_to_blob(transaction));
-  bool r = epee::net_utils::invoke_http_json_remote_command2(m_nodeAddress + "/sendrawtransaction", req, rsp, m_httpClient, m_rpcTimeout);
+  //the leased connection goes back to the pool at the end of the statement, before the callback runs
+  bool r = epee::net_utils::invoke_http_json_remote_command2(m_nodeAddress + "/sendrawtransaction", req, rsp, HttpClientPool::Lease(m_requestClients).client(), m_rpcTimeout);
   std::error_code ec = interpretJsonRpcResponse(r, rsp.status);
   callback(ec);
 }
@@ -232,7 +268,7 @@ void NodeRpcProxy::doGetRandomOutsByAmounts(std::vector<uint64_t>& amounts, uint
   COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response rsp = AUTO_VAL_INIT(rsp);
   req.amounts = std::move(amounts);
   req.outs_count = outsCount;
-  bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/getrandom_outs.bin", req, rsp, m_httpClient, m_rpcTimeout);
+  bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/getrandom_outs.bin", req, rsp, HttpClientPool::Lease(m_requestClients).client(), m_rpcTimeout);
   std::error_code ec = interpretJsonRpcResponse(r, rsp.status);
   if (!ec) {
     outs = std::move(rsp.outs);
@@ -244,7 +280,7 @@ void NodeRpcProxy::doGetNewBlocks(std::list<crypto::hash>& knownBlockIds, std::l
   cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::request req = AUTO_VAL_INIT(req);
   cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::response rsp = AUTO_VAL_INIT(rsp);
   req.block_ids = std::move(knownBlockIds);
-  bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/getblocks.bin", req, rsp, m_httpClient, m_rpcTimeout);
+  bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/getblocks.bin", req, rsp, HttpClientPool::Lease(m_requestClients).client(), m_rpcTimeout);
   std::error_code ec = interpretJsonRpcResponse(r, rsp.status);
   if (!ec) {
     newBlocks = std::move(rsp.blocks);
@@ -257,7 +293,7 @@ void NodeRpcProxy::doGetTransactionOutsGlobalIndices(const crypto::hash& transac
   cryptonote::COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::request req = AUTO_VAL_INIT(req);
   cryptonote::COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::response rsp = AUTO_VAL_INIT(rsp);
   req.txid = transactionHash;
-  bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/get_o_indexes.bin", req, rsp, m_httpClient, m_rpcTimeout);
+  bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/get_o_indexes.bin", req, rsp, HttpClientPool::Lease(m_requestClients).client(), m_rpcTimeout);
   std::error_code ec = interpretJsonRpcResponse(r, rsp.status);
   if (!ec) {
     outsGlobalIndices = std::move(rsp.o_indexes);
@@ -265,4 +301,34 @@ void NodeRpcProxy::doGetTransactionOutsGlobalIndices(const crypto::hash& transac
   callback(ec);
 }
 
+void NodeRpcProxy::doGetTransactionsOutsGlobalIndices(std::vector<crypto::hash>& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback) {
+  //the node answers at most COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES_MAX_COUNT transactions per request
+  std::vector<crypto::hash> hashes = std::move(transactionHashes);
+  std::vector<std::vector<uint64_t>> indices;
+  indices.reserve(hashes.size());
+
+  std::error_code ec;
+  for (size_t offset = 0; !ec && offset < hashes.size(); offset += COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES_MAX_COUNT) {
+    size_t count = std::min(hashes.size() - offset, COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES_MAX_COUNT);
+    cryptonote::COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request req = AUTO_VAL_INIT(req);
+    cryptonote::COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response rsp = AUTO_VAL_INIT(rsp);
+    req.txids.assign(hashes.begin() + offset, hashes.begin() + offset + count);
+    bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/get_txs_o_indexes.bin", req, rsp, HttpClientPool::Lease(m_requestClients).client(), m_rpcTimeout);
+    ec = interpretJsonRpcResponse(r, rsp.status);
+    if (!ec && rsp.txs.size() != req.txids.size()) {
+      ec = make_error_code(error::INTERNAL_NODE_ERROR);
+    }
+    if (!ec) {
+      for (auto& tx : rsp.txs) {
+        indices.push_back(std::move(tx.o_indexes));
+      }
+    }
+  }
+
+  if (!ec) {
+    outsGlobalIndices = std::move(indices);
+  }
+  callback(ec);
+}
+
 }
@@ -17,14 +17,17 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <boost/asio/io_service.hpp>
 
 #include "common/ObserverManager.h"
 #include "include_base_utils.h"
 #include "net/http_client.h"
+#include "HttpClientPool.h"
 #include "InitState.h"
 #include "INode.h"
 
@@ -49,13 +52,19 @@ public:
   virtual void getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint64_t outsCount, std::vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback);
   virtual void getNewBlocks(std::list<crypto::hash>&& knownBlockIds, std::list<cryptonote::block_complete_entry>& newBlocks, uint64_t& startHeight, const Callback& callback);
   virtual void getTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback);
+  virtual void getTransactionsOutsGlobalIndices(std::vector<crypto::hash>&& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback);
 
   unsigned int rpcTimeout() const { return m_rpcTimeout; }
   void rpcTimeout(unsigned int val) { m_rpcTimeout = val; }
+  //the number of requests in flight at once, takes effect on init
+  size_t requestThreadCount() const { return m_requestThreadCount; }
+  void requestThreadCount(size_t val) { m_requestThreadCount = val; }
 
 private:
   void resetInternalState();
   void workerThread(const Callback& initialized_callback);
+  void startRequestThreads();
+  void stopRequestThreads();
 
   void pullNodeStatusAndScheduleTheNext();
   void updateNodeStatus();
@@ -65,6 +74,7 @@ private:
   void doGetRandomOutsByAmounts(std::vector<uint64_t>& amounts, uint64_t outsCount, std::vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback);
   void doGetNewBlocks(std::list<crypto::hash>& knownBlockIds, std::list<cryptonote::block_complete_entry>& newBlocks, uint64_t& startHeight, const Callback& callback);
   void doGetTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback);
+  void doGetTransactionsOutsGlobalIndices(std::vector<crypto::hash>& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback);
 
 private:
   tools::InitState m_initState;
@@ -72,8 +82,16 @@ private:
   boost::asio::io_service m_ioService;
   tools::ObserverManager<CryptoNote::INodeObserver> m_observerManager;
 
+  //the requests run on their own threads and connections, so status polling doesn't wait for block downloads
+  boost::asio::io_service m_requestService;
+  std::unique_ptr<boost::asio::io_service::work> m_requestWork;
+  std::vector<std::thread> m_requestThreads;
+  size_t m_requestThreadCount;
+  HttpClientPool m_requestClients;
+
   std::string m_nodeAddress;
   unsigned int m_rpcTimeout;
+  //status polling connection
   epee::net_utils::http::http_simple_client m_httpClient;
 
   boost::asio::deadline_timer m_pullTimer;
@@ -21,6 +21,7 @@
 
 #include "version.h"
 #include "string_tools.h"
+#include "common/compression.h"
 #include "common/util.h"
 #include "net/net_helper.h"
 #include "math_helper.h"
@@ -372,9 +373,10 @@ namespace nodetool
     
     epee::simple_event ev;
     std::atomic<bool> hsh_result(false);
+    uint64_t invoke_started = epee::misc_utils::get_tick_count();
     
     bool r = epee::net_utils::async_invoke_remote_command2<typename COMMAND_HANDSHAKE::response>(context_.m_connection_id, COMMAND_HANDSHAKE::ID, arg, m_net_server.get_config_object(), 
-      [this, &pi, &ev, &hsh_result, &just_take_peerlist](int code, const typename COMMAND_HANDSHAKE::response& rsp, p2p_connection_context& context)
+      [this, &pi, &ev, &hsh_result, &just_take_peerlist, invoke_started](int code, const typename COMMAND_HANDSHAKE::response& rsp, p2p_connection_context& context)
     {
       epee::misc_utils::auto_scope_leave_caller scope_exit_handler = epee::misc_utils::create_scope_leave_handler([&](){ev.raise();});
 
@@ -406,7 +408,9 @@ namespace nodetool
         }
 
         pi = context.peer_id = rsp.node_data.peer_id;
+        context.support_flags = rsp.node_data.support_flags;
         m_peerlist.set_peer_just_seen(rsp.node_data.peer_id, context.m_remote_ip, context.m_remote_port);
+        m_peerlist.add_rtt_sample(get_remote_address(context), epee::misc_utils::get_tick_count() - invoke_started);
 
         if(rsp.node_data.peer_id == m_config.m_peer_id)
         {
@@ -440,9 +444,10 @@ namespace nodetool
   {
     typename COMMAND_TIMED_SYNC::request arg = AUTO_VAL_INIT(arg);
     m_payload_handler.get_payload_sync_data(arg.payload_data);
+    uint64_t invoke_started = epee::misc_utils::get_tick_count();
 
     bool r = epee::net_utils::async_invoke_remote_command2<typename COMMAND_TIMED_SYNC::response>(context_.m_connection_id, COMMAND_TIMED_SYNC::ID, arg, m_net_server.get_config_object(), 
-      [this](int code, const typename COMMAND_TIMED_SYNC::response& rsp, p2p_connection_context& context)
+      [this, invoke_started](int code, const typename COMMAND_TIMED_SYNC::response& rsp, p2p_connection_context& context)
     {
       if(code < 0)
       {
@@ -456,7 +461,10 @@ namespace nodetool
         m_net_server.get_config_object().close(context.m_connection_id );
       }
       if(!context.m_is_income)
+      {
         m_peerlist.set_peer_just_seen(context.peer_id, context.m_remote_ip, context.m_remote_port);
+        m_peerlist.add_rtt_sample(get_remote_address(context), epee::misc_utils::get_tick_count() - invoke_started);
+      }
       m_payload_handler.process_payload_sync_data(rsp.payload_data, context, false);
     });
 
@@ -550,6 +558,7 @@ namespace nodetool
         << ":" << epee::string_tools::num_to_string_fast(na.port)
         /*<< ", try " << try_count*/);
       //m_peerlist.set_peer_unreachable(pe);
+      m_peerlist.add_connection_attempt(na, false);
       return false;
     }
 
@@ -563,11 +572,13 @@ namespace nodetool
         << epee::string_tools::get_ip_string_from_int32(na.ip)
         << ":" << epee::string_tools::num_to_string_fast(na.port)
         /*<< ", try " << try_count*/);
+      m_peerlist.add_connection_attempt(na, false);
       return false;
     }
 
     if(just_take_peerlist)
     {
+      m_peerlist.add_connection_attempt(na, true);
       m_net_server.get_config_object().close(con.m_connection_id);
       LOG_PRINT_CC_GREEN(con, "CONNECTION HANDSHAKED OK AND CLOSED.", LOG_LEVEL_2);
       return true;
@@ -579,6 +590,7 @@ namespace nodetool
     time(&pe_local.last_seen);
     m_peerlist.append_with_peer_white(pe_local);
     //update last seen and push it to peerlist manager
+    m_peerlist.add_connection_attempt(na, true);
 
     LOG_PRINT_CC_GREEN(con, "CONNECTION HANDSHAKED OK.", LOG_LEVEL_2);
     return true;
@@ -594,7 +606,8 @@ namespace nodetool
     if(!local_peers_count)
       return false;//no peers
 
-    size_t max_random_index = std::min<uint64_t>(local_peers_count -1, 20);
+    //white peers are picked favouring recently seen ones, gray peers are picked uniformly
+    size_t max_random_index = use_white_list ? std::min<uint64_t>(local_peers_count -1, 20) : local_peers_count - 1;
 
     std::set<size_t> tried_peers;
 
@@ -602,32 +615,45 @@ namespace nodetool
     size_t rand_count = 0;
     while(rand_count < (max_random_index+1)*3 &&  try_count < 10 && !m_net_server.is_stop_signal_sent())
     {
-      ++rand_count;
-      size_t random_index = get_random_index_with_fixed_probability(max_random_index);
-      CHECK_AND_ASSERT_MES(random_index < local_peers_count, false, "random_starter_index < peers_local.size() failed!!");
+      //pick a few random peers and try them starting from the cheapest one
+      std::multimap<uint64_t, peerlist_entry> candidates;
+      while(candidates.size() < cryptonote::P2P_DEFAULT_PEER_SELECTION_CANDIDATES && rand_count < (max_random_index+1)*3 && try_count < 10)
+      {
+        ++rand_count;
+        size_t random_index = use_white_list ? get_random_index_with_fixed_probability(max_random_index) : crypto::rand<size_t>() % local_peers_count;
+        CHECK_AND_ASSERT_MES(random_index < local_peers_count, false, "random_starter_index < peers_local.size() failed!!");
 
-      if(tried_peers.count(random_index))
-        continue;
+        if(tried_peers.count(random_index))
+          continue;
 
-      tried_peers.insert(random_index);
-      peerlist_entry pe = AUTO_VAL_INIT(pe);
-      bool r = use_white_list ? m_peerlist.get_white_peer_by_index(pe, random_index):m_peerlist.get_gray_peer_by_index(pe, random_index);
-      CHECK_AND_ASSERT_MES(r, false, "Failed to get random peer from peerlist(white:" << use_white_list << ")");
+        tried_peers.insert(random_index);
+        peerlist_entry pe = AUTO_VAL_INIT(pe);
+        bool r = use_white_list ? m_peerlist.get_white_peer_by_index(pe, random_index):m_peerlist.get_gray_peer_by_random_index(pe, random_index);
+        CHECK_AND_ASSERT_MES(r, false, "Failed to get random peer from peerlist(white:" << use_white_list << ")");
 
-      ++try_count;
+        ++try_count;
 
-      if(is_peer_used(pe))
-        continue;
+        if(is_peer_used(pe))
+          continue;
 
-      LOG_PRINT_L1("Selected peer: " << pe.id << " " << epee::string_tools::get_ip_string_from_int32(pe.adr.ip)
-                    << ":" << boost::lexical_cast<std::string>(pe.adr.port)
-                    << "[white=" << use_white_list
-                    << "] last_seen: " << (pe.last_seen ? epee::misc_utils::get_time_interval_string(time(NULL) - pe.last_seen) : "never"));
-      
-      if(!try_to_connect_and_handshake_with_new_peer(pe.adr, false, pe.last_seen, use_white_list))
-        continue;
+        candidates.insert(std::make_pair(m_peerlist.get_peer_cost(pe.adr), pe));
+      }
 
-      return true;
+      for(const auto& candidate: candidates)
+      {
+        if(m_net_server.is_stop_signal_sent())
+          return false;
+
+        const peerlist_entry& pe = candidate.second;
+        LOG_PRINT_L1("Selected peer: " << pe.id << " " << epee::string_tools::get_ip_string_from_int32(pe.adr.ip)
+                      << ":" << boost::lexical_cast<std::string>(pe.adr.port)
+                      << "[white=" << use_white_list
+                      << "] last_seen: " << (pe.last_seen ? epee::misc_utils::get_time_interval_string(time(NULL) - pe.last_seen) : "never")
+                      << " cost: " << candidate.first);
+
+        if(try_to_connect_and_handshake_with_new_peer(pe.adr, false, pe.last_seen, use_white_list))
+          return true;
+      }
     }
     return false;
   }
@@ -793,9 +819,39 @@ namespace nodetool
     else 
       node_data.my_port = 0;
     node_data.network_id = m_network_id;
+    node_data.support_flags = tools::compression::is_available() ? P2P_SUPPORT_FLAG_COMPRESSION : 0;
     return true;
   }
   //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  bool node_server<t_payload_net_handler>::is_compression_supported(const boost::uuids::uuid& connection_id)
+  {
+    bool supported = false;
+    m_net_server.get_config_object().foreach_connection([&](const p2p_connection_context& cntxt)
+    {
+      if(cntxt.m_connection_id != connection_id)
+        return true;
+      supported = 0 != (cntxt.support_flags & P2P_SUPPORT_FLAG_COMPRESSION);
+      return false;
+    });
+    return supported;
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  bool node_server<t_payload_net_handler>::compress_notify(int command, const std::string& data_buff, std::string& compressed_buff)
+  {
+    if(data_buff.size() < cryptonote::P2P_DEFAULT_COMPRESSION_THRESHOLD)
+      return false;
+
+    NOTIFY_COMPRESSED_PAYLOAD::request req;
+    req.command = command;
+    req.original_size = data_buff.size();
+    if(!tools::compression::compress(data_buff, req.payload) || req.payload.size() >= data_buff.size())
+      return false;
+
+    return epee::serialization::store_t_to_binary(req, compressed_buff);
+  }
+  //-----------------------------------------------------------------------------------
 #ifdef ALLOW_DEBUG_COMMANDS
   template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::check_trust(const proof_of_trust& tr)
@@ -889,13 +945,33 @@ namespace nodetool
   bool node_server<t_payload_net_handler>::relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context)
   {
     std::list<boost::uuids::uuid> connections;
+    std::list<boost::uuids::uuid> compressing_connections;
     m_net_server.get_config_object().foreach_connection([&](const p2p_connection_context& cntxt)
     {
       if(cntxt.peer_id && context.m_connection_id != cntxt.m_connection_id)
-        connections.push_back(cntxt.m_connection_id);
+      {
+        if(cntxt.support_flags & P2P_SUPPORT_FLAG_COMPRESSION)
+          compressing_connections.push_back(cntxt.m_connection_id);
+        else
+          connections.push_back(cntxt.m_connection_id);
+      }
       return true;
     });
 
+    //compress once for all capable peers
+    std::string compressed_buff;
+    if(!compressing_connections.empty() && compress_notify(command, data_buff, compressed_buff))
+    {
+      BOOST_FOREACH(const auto& c_id, compressing_connections)
+      {
+        m_net_server.get_config_object().notify(NOTIFY_COMPRESSED_PAYLOAD::ID, compressed_buff, c_id);
+      }
+    }
+    else
+    {
+      connections.splice(connections.end(), compressing_connections);
+    }
+
     BOOST_FOREACH(const auto& c_id, connections)
     {
       m_net_server.get_config_object().notify(command, data_buff, c_id);
@@ -912,6 +988,14 @@ namespace nodetool
   template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context)
   {
+    std::string compressed_buff;
+    if(req_buff.size() >= cryptonote::P2P_DEFAULT_COMPRESSION_THRESHOLD && is_compression_supported(context.m_connection_id) &&
+      compress_notify(command, req_buff, compressed_buff))
+    {
+      int res = m_net_server.get_config_object().notify(NOTIFY_COMPRESSED_PAYLOAD::ID, compressed_buff, context.m_connection_id);
+      return res > 0;
+    }
+
     int res = m_net_server.get_config_object().notify(command, req_buff, context.m_connection_id);
     return res > 0;
   }
@@ -924,6 +1008,32 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
+  net_address node_server<t_payload_net_handler>::get_remote_address(const epee::net_utils::connection_context_base& context)
+  {
+    net_address addr = AUTO_VAL_INIT(addr);
+    addr.ip = context.m_remote_ip;
+    addr.port = context.m_remote_port;
+    return addr;
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  void node_server<t_payload_net_handler>::report_peer_delivery(const epee::net_utils::connection_context_base& context, uint64_t bytes, uint64_t elapsed_ms)
+  {
+    //remote port of incoming connection is not the port peer listens on
+    if(context.m_is_income)
+      return;
+    m_peerlist.add_delivery_sample(get_remote_address(context), bytes, elapsed_ms);
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  bool node_server<t_payload_net_handler>::get_peer_metrics(const epee::net_utils::connection_context_base& context, peer_metrics& metrics)
+  {
+    if(context.m_is_income)
+      return false;
+    return m_peerlist.get_peer_metrics(get_remote_address(context), metrics);
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::drop_connection(const epee::net_utils::connection_context_base& context)
   {
     m_net_server.get_config_object().close(context.m_connection_id);
@@ -942,7 +1052,10 @@ namespace nodetool
     std::string ip = epee::string_tools::get_ip_string_from_int32(actual_ip);
     std::string port = epee::string_tools::num_to_string_fast(node_data.my_port);
     peerid_type pr = node_data.peer_id;
-    bool r = m_net_server.connect_async(ip, port, m_config.m_net_config.ping_connection_timeout, [cb, /*context,*/ ip, port, pr, this](
+    net_address ping_addr = AUTO_VAL_INIT(ping_addr);
+    ping_addr.ip = actual_ip;
+    ping_addr.port = node_data.my_port;
+    bool r = m_net_server.connect_async(ip, port, m_config.m_net_config.ping_connection_timeout, [cb, /*context,*/ ip, port, pr, ping_addr, this](
       const typename net_server::t_connection_context& ping_context,
       const boost::system::error_code& ec)->bool
     {
@@ -958,6 +1071,7 @@ namespace nodetool
       std::string port_=port;
       peerid_type pr_ = pr;
       auto cb_ = cb;*/
+      uint64_t invoke_started = epee::misc_utils::get_tick_count();
       bool inv_call_res = epee::net_utils::async_invoke_remote_command2<COMMAND_PING::response>(ping_context.m_connection_id, COMMAND_PING::ID, req, m_net_server.get_config_object(),
         [=](int code, const COMMAND_PING::response& rsp, p2p_connection_context& context)
       {
@@ -974,6 +1088,7 @@ namespace nodetool
         }
         m_net_server.get_config_object().close(ping_context.m_connection_id);
         cb();
+        m_peerlist.add_rtt_sample(ping_addr, epee::misc_utils::get_tick_count() - invoke_started);
       });
 
       if(!inv_call_res)
@@ -1041,6 +1156,7 @@ namespace nodetool
     }
     //associate peer_id with this connection
     context.peer_id = arg.node_data.peer_id;
+    context.support_flags = arg.node_data.support_flags;
 
     if(arg.node_data.peer_id != m_config.m_peer_id && arg.node_data.my_port)
     {
@@ -1078,6 +1194,37 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
+  int node_server<t_payload_net_handler>::handle_compressed_payload(int command, NOTIFY_COMPRESSED_PAYLOAD::request& arg, p2p_connection_context& context)
+  {
+    if(!context.peer_id)
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_COMPRESSED_PAYLOAD came before handshake, dropping connection");
+      drop_connection(context);
+      return 1;
+    }
+
+    if(NOTIFY_COMPRESSED_PAYLOAD::ID == arg.command || arg.original_size > m_net_server.get_config_object().m_max_packet_size)
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_COMPRESSED_PAYLOAD came with wrong command " << arg.command << " or size " << arg.original_size << ", dropping connection");
+      drop_connection(context);
+      return 1;
+    }
+
+    std::string data_buff;
+    if(!tools::compression::decompress(arg.payload, static_cast<size_t>(arg.original_size), data_buff) || data_buff.size() != arg.original_size)
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_COMPRESSED_PAYLOAD: failed to decompress payload for command " << arg.command << ", dropping connection");
+      drop_connection(context);
+      return 1;
+    }
+
+    LOG_PRINT_CCONTEXT_L3("NOTIFY_COMPRESSED_PAYLOAD: command " << arg.command << ", " << arg.payload.size() << " -> " << data_buff.size() << " bytes");
+    bool handled = false;
+    std::string fake_str;
+    return handle_invoke_map(true, arg.command, data_buff, fake_str, context, handled);
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::log_peerlist()
   {
     std::list<peerlist_entry> pl_wite;
@@ -1101,9 +1248,12 @@ namespace nodetool
     std::stringstream ss;
     m_net_server.get_config_object().foreach_connection([&](const p2p_connection_context& cntxt)
     {
+      peer_metrics metrics = AUTO_VAL_INIT(metrics);
+      get_peer_metrics(cntxt, metrics);
       ss << epee::string_tools::get_ip_string_from_int32(cntxt.m_remote_ip) << ":" << cntxt.m_remote_port
         << " \t\tpeer_id " << cntxt.peer_id
         << " \t\tconn_id " << epee::string_tools::get_str_from_guid_a(cntxt.m_connection_id) << (cntxt.m_is_income ? " INC":" OUT")
+        << " \t\trtt " << metrics.rtt << " ms, " << metrics.throughput / 1024 << " KB/s"
         << std::endl;
       return true;
     });
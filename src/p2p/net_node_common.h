@@ -27,6 +27,14 @@ namespace nodetool
   typedef boost::uuids::uuid net_connection_id;
   typedef uint64_t peerid_type;
 
+  struct peer_metrics
+  {
+    uint32_t rtt;           //smoothed round trip time, ms, 0 if never measured
+    uint64_t throughput;    //smoothed block delivery rate, bytes per second, 0 if never measured
+    uint32_t attempts;      //outgoing connection attempts
+    uint32_t failures;      //failed outgoing connects and handshakes
+  };
+
   template<class t_connection_context>
   struct i_p2p_endpoint
   {
@@ -37,6 +45,8 @@ namespace nodetool
     virtual void request_callback(const epee::net_utils::connection_context_base& context)=0;
     virtual uint64_t get_connections_count()=0;
     virtual void for_each_connection(std::function<bool(t_connection_context&, peerid_type)> f)=0;
+    virtual void report_peer_delivery(const epee::net_utils::connection_context_base& context, uint64_t bytes, uint64_t elapsed_ms)=0;
+    virtual bool get_peer_metrics(const epee::net_utils::connection_context_base& context, peer_metrics& metrics)=0;
   };
 
   template<class t_connection_context>
@@ -67,6 +77,16 @@ namespace nodetool
 
     }
 
+    virtual void report_peer_delivery(const epee::net_utils::connection_context_base& context, uint64_t bytes, uint64_t elapsed_ms)
+    {
+
+    }
+
+    virtual bool get_peer_metrics(const epee::net_utils::connection_context_base& context, peer_metrics& metrics)
+    {
+      return false;
+    }
+
     virtual uint64_t get_connections_count()    
     {
       return false;
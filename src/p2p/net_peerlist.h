@@ -28,7 +28,9 @@
 #include <boost/serialization/version.hpp>
 
 #include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/member.hpp>
 
@@ -36,6 +38,7 @@
 #include "syncobj.h"
 #include "net/local_ip.h"
 #include "p2p_protocol_defs.h"
+#include "net_node_common.h"
 #include "cryptonote_config.h"
 #include "net_peerlist_boost_serialization.h"
 
@@ -60,6 +63,7 @@ namespace nodetool
     bool get_peerlist_full(std::list<peerlist_entry>& pl_gray, std::list<peerlist_entry>& pl_white);
     bool get_white_peer_by_index(peerlist_entry& p, size_t i);
     bool get_gray_peer_by_index(peerlist_entry& p, size_t i);
+    bool get_gray_peer_by_random_index(peerlist_entry& p, size_t i);
     bool append_with_peer_white(const peerlist_entry& pr);
     bool append_with_peer_gray(const peerlist_entry& pr);
     bool set_peer_just_seen(peerid_type peer, uint32_t ip, uint32_t port);
@@ -69,11 +73,19 @@ namespace nodetool
     void trim_white_peerlist();
     void trim_gray_peerlist();
 
+    void add_connection_attempt(const net_address& addr, bool succeeded);
+    void add_rtt_sample(const net_address& addr, uint64_t rtt_ms);
+    void add_delivery_sample(const net_address& addr, uint64_t bytes, uint64_t elapsed_ms);
+    bool get_peer_metrics(const net_address& addr, peer_metrics& metrics);
+    void get_peer_metrics_all(std::list<std::pair<net_address, peer_metrics> >& metrics);
+    uint64_t get_peer_cost(const net_address& addr);
+
     
   private:
     struct by_time{};
     struct by_id{};
     struct by_addr{};
+    struct by_random{};
 
     struct modify_all_but_id
     {
@@ -113,12 +125,23 @@ namespace nodetool
       peerlist_entry,
       boost::multi_index::indexed_by<
       // access by peerlist_entry::net_adress
-      boost::multi_index::ordered_unique<boost::multi_index::tag<by_addr>, boost::multi_index::member<peerlist_entry,net_address,&peerlist_entry::adr> >,
+      boost::multi_index::hashed_unique<boost::multi_index::tag<by_addr>, boost::multi_index::member<peerlist_entry,net_address,&peerlist_entry::adr> >,
       // sort by peerlist_entry::last_seen<
-      boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_time>, boost::multi_index::member<peerlist_entry,time_t,&peerlist_entry::last_seen> >
+      boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_time>, boost::multi_index::member<peerlist_entry,time_t,&peerlist_entry::last_seen> >,
+      // uniform random pick
+      boost::multi_index::random_access<boost::multi_index::tag<by_random> >
       > 
     > peers_indexed;
 
+    //layout stored by version 4
+    typedef boost::multi_index_container<
+      peerlist_entry,
+      boost::multi_index::indexed_by<
+      boost::multi_index::ordered_unique<boost::multi_index::tag<by_addr>, boost::multi_index::member<peerlist_entry,net_address,&peerlist_entry::adr> >,
+      boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_time>, boost::multi_index::member<peerlist_entry,time_t,&peerlist_entry::last_seen> >
+      > 
+    > peers_indexed_v4;
+
     typedef boost::multi_index_container<
       peerlist_entry,
       boost::multi_index::indexed_by<
@@ -146,12 +169,26 @@ namespace nodetool
         peers_indexed_from_old(pio, m_peers_white);
         return;
       }
+      if(ver < 5)
+      {
+        peers_indexed_v4 white_v4, gray_v4;
+        a & white_v4;
+        a & gray_v4;
+        peers_indexed_from_old(white_v4, m_peers_white);
+        peers_indexed_from_old(gray_v4, m_peers_gray);
+        return;
+      }
       a & m_peers_white;
       a & m_peers_gray;
+      a & m_peer_metrics;
     }
 
   private: 
-    bool peers_indexed_from_old(const peers_indexed_old& pio, peers_indexed& pi);
+    template<class t_old_container>
+    bool peers_indexed_from_old(const t_old_container& pio, peers_indexed& pi);
+    bool insert_gray_peer(const peerlist_entry& ple);
+    bool is_peer_known(const net_address& addr);
+    void erase_peer_metrics_if_unknown(const net_address& addr);
 
     friend class boost::serialization::access;
     epee::critical_section m_peerlist_lock;
@@ -161,6 +198,7 @@ namespace nodetool
 
     peers_indexed m_peers_gray;
     peers_indexed m_peers_white;
+    std::map<net_address, peer_metrics> m_peer_metrics;
   };
   //--------------------------------------------------------------------------------------------------
   inline
@@ -176,8 +214,9 @@ namespace nodetool
     return true;
   }
   //--------------------------------------------------------------------------------------------------
+  template<class t_old_container>
   inline 
-  bool peerlist_manager::peers_indexed_from_old(const peers_indexed_old& pio, peers_indexed& pi)
+  bool peerlist_manager::peers_indexed_from_old(const t_old_container& pio, peers_indexed& pi)
   {
     for(auto x: pio)
     {
@@ -191,33 +230,49 @@ namespace nodetool
     return true;
   }
   //--------------------------------------------------------------------------------------------------
-  inline void peerlist_manager::trim_white_peerlist()
+  inline void peerlist_manager::trim_gray_peerlist()
   {
     while(m_peers_gray.size() > cryptonote::P2P_LOCAL_GRAY_PEERLIST_LIMIT)
     {
       peers_indexed::index<by_time>::type& sorted_index=m_peers_gray.get<by_time>();
+      net_address addr = sorted_index.begin()->adr;
       sorted_index.erase(sorted_index.begin());
+      erase_peer_metrics_if_unknown(addr);
     }
   }
   //--------------------------------------------------------------------------------------------------
-  inline void peerlist_manager::trim_gray_peerlist()
+  inline void peerlist_manager::trim_white_peerlist()
   {
     while(m_peers_white.size() > cryptonote::P2P_LOCAL_WHITE_PEERLIST_LIMIT)
     {
       peers_indexed::index<by_time>::type& sorted_index=m_peers_white.get<by_time>();
+      net_address addr = sorted_index.begin()->adr;
       sorted_index.erase(sorted_index.begin());
+      erase_peer_metrics_if_unknown(addr);
     }
   }
   //--------------------------------------------------------------------------------------------------
+  inline bool peerlist_manager::is_peer_known(const net_address& addr)
+  {
+    return m_peers_white.get<by_addr>().count(addr) || m_peers_gray.get<by_addr>().count(addr);
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline void peerlist_manager::erase_peer_metrics_if_unknown(const net_address& addr)
+  {
+    if(!is_peer_known(addr))
+      m_peer_metrics.erase(addr);
+  }
+  //--------------------------------------------------------------------------------------------------
   inline 
   bool peerlist_manager::merge_peerlist(const std::list<peerlist_entry>& outer_bs)
   {
     CRITICAL_REGION_LOCAL(m_peerlist_lock);
     BOOST_FOREACH(const peerlist_entry& be,  outer_bs)
     {
-      append_with_peer_gray(be);
+      if(is_ip_allowed(be.adr.ip))
+        insert_gray_peer(be);
     }
-    // delete extra elements
+    // delete extra elements once for the whole batch
     trim_gray_peerlist();    
     return true;
   }
@@ -246,6 +301,18 @@ namespace nodetool
     return true;
   }
   //--------------------------------------------------------------------------------------------------
+  inline
+  bool peerlist_manager::get_gray_peer_by_random_index(peerlist_entry& p, size_t i)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    if(i >= m_peers_gray.size())
+      return false;
+
+    //positions in this index do not depend on last_seen, uniform i gives uniform pick
+    p = m_peers_gray.get<by_random>()[i];
+    return true;
+  }
+  //--------------------------------------------------------------------------------------------------
   inline 
   bool peerlist_manager::is_ip_allowed(uint32_t ip)
   {
@@ -357,28 +424,112 @@ namespace nodetool
       return true;
 
     CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    if(insert_gray_peer(ple))
+      trim_gray_peerlist();
+    return true;
+    CATCH_ENTRY_L0("peerlist_manager::append_with_peer_gray()", false);
+    return true;
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  bool peerlist_manager::insert_gray_peer(const peerlist_entry& ple)
+  {
     //find in white list
     auto by_addr_it_wt = m_peers_white.get<by_addr>().find(ple.adr);
     if(by_addr_it_wt != m_peers_white.get<by_addr>().end())
-      return true;
+      return false;
 
     //update gray list
     auto by_addr_it_gr = m_peers_gray.get<by_addr>().find(ple.adr);
     if(by_addr_it_gr == m_peers_gray.get<by_addr>().end())
     {
-      //put new record into white list
+      //put new record into gray list
       m_peers_gray.insert(ple);
-      trim_gray_peerlist();    
-    }else
+      return true;
+    }
+
+    //update record in gray list
+    m_peers_gray.get<by_addr>().replace(by_addr_it_gr, ple);
+    return false;
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  void peerlist_manager::add_connection_attempt(const net_address& addr, bool succeeded)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    if(!is_peer_known(addr))
+      return;
+    peer_metrics& metrics = m_peer_metrics[addr];
+    ++metrics.attempts;
+    if(!succeeded)
+      ++metrics.failures;
+
+    //keep failure rate responsive to recent behaviour
+    if(metrics.attempts > cryptonote::P2P_PEER_METRICS_ATTEMPTS_WINDOW)
     {
-      //update record in white list 
-      m_peers_gray.replace(by_addr_it_gr, ple);      
+      metrics.attempts /= 2;
+      metrics.failures /= 2;
     }
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  void peerlist_manager::add_rtt_sample(const net_address& addr, uint64_t rtt_ms)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    if(!is_peer_known(addr))
+      return;
+    peer_metrics& metrics = m_peer_metrics[addr];
+    uint32_t rtt = static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>(rtt_ms, 1), cryptonote::P2P_DEFAULT_INVOKE_TIMEOUT));
+    metrics.rtt = metrics.rtt ? (metrics.rtt * 3 + rtt) / 4 : rtt;
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  void peerlist_manager::add_delivery_sample(const net_address& addr, uint64_t bytes, uint64_t elapsed_ms)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    if(!is_peer_known(addr))
+      return;
+    peer_metrics& metrics = m_peer_metrics[addr];
+    uint64_t throughput = bytes * 1000 / std::max<uint64_t>(elapsed_ms, 1);
+    metrics.throughput = metrics.throughput ? (metrics.throughput * 3 + throughput) / 4 : throughput;
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  bool peerlist_manager::get_peer_metrics(const net_address& addr, peer_metrics& metrics)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    auto it = m_peer_metrics.find(addr);
+    if(it == m_peer_metrics.end())
+      return false;
+    metrics = it->second;
     return true;
-    CATCH_ENTRY_L0("peerlist_manager::append_with_peer_gray()", false);
-    return true;
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  void peerlist_manager::get_peer_metrics_all(std::list<std::pair<net_address, peer_metrics> >& metrics)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    metrics.insert(metrics.end(), m_peer_metrics.begin(), m_peer_metrics.end());
+  }
+  //--------------------------------------------------------------------------------------------------
+  inline
+  uint64_t peerlist_manager::get_peer_cost(const net_address& addr)
+  {
+    //expected cost of using the peer, lower is better; peers without history get neutral values
+    peer_metrics metrics = AUTO_VAL_INIT(metrics);
+    get_peer_metrics(addr, metrics);
+
+    uint64_t cost = metrics.rtt ? metrics.rtt : cryptonote::P2P_PEER_METRICS_DEFAULT_RTT;
+    //scale by 1/success_rate
+    cost = cost * (metrics.attempts + 1) / (metrics.attempts - metrics.failures + 1);
+    if(metrics.throughput)
+    {
+      //ranges from 2x for a stalled peer to ~0 for a very fast one
+      cost = cost * 2 * cryptonote::P2P_PEER_METRICS_REFERENCE_THROUGHPUT / (cryptonote::P2P_PEER_METRICS_REFERENCE_THROUGHPUT + metrics.throughput);
+    }
+    return cost;
   }
   //--------------------------------------------------------------------------------------------------
 }
 
-BOOST_CLASS_VERSION(nodetool::peerlist_manager, 4)
+BOOST_CLASS_VERSION(nodetool::peerlist_manager, 5)
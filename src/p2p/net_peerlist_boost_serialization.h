@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/utility.hpp>
+
+#include "net_node_common.h"
+
 namespace boost
 {
   namespace serialization
@@ -36,6 +41,15 @@ namespace boost
       a & pl.adr;
       a & pl.id;
       a & pl.last_seen;
-    }    
+    }
+
+    template <class Archive, class ver_type>
+    inline void serialize(Archive &a,  nodetool::peer_metrics& pm, const ver_type ver)
+    {
+      a & pm.rtt;
+      a & pm.throughput;
+      a & pm.attempts;
+      a & pm.failures;
+    }
   }
 }
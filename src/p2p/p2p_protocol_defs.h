@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <boost/functional/hash.hpp>
 #include <boost/uuid/uuid.hpp>
 
 #include "serialization/keyvalue_serialization.h"
@@ -67,6 +68,15 @@ namespace nodetool
   {
     return  memcmp(&a, &b, sizeof(a)) == 0;
   }
+
+  inline
+  size_t hash_value(const net_address& na)
+  {
+    size_t seed = 0;
+    boost::hash_combine(seed, na.ip);
+    boost::hash_combine(seed, na.port);
+    return seed;
+  }
   inline 
   std::string print_peerlist_to_string(const std::list<peerlist_entry>& pl)
   {
@@ -106,14 +116,18 @@ namespace nodetool
     uint64_t local_time;
     uint32_t my_port;
     peerid_type peer_id;
+    uint32_t support_flags;
 
     BEGIN_KV_SERIALIZE_MAP()
       KV_SERIALIZE_VAL_POD_AS_BLOB(network_id)
       KV_SERIALIZE(peer_id)
       KV_SERIALIZE(local_time)
       KV_SERIALIZE(my_port)
+      KV_SERIALIZE(support_flags)
     END_KV_SERIALIZE_MAP()
   };
+
+#define P2P_SUPPORT_FLAG_COMPRESSION 0x00000001 //peer accepts NOTIFY_COMPRESSED_PAYLOAD
   
 
 #define P2P_COMMANDS_POOL_BASE 1000
@@ -217,6 +231,31 @@ namespace nodetool
     };
   };
 
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_COMPRESSED_PAYLOAD
+  {
+    /*
+      Wraps another notification whose body was compressed by the sender.
+      Only sent to peers which announced P2P_SUPPORT_FLAG_COMPRESSION in handshake.
+    */
+    const static int ID = P2P_COMMANDS_POOL_BASE + 7;
+
+    struct request
+    {
+      uint32_t command;
+      uint64_t original_size;
+      std::string payload;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(command)
+        KV_SERIALIZE(original_size)
+        KV_SERIALIZE(payload)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
   
 #ifdef ALLOW_DEBUG_COMMANDS
   //These commands are considered as insecure, and made in debug purposes for a limited lifetime. 
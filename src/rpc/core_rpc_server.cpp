@@ -102,6 +102,23 @@ namespace cryptonote
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_peer_stats(const COMMAND_RPC_GET_PEER_STATS::request& req, COMMAND_RPC_GET_PEER_STATS::response& res, connection_context& cntx)
+  {
+    std::list<std::pair<nodetool::net_address, nodetool::peer_metrics> > metrics;
+    m_p2p.get_peerlist_manager().get_peer_metrics_all(metrics);
+    for (const auto& m : metrics) {
+      peer_stats_entry entry;
+      entry.address = epee::string_tools::get_ip_string_from_int32(m.first.ip) + ":" + std::to_string(m.first.port);
+      entry.rtt = m.second.rtt;
+      entry.throughput = m.second.throughput;
+      entry.attempts = m.second.attempts;
+      entry.failures = m.second.failures;
+      res.peers.push_back(entry);
+    }
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res, connection_context& cntx)
   {
     CHECK_CORE_READY();
@@ -242,6 +259,30 @@ namespace cryptonote
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_txs_indexes(const COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response& res, connection_context& cntx)
+  {
+    CHECK_CORE_READY();
+    if (req.txids.size() > COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES_MAX_COUNT)
+    {
+      res.status = "Failed, too many transactions requested";
+      return true;
+    }
+
+    res.txs.resize(req.txids.size());
+    for (size_t i = 0; i < req.txids.size(); ++i)
+    {
+      if (!m_core.get_tx_outputs_gindexs(req.txids[i], res.txs[i].o_indexes))
+      {
+        res.txs.clear();
+        res.status = "Failed";
+        return true;
+      }
+    }
+    res.status = CORE_RPC_STATUS_OK;
+    LOG_PRINT_L2("COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES: [" << res.txs.size() << "]");
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_get_transactions(const COMMAND_RPC_GET_TRANSACTIONS::request& req, COMMAND_RPC_GET_TRANSACTIONS::response& res, connection_context& cntx)
   {
     CHECK_CORE_READY();
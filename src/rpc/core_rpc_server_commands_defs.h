@@ -124,6 +124,36 @@ namespace cryptonote
     };
   };
   //-----------------------------------------------
+  struct tx_global_outputs_indexes
+  {
+    std::vector<uint64_t> o_indexes;
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(o_indexes)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES
+  {
+    struct request
+    {
+      std::vector<crypto::hash> txids;
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(txids)
+      END_KV_SERIALIZE_MAP()
+    };
+
+
+    struct response
+    {
+      std::vector<tx_global_outputs_indexes> txs; //in the same order as request txids
+      std::string status;
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(txs)
+        KV_SERIALIZE(status)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+  //-----------------------------------------------
   struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request
   {
     std::vector<uint64_t> amounts;
@@ -257,6 +287,46 @@ namespace cryptonote
     };
   };
 
+
+  //-----------------------------------------------
+  struct peer_stats_entry
+  {
+    std::string address;
+    uint32_t rtt;
+    uint64_t throughput;
+    uint32_t attempts;
+    uint32_t failures;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(address)
+      KV_SERIALIZE(rtt)
+      KV_SERIALIZE(throughput)
+      KV_SERIALIZE(attempts)
+      KV_SERIALIZE(failures)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct COMMAND_RPC_GET_PEER_STATS
+  {
+    struct request
+    {
+
+      BEGIN_KV_SERIALIZE_MAP()
+      END_KV_SERIALIZE_MAP()
+    };
+
+    struct response
+    {
+      std::list<peer_stats_entry> peers;
+      std::string status;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(peers)
+        KV_SERIALIZE(status)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
     
   //-----------------------------------------------
   struct COMMAND_RPC_STOP_MINING
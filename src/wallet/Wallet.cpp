@@ -21,6 +21,7 @@
 #include "serialization/binary_utils.h"
 #include "storages/portable_storage_template_helper.h"
 #include "WalletUtils.h"
+#include "WalletJournal.h"
 
 #include <exception>
 #include <algorithm>
@@ -40,6 +41,12 @@
 
 namespace {
 
+const uint8_t SNAPSHOT_RECORD = 0;
+const uint8_t CHANGES_RECORD = 1;
+
+//a reorganization deeper than this since the last save makes the next changes a snapshot
+const size_t JOURNAL_BLOCKCHAIN_TAIL = 1000;
+
 void throwNotDefined() {
   throw std::runtime_error("The behavior is not defined!");
 }
@@ -65,11 +72,50 @@ private:
   CryptoNote::WalletAsyncContextCounter& m_shutdowner;
 };
 
+//catches a request callback that is made before perform() returns
+class SynchronousCompletion
+{
+public:
+  SynchronousCompletion() : m_performing(true), m_completed(false) {}
+
+  //returns false if perform() has already returned, the caller handles the completion then
+  bool complete(CryptoNote::WalletRequest::Callback callback, std::error_code ec) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_performing)
+      return false;
+
+    m_completed = true;
+    m_callback = std::move(callback);
+    m_ec = ec;
+    return true;
+  }
+
+  //returns true if the request completed before perform() returned
+  bool performed(CryptoNote::WalletRequest::Callback& callback, std::error_code& ec) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_performing = false;
+    if (!m_completed)
+      return false;
+
+    callback = std::move(m_callback);
+    ec = m_ec;
+    return true;
+  }
+
+private:
+  std::mutex m_mutex;
+  bool m_performing;
+  bool m_completed;
+  CryptoNote::WalletRequest::Callback m_callback;
+  std::error_code m_ec;
+};
+
 template <typename F>
 void runAtomic(std::mutex& mutex, F f) {
   std::unique_lock<std::mutex> lock(mutex);
   f();
 }
+
 } //namespace
 
 namespace CryptoNote {
@@ -98,6 +144,10 @@ Wallet::Wallet(const cryptonote::Currency& currency, INode& node) :
     m_node(node),
     m_isSynchronizing(false),
     m_isStopping(false),
+    m_journalState(NO_JOURNAL),
+    m_journalBlockchainSize(0),
+    m_journalSize(0),
+    m_journalSnapshotSize(0),
     m_transferDetails(currency, m_blockchain),
     m_transactionsCache(m_sendingTxsStates),
     m_synchronizer(m_account, m_node, m_blockchain, m_transferDetails, m_unconfirmedTransactions, m_transactionsCache),
@@ -126,6 +176,7 @@ void Wallet::initAndGenerate(const std::string& password) {
 
     m_account.generate();
     m_password = password;
+    m_key.reset();
 
     m_sender.init(m_account.get_keys());
 
@@ -153,6 +204,7 @@ void Wallet::initAndLoad(std::istream& source, const std::string& password) {
   addObserver(m_autoRefresher.get());
 
   m_password = password;
+  m_key.reset();
   m_state = LOADING;
 
   std::thread loader(&Wallet::doLoad, this, std::ref(source));
@@ -164,40 +216,10 @@ void Wallet::doLoad(std::istream& source) {
   {
     std::unique_lock<std::mutex> lock(m_cacheMutex);
 
-    boost::archive::binary_iarchive ar(source);
-
-    crypto::chacha8_iv iv;
-    std::string chacha_str;;
-    ar >> chacha_str;
-
-    ::serialization::parse_binary(chacha_str, iv);
-
-    std::string cipher;
-    ar >> cipher;
-
-    std::string plain;
-    decrypt(cipher, plain, iv, m_password);
-
-    std::stringstream restore(plain);
-
-    try
-    {
-      //boost archive ctor throws an exception if password is wrong (i.e. there's garbage in a stream)
-      boost::archive::binary_iarchive dataArchive(restore);
-
-      dataArchive >> m_account;
-
-      throwIfKeysMissmatch(m_account.get_keys().m_view_secret_key, m_account.get_keys().m_account_address.m_viewPublicKey);
-      throwIfKeysMissmatch(m_account.get_keys().m_spend_secret_key, m_account.get_keys().m_account_address.m_spendPublicKey);
-
-      dataArchive >> m_blockchain;
-
-      m_transferDetails.load(dataArchive);
-      m_unconfirmedTransactions.load(dataArchive);
-      m_transactionsCache.load(dataArchive);
-    }
-    catch (std::exception&) {
-      throw std::system_error(make_error_code(cryptonote::error::WRONG_PASSWORD));
+    if (WalletJournal::isJournal(source)) {
+      loadJournal(source);
+    } else {
+      loadLegacy(source);
     }
 
     m_sender.init(m_account.get_keys());
@@ -220,16 +242,164 @@ void Wallet::doLoad(std::istream& source) {
   refresh();
 }
 
-void Wallet::decrypt(const std::string& cipher, std::string& plain, crypto::chacha8_iv iv, const std::string& password) {
-  crypto::chacha8_key key;
-  crypto::cn_context context;
-  crypto::generate_chacha8_key(context, password, key);
+void Wallet::loadLegacy(std::istream& source) {
+  boost::archive::binary_iarchive ar(source);
+
+  crypto::chacha8_iv iv;
+  std::string chacha_str;;
+  ar >> chacha_str;
+
+  ::serialization::parse_binary(chacha_str, iv);
+
+  std::string cipher;
+  ar >> cipher;
+
+  std::string plain;
+  decrypt(cipher, plain, iv, encryptionKey());
+
+  std::stringstream restore(plain);
+
+  try
+  {
+    //boost archive ctor throws an exception if password is wrong (i.e. there's garbage in a stream)
+    boost::archive::binary_iarchive dataArchive(restore);
+
+    dataArchive >> m_account;
+
+    throwIfKeysMissmatch(m_account.get_keys().m_view_secret_key, m_account.get_keys().m_account_address.m_viewPublicKey);
+    throwIfKeysMissmatch(m_account.get_keys().m_spend_secret_key, m_account.get_keys().m_account_address.m_spendPublicKey);
 
+    std::vector<crypto::hash> blockchain;
+    dataArchive >> blockchain;
+    m_blockchain.assign(blockchain);
+
+    m_transferDetails.load(dataArchive);
+    m_unconfirmedTransactions.load(dataArchive);
+    m_transactionsCache.load(dataArchive);
+  }
+  catch (std::exception&) {
+    throw std::system_error(make_error_code(cryptonote::error::WRONG_PASSWORD));
+  }
+
+  //the old format can't be appended to, the first save rewrites it
+  m_journalState = NO_JOURNAL;
+}
+
+void Wallet::loadJournal(std::istream& source) {
+  WalletJournal::readHeader(source);
+
+  std::string plain;
+  size_t recordSize;
+  throwIf(WalletJournal::readRecord(source, encryptionKey(), plain, recordSize) != WalletJournal::RECORD_READ, cryptonote::error::INTERNAL_WALLET_ERROR);
+
+  uint8_t type;
+  try
+  {
+    //garbage in the first record means the password is wrong
+    type = readRecord(plain);
+  }
+  catch (std::exception&) {
+    throw std::system_error(make_error_code(cryptonote::error::WRONG_PASSWORD));
+  }
+
+  throwIf(type != SNAPSHOT_RECORD, cryptonote::error::INTERNAL_WALLET_ERROR);
+
+  m_journalSnapshotSize = recordSize;
+  m_journalSize = recordSize;
+
+  //a record torn by an interrupted save ends the journal
+  WalletJournal::ReadResult result;
+  while ((result = WalletJournal::readRecord(source, encryptionKey(), plain, recordSize)) == WalletJournal::RECORD_READ) {
+    if (readRecord(plain) == SNAPSHOT_RECORD) {
+      m_journalSnapshotSize = recordSize;
+    }
+
+    m_journalSize += recordSize;
+  }
+
+  m_transferDetails.rebuildIndex();
+
+  resetJournal();
+  //the changes appended after the torn record would be lost, so the next save has to rewrite the file
+  m_journalState = result == WalletJournal::JOURNAL_END ? JOURNAL_READY : NO_JOURNAL;
+}
+
+uint8_t Wallet::readRecord(const std::string& plain) {
+  std::stringstream stream(plain);
+  boost::archive::binary_iarchive ar(stream);
+
+  uint8_t type;
+  ar >> type;
+
+  if (type == SNAPSHOT_RECORD) {
+    readSnapshot(ar);
+  } else if (type == CHANGES_RECORD) {
+    readChanges(ar);
+  } else {
+    throw std::system_error(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
+  }
+
+  return type;
+}
+
+void Wallet::readSnapshot(boost::archive::binary_iarchive& ar) {
+  ar >> m_account;
+
+  throwIfKeysMissmatch(m_account.get_keys().m_view_secret_key, m_account.get_keys().m_account_address.m_viewPublicKey);
+  throwIfKeysMissmatch(m_account.get_keys().m_spend_secret_key, m_account.get_keys().m_account_address.m_spendPublicKey);
+
+  ar >> m_blockchain;
+
+  m_transferDetails.load(ar);
+  m_unconfirmedTransactions.load(ar);
+  m_transactionsCache.load(ar);
+
+  std::vector<TransactionId> erroredTransactions;
+  ar >> erroredTransactions;
+  for (TransactionId id: erroredTransactions) {
+    m_sendingTxsStates.error(id);
+  }
+}
+
+void Wallet::readChanges(boost::archive::binary_iarchive& ar) {
+  uint64_t keptBlocks;
+  std::vector<crypto::hash> addedBlocks;
+  ar >> keptBlocks;
+  ar >> addedBlocks;
+
+  throwIf(keptBlocks > m_blockchain.size(), cryptonote::error::INTERNAL_WALLET_ERROR);
+  m_blockchain.detach(keptBlocks);
+  for (auto& id: addedBlocks) {
+    m_blockchain.push_back(id);
+  }
+
+  m_transferDetails.loadChanges(ar);
+  m_unconfirmedTransactions.load(ar);
+  m_transactionsCache.loadChanges(ar);
+
+  std::vector<TransactionId> erroredTransactions;
+  ar >> erroredTransactions;
+  for (TransactionId id: erroredTransactions) {
+    m_sendingTxsStates.error(id);
+  }
+}
+
+void Wallet::decrypt(const std::string& cipher, std::string& plain, crypto::chacha8_iv iv, const crypto::chacha8_key& key) {
   plain.resize(cipher.size());
 
   crypto::chacha8(cipher.data(), cipher.size(), key, iv, &plain[0]);
 }
 
+//the key stretching takes a full slow hash, it is only redone after the password changes
+const crypto::chacha8_key& Wallet::encryptionKey() {
+  if (!m_key) {
+    m_key.reset(new crypto::chacha8_key);
+    crypto::generate_chacha8_key(m_password, *m_key);
+  }
+
+  return *m_key;
+}
+
 void Wallet::shutdown() {
   {
     std::unique_lock<std::mutex> lock(m_cacheMutex);
@@ -270,47 +440,109 @@ void Wallet::save(std::ostream& destination, bool saveDetailed, bool saveCache)
   saver.detach();
 }
 
+void Wallet::saveChanges(std::ostream& destination) {
+  if(m_isStopping) {
+    m_observerManager.notify(&IWalletObserver::saveCompleted, make_error_code(cryptonote::error::OPERATION_CANCELLED));
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(m_cacheMutex);
+
+    throwIf(m_state != INITIALIZED, cryptonote::error::WRONG_STATE);
+    throwIf(m_journalState == NO_JOURNAL, cryptonote::error::WRONG_STATE);
+
+    m_state = SAVING;
+  }
+
+  m_asyncContextCounter.addAsyncContext();
+  std::thread saver(&Wallet::doSaveChanges, this, std::ref(destination));
+  saver.detach();
+}
+
+bool Wallet::needsCompaction() {
+  std::unique_lock<std::mutex> lock(m_cacheMutex);
+
+  return m_journalState == NO_JOURNAL || m_journalSize - m_journalSnapshotSize > m_journalSnapshotSize;
+}
+
 void Wallet::doSave(std::ostream& destination, bool saveDetailed, bool saveCache) {
   ContextCounterHolder counterHolder(m_asyncContextCounter);
 
   try {
-    //TODO: exception safety: leave destination stream empty in case of errors
-    boost::archive::binary_oarchive ar(destination);
+    std::unique_lock<std::mutex> lock(m_cacheMutex);
 
     std::stringstream original;
-    std::unique_lock<std::mutex> lock(m_cacheMutex);
+    {
+      boost::archive::binary_oarchive archive(original);
+      writeSnapshot(archive, saveDetailed, saveCache, false);
+    }
 
-    boost::archive::binary_oarchive archive(original);
+    WalletJournal::writeHeader(destination);
+    size_t recordSize = WalletJournal::writeRecord(destination, original.str(), encryptionKey());
 
-    archive << m_account;
+    //a filtered snapshot doesn't match the cache, so the changes appended to it start with a full one
+    bool isComplete = saveDetailed && saveCache && m_sendingTxsStates.erroredTransactions().empty();
+    m_journalState = isComplete ? JOURNAL_READY : SNAPSHOT_NEEDED;
+    m_journalSnapshotSize = recordSize;
+    m_journalSize = recordSize;
+    resetJournal();
 
-    const BlockchainContainer& blockchain = saveCache ? m_blockchain : BlockchainContainer();
+    m_state = INITIALIZED;
+  }
+  catch (std::system_error& e) {
+    runAtomic(m_cacheMutex, [this] () {this->m_state = Wallet::INITIALIZED; this->m_journalState = Wallet::NO_JOURNAL;} );
+    m_observerManager.notify(&IWalletObserver::saveCompleted, e.code());
+    return;
+  }
+  catch (std::exception&) {
+    runAtomic(m_cacheMutex, [this] () {this->m_state = Wallet::INITIALIZED; this->m_journalState = Wallet::NO_JOURNAL;} );
+    m_observerManager.notify(&IWalletObserver::saveCompleted, make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
+    return;
+  }
+
+  m_observerManager.notify(&IWalletObserver::saveCompleted, std::error_code());
+}
+
+void Wallet::doSaveChanges(std::ostream& destination) {
+  ContextCounterHolder counterHolder(m_asyncContextCounter);
 
-    archive << blockchain;
+  try {
+    std::unique_lock<std::mutex> lock(m_cacheMutex);
 
-    m_transferDetails.save(archive, saveCache);
-    m_unconfirmedTransactions.save(archive, saveCache);
-    m_transactionsCache.save(archive, saveDetailed, saveCache);
+    size_t keptBlocks = 0;
+    bool isSnapshot = m_journalState != JOURNAL_READY || !findKeptBlockchainSize(keptBlocks);
 
-    std::string plain = original.str();
-    std::string cipher;
+    std::stringstream original;
+    {
+      boost::archive::binary_oarchive archive(original);
 
-    crypto::chacha8_iv iv = encrypt(plain, cipher);
+      if (isSnapshot) {
+        writeSnapshot(archive, true, true, true);
+      } else {
+        writeChanges(archive, keptBlocks);
+      }
+    }
 
-    std::string chacha_str;
-    ::serialization::dump_binary(iv, chacha_str);
-    ar << chacha_str;
-    ar << cipher;
+    size_t recordSize = WalletJournal::writeRecord(destination, original.str(), encryptionKey());
+
+    m_journalState = JOURNAL_READY;
+    if (isSnapshot) {
+      m_journalSnapshotSize = recordSize;
+    }
+    m_journalSize += recordSize;
+    resetJournal();
 
     m_state = INITIALIZED;
   }
+  //a torn record hides whatever is appended after it, so after a failure only a full save is allowed
   catch (std::system_error& e) {
-    runAtomic(m_cacheMutex, [this] () {this->m_state = Wallet::INITIALIZED;} );
+    runAtomic(m_cacheMutex, [this] () {this->m_state = Wallet::INITIALIZED; this->m_journalState = Wallet::NO_JOURNAL;} );
     m_observerManager.notify(&IWalletObserver::saveCompleted, e.code());
     return;
   }
   catch (std::exception&) {
-    runAtomic(m_cacheMutex, [this] () {this->m_state = Wallet::INITIALIZED;} );
+    runAtomic(m_cacheMutex, [this] () {this->m_state = Wallet::INITIALIZED; this->m_journalState = Wallet::NO_JOURNAL;} );
     m_observerManager.notify(&IWalletObserver::saveCompleted, make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
     return;
   }
@@ -318,17 +550,73 @@ void Wallet::doSave(std::ostream& destination, bool saveDetailed, bool saveCache
   m_observerManager.notify(&IWalletObserver::saveCompleted, std::error_code());
 }
 
-crypto::chacha8_iv Wallet::encrypt(const std::string& plain, std::string& cipher) {
-  crypto::chacha8_key key;
-  crypto::cn_context context;
-  crypto::generate_chacha8_key(context, m_password, key);
+void Wallet::writeSnapshot(boost::archive::binary_oarchive& ar, bool saveDetailed, bool saveCache, bool saveErrored) {
+  ar << SNAPSHOT_RECORD;
+  ar << m_account;
+
+  const BlockchainContainer& blockchain = saveCache ? m_blockchain : BlockchainContainer();
+
+  ar << blockchain;
+
+  m_transferDetails.save(ar, saveCache);
+  m_unconfirmedTransactions.save(ar, saveCache);
+
+  std::vector<TransactionId> erroredTransactions;
+  if (saveErrored) {
+    m_transactionsCache.saveAll(ar);
+    erroredTransactions = m_sendingTxsStates.erroredTransactions();
+  } else {
+    m_transactionsCache.save(ar, saveDetailed, saveCache);
+  }
+
+  ar << erroredTransactions;
+}
+
+void Wallet::writeChanges(boost::archive::binary_oarchive& ar, size_t keptBlocks) {
+  uint64_t kept = keptBlocks;
+  std::vector<crypto::hash> addedBlocks(m_blockchain.size() - keptBlocks);
+  for (size_t i = 0; i < addedBlocks.size(); ++i) {
+    m_blockchain.getBlockId(keptBlocks + i, addedBlocks[i]);
+  }
+
+  ar << CHANGES_RECORD;
+  ar << kept;
+  ar << addedBlocks;
 
-  cipher.resize(plain.size());
+  m_transferDetails.saveChanges(ar);
+  m_unconfirmedTransactions.save(ar, true);
+  m_transactionsCache.saveChanges(ar);
 
-  crypto::chacha8_iv iv = crypto::rand<crypto::chacha8_iv>();
-  crypto::chacha8(plain.data(), plain.size(), key, iv, &cipher[0]);
+  std::vector<TransactionId> erroredTransactions = m_sendingTxsStates.erroredTransactions();
+  ar << erroredTransactions;
+}
+
+//the saved chain and the current one share the blocks up to the last saved hash that is still in place,
+//the ids after it must all be kept to be appended
+bool Wallet::findKeptBlockchainSize(size_t& keptBlocks) const {
+  size_t tailStart = m_journalBlockchainSize - m_journalBlockchainTail.size();
+
+  keptBlocks = 0;
+  for (size_t size = std::min(m_journalBlockchainSize, m_blockchain.size()); size > tailStart; --size) {
+    if (m_blockchain.hasBlock(size - 1, m_journalBlockchainTail[size - 1 - tailStart])) {
+      keptBlocks = size;
+      break;
+    }
+  }
 
-  return iv;
+  return (keptBlocks != 0 || tailStart == 0) && keptBlocks >= m_blockchain.recentStart();
+}
+
+void Wallet::resetJournal() {
+  m_transferDetails.resetChanges();
+  m_transactionsCache.resetChanges();
+
+  size_t tailSize = std::min(m_blockchain.size() - m_blockchain.recentStart(), JOURNAL_BLOCKCHAIN_TAIL);
+  m_journalBlockchainSize = m_blockchain.size();
+  m_journalBlockchainTail.resize(tailSize);
+  for (size_t i = 0; i < tailSize; ++i) {
+    m_blockchain.getBlockId(m_journalBlockchainSize - tailSize + i, m_journalBlockchainTail[i]);
+  }
 }
 
 std::error_code Wallet::changePassword(const std::string& oldPassword, const std::string& newPassword) {
@@ -341,6 +629,9 @@ std::error_code Wallet::changePassword(const std::string& oldPassword, const std
 
   //we don't let the user to change the password while saving
   m_password = newPassword;
+  m_key.reset();
+  //the saved records are encrypted with the old password
+  m_journalState = NO_JOURNAL;
 
   return std::error_code();
 }
@@ -436,6 +727,26 @@ TransactionId Wallet::sendTransaction(const std::vector<Transfer>& transfers, ui
   return txId;
 }
 
+std::vector<TransactionId> Wallet::sendTransactions(const std::vector<TransactionParameters>& transactions) {
+  std::vector<TransactionId> txIds;
+  std::shared_ptr<WalletRequest> request;
+  std::deque<std::shared_ptr<WalletEvent> > events;
+
+  {
+    std::unique_lock<std::mutex> lock(m_cacheMutex);
+    request = m_sender.makeSendBatchRequest(txIds, events, transactions);
+  }
+
+  notifyClients(events);
+
+  if (request) {
+    m_asyncContextCounter.addAsyncContext();
+    request->perform(m_node, std::bind(&Wallet::sendTransactionCallback, this, std::placeholders::_1, std::placeholders::_2));
+  }
+
+  return txIds;
+}
+
 void Wallet::sendTransactionCallback(WalletRequest::Callback callback, std::error_code ec) {
   ContextCounterHolder counterHolder(m_asyncContextCounter);
   std::deque<std::shared_ptr<WalletEvent> > events;
@@ -449,13 +760,20 @@ void Wallet::sendTransactionCallback(WalletRequest::Callback callback, std::erro
   notifyClients(events);
 
   if (nextRequest) {
-    m_asyncContextCounter.addAsyncContext();
-    (*nextRequest)->perform(m_node, std::bind(&Wallet::synchronizationCallback, this, std::placeholders::_1, std::placeholders::_2));
+    performSynchronizationRequests(*nextRequest);
   }
 
 }
 
 void Wallet::synchronizationCallback(WalletRequest::Callback callback, std::error_code ec) {
+  std::shared_ptr<WalletRequest> nextRequest = handleSynchronizationResult(callback, ec);
+
+  if (nextRequest) {
+    performSynchronizationRequests(nextRequest);
+  }
+}
+
+std::shared_ptr<WalletRequest> Wallet::handleSynchronizationResult(WalletRequest::Callback callback, std::error_code ec) {
   ContextCounterHolder counterHolder(m_asyncContextCounter);
 
   std::deque<std::shared_ptr<WalletEvent> > events;
@@ -470,9 +788,29 @@ void Wallet::synchronizationCallback(WalletRequest::Callback callback, std::erro
 
   notifyClients(events);
 
-  if (nextRequest) {
+  return nextRequest ? *nextRequest : std::shared_ptr<WalletRequest>();
+}
+
+//a request may call back before perform() returns, e.g. when a prefetched portion is already here.
+//Such callbacks are handled by this loop, so a long synchronization doesn't nest deeper and deeper
+void Wallet::performSynchronizationRequests(std::shared_ptr<WalletRequest> request) {
+  while (request) {
+    std::shared_ptr<SynchronousCompletion> completion = std::make_shared<SynchronousCompletion>();
+
     m_asyncContextCounter.addAsyncContext();
-    (*nextRequest)->perform(m_node, std::bind(&Wallet::synchronizationCallback, this, std::placeholders::_1, std::placeholders::_2));
+    request->perform(m_node, [this, completion] (WalletRequest::Callback callback, std::error_code ec) {
+      if (!completion->complete(callback, ec)) {
+        synchronizationCallback(callback, ec);
+      }
+    });
+
+    WalletRequest::Callback callback;
+    std::error_code ec;
+    if (!completion->performed(callback, ec)) {
+      return;
+    }
+
+    request = handleSynchronizationResult(callback, ec);
   }
 }
 
@@ -515,8 +853,7 @@ void Wallet::refresh() {
     req = m_synchronizer.makeStartRefreshRequest();
   }
 
-  m_asyncContextCounter.addAsyncContext();
-  req->perform(m_node, std::bind(&Wallet::synchronizationCallback, this, std::placeholders::_1, std::placeholders::_2));
+  performSynchronizationRequests(req);
 }
 
 void Wallet::notifyClients(std::deque<std::shared_ptr<WalletEvent> >& events) {
@@ -23,6 +23,9 @@
 #include <memory>
 #include <mutex>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
 #include "IWallet.h"
 #include "INode.h"
 #include "WalletErrors.h"
@@ -32,6 +35,7 @@
 #include "cryptonote_core/tx_extra.h"
 #include "cryptonote_core/cryptonote_format_utils.h"
 #include "cryptonote_core/Currency.h"
+#include "WalletBlockchainHistory.h"
 #include "WalletTransferDetails.h"
 #include "WalletUserTransactionsCache.h"
 #include "WalletUnconfirmedTransactions.h"
@@ -54,6 +58,8 @@ public:
   virtual void shutdown();
 
   virtual void save(std::ostream& destination, bool saveDetailed = true, bool saveCache = true);
+  virtual void saveChanges(std::ostream& destination);
+  virtual bool needsCompaction();
 
   virtual std::error_code changePassword(const std::string& oldPassword, const std::string& newPassword);
 
@@ -72,6 +78,7 @@ public:
 
   virtual TransactionId sendTransaction(const Transfer& transfer, uint64_t fee, const std::string& extra = "", uint64_t mixIn = 0, uint64_t unlockTimestamp = 0);
   virtual TransactionId sendTransaction(const std::vector<Transfer>& transfers, uint64_t fee, const std::string& extra = "", uint64_t mixIn = 0, uint64_t unlockTimestamp = 0);
+  virtual std::vector<TransactionId> sendTransactions(const std::vector<TransactionParameters>& transactions);
   virtual std::error_code cancelTransaction(size_t transactionId);
 
   void startRefresh();
@@ -82,12 +89,25 @@ private:
   uint64_t doPendingBalance();
 
   void doSave(std::ostream& destination, bool saveDetailed, bool saveCache);
+  void doSaveChanges(std::ostream& destination);
   void doLoad(std::istream& source);
+  void loadLegacy(std::istream& source);
+  void loadJournal(std::istream& source);
+
+  void writeSnapshot(boost::archive::binary_oarchive& ar, bool saveDetailed, bool saveCache, bool saveErrored);
+  void writeChanges(boost::archive::binary_oarchive& ar, size_t keptBlocks);
+  uint8_t readRecord(const std::string& plain);
+  void readSnapshot(boost::archive::binary_iarchive& ar);
+  void readChanges(boost::archive::binary_iarchive& ar);
+  bool findKeptBlockchainSize(size_t& keptBlocks) const;
+  void resetJournal();
 
-  crypto::chacha8_iv encrypt(const std::string& plain, std::string& cipher);
-  void decrypt(const std::string& cipher, std::string& plain, crypto::chacha8_iv iv, const std::string& password);
+  void decrypt(const std::string& cipher, std::string& plain, crypto::chacha8_iv iv, const crypto::chacha8_key& key);
+  const crypto::chacha8_key& encryptionKey();
 
   void synchronizationCallback(WalletRequest::Callback callback, std::error_code ec);
+  std::shared_ptr<WalletRequest> handleSynchronizationResult(WalletRequest::Callback callback, std::error_code ec);
+  void performSynchronizationRequests(std::shared_ptr<WalletRequest> request);
   void sendTransactionCallback(WalletRequest::Callback callback, std::error_code ec);
   void notifyClients(std::deque<std::shared_ptr<WalletEvent> >& events);
 
@@ -105,12 +125,14 @@ private:
   std::mutex m_cacheMutex;
   cryptonote::account_base m_account;
   std::string m_password;
+  //derived from m_password on first use, reset with it
+  std::unique_ptr<crypto::chacha8_key> m_key;
   const cryptonote::Currency& m_currency;
   INode& m_node;
   bool m_isSynchronizing;
   bool m_isStopping;
 
-  typedef std::vector<crypto::hash> BlockchainContainer;
+  typedef WalletBlockchainHistory BlockchainContainer;
 
   BlockchainContainer m_blockchain;
   WalletTransferDetails m_transferDetails;
@@ -120,6 +142,21 @@ private:
   WalletTxSendingState m_sendingTxsStates;
   WalletUserTransactionsCache m_transactionsCache;
 
+  enum JournalState
+  {
+    NO_JOURNAL = 0,
+    SNAPSHOT_NEEDED,
+    JOURNAL_READY
+  };
+
+  //what the saved wallet holds: changes are appended relative to it
+  JournalState m_journalState;
+  size_t m_journalBlockchainSize;
+  std::vector<crypto::hash> m_journalBlockchainTail;
+  //bytes of the records, the snapshot included
+  uint64_t m_journalSize;
+  uint64_t m_journalSnapshotSize;
+
   struct WalletNodeObserver: public INodeObserver, public IWalletObserver
   {
     WalletNodeObserver(Wallet* wallet) : m_wallet(wallet), postponed(false) {}
@@ -0,0 +1,143 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WalletBlockchainHistory.h"
+
+#include "cryptonote_core/cryptonote_basic.h"
+
+namespace CryptoNote {
+
+WalletBlockchainHistory::WalletBlockchainHistory(size_t recentWindow, size_t checkpointInterval) :
+  m_recentWindow(recentWindow), m_checkpointInterval(checkpointInterval), m_recentStart(0) {
+}
+
+void WalletBlockchainHistory::push_back(const crypto::hash& id) {
+  if (size() % m_checkpointInterval == 0)
+    m_checkpoints.push_back(id);
+
+  m_recent.push_back(id);
+  trimRecent();
+}
+
+void WalletBlockchainHistory::assign(const std::vector<crypto::hash>& ids) {
+  clear();
+
+  for (auto& id: ids) {
+    push_back(id);
+  }
+}
+
+void WalletBlockchainHistory::detach(size_t height) {
+  if (height >= size())
+    return;
+
+  if (height >= m_recentStart) {
+    m_recent.resize(height - m_recentStart);
+  } else {
+    //the ids between the checkpoint below and height are gone, the daemon will resend them
+    m_recent.clear();
+    m_recentStart = height;
+  }
+
+  m_checkpoints.resize((height + m_checkpointInterval - 1) / m_checkpointInterval);
+}
+
+void WalletBlockchainHistory::clear() {
+  m_checkpoints.clear();
+  m_recent.clear();
+  m_recentStart = 0;
+}
+
+bool WalletBlockchainHistory::getBlockId(size_t height, crypto::hash& id) const {
+  if (height >= size())
+    return false;
+
+  if (height >= m_recentStart) {
+    id = m_recent[height - m_recentStart];
+    return true;
+  }
+
+  if (height % m_checkpointInterval == 0) {
+    id = m_checkpoints[height / m_checkpointInterval];
+    return true;
+  }
+
+  return false;
+}
+
+bool WalletBlockchainHistory::hasBlock(size_t height, const crypto::hash& id) const {
+  crypto::hash kept;
+  return getBlockId(height, kept) && kept == id;
+}
+
+void WalletBlockchainHistory::getShortChainHistory(std::list<crypto::hash>& ids) const {
+  getShortChainHistory(size(), std::vector<crypto::hash>(), ids);
+}
+
+void WalletBlockchainHistory::getShortChainHistory(size_t startHeight, const std::vector<crypto::hash>& appendedIds, std::list<crypto::hash>& ids) const {
+  size_t sz = startHeight + appendedIds.size();
+  if (!sz)
+    return;
+
+  auto blockId = [this, startHeight, &appendedIds] (size_t height) {
+    crypto::hash id = cryptonote::null_hash;
+    if (height >= startHeight) {
+      id = appendedIds[height - startHeight];
+    } else {
+      getBlockId(height, id);
+    }
+
+    return id;
+  };
+
+  size_t i = 0;
+  size_t current_multiplier = 1;
+  size_t current_back_offset = 1;
+  size_t lastHeight = sz;
+
+  while (current_back_offset < sz) {
+    size_t height = sz - current_back_offset;
+
+    //below the recent window the nearest checkpoint stands in for the height
+    if (height < startHeight && height < m_recentStart)
+      height -= height % m_checkpointInterval;
+
+    if (height < lastHeight) {
+      ids.push_back(blockId(height));
+      lastHeight = height;
+    }
+
+    if (i < 10) {
+      ++current_back_offset;
+    } else {
+      current_back_offset += current_multiplier *= 2;
+    }
+    ++i;
+  }
+
+  if (lastHeight != 0)
+    ids.push_back(blockId(0));
+}
+
+void WalletBlockchainHistory::trimRecent() {
+  while (m_recent.size() > m_recentWindow) {
+    m_recent.pop_front();
+    ++m_recentStart;
+  }
+}
+
+} //namespace CryptoNote
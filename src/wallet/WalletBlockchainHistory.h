@@ -0,0 +1,93 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <deque>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/serialization/deque.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/cryptonote_boost_serialization.h"
+
+namespace CryptoNote {
+
+//The block ids of the wallet's blockchain. Every id of the recent window is kept, since that's where the chain
+//gets reorganized, and below it only every checkpointInterval-th one. That's enough to build the short chain
+//history the daemon finds our fork point by, at a small part of the memory and file size of one id per height.
+class WalletBlockchainHistory
+{
+public:
+  static const size_t DEFAULT_RECENT_WINDOW = 2000;
+  static const size_t DEFAULT_CHECKPOINT_INTERVAL = 1000;
+
+  WalletBlockchainHistory(size_t recentWindow = DEFAULT_RECENT_WINDOW, size_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL);
+
+  size_t size() const { return m_recentStart + m_recent.size(); }
+  bool empty() const { return size() == 0; }
+  //the heights from here on are all kept
+  size_t recentStart() const { return m_recentStart; }
+
+  void push_back(const crypto::hash& id);
+  void assign(const std::vector<crypto::hash>& ids);
+  //removes the blocks from height on
+  void detach(size_t height);
+  void clear();
+
+  //false if the id at this height isn't kept
+  bool getBlockId(size_t height, crypto::hash& id) const;
+  //false if the block at this height is another one or isn't kept, so a mismatch must be assumed
+  bool hasBlock(size_t height, const crypto::hash& id) const;
+
+  void getShortChainHistory(std::list<crypto::hash>& ids) const;
+  //the history of the chain the blocks at startHeight and up replaced by the given ones, startHeight <= size()
+  void getShortChainHistory(size_t startHeight, const std::vector<crypto::hash>& appendedIds, std::list<crypto::hash>& ids) const;
+
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    uint64_t recentStart = m_recentStart;
+    ar & m_checkpoints;
+    ar & recentStart;
+    ar & m_recent;
+    m_recentStart = recentStart;
+
+    //a checkpoint for every kept height divisible by the interval, or lookups would read past m_checkpoints
+    if (Archive::is_loading::value && m_checkpoints.size() != (size() + m_checkpointInterval - 1) / m_checkpointInterval) {
+      clear();
+      throw std::runtime_error("Inconsistent block history in the wallet cache");
+    }
+
+    trimRecent();
+  }
+
+private:
+  void trimRecent();
+
+  size_t m_recentWindow;
+  size_t m_checkpointInterval;
+
+  //the ids at the heights divisible by m_checkpointInterval
+  std::vector<crypto::hash> m_checkpoints;
+  size_t m_recentStart;
+  std::deque<crypto::hash> m_recent;
+};
+
+} //namespace CryptoNote
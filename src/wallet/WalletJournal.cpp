@@ -0,0 +1,140 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WalletJournal.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+#include "WalletErrors.h"
+
+namespace {
+
+const char JOURNAL_SIGNATURE[] = { 'C', 'N', 'W', 'J' };
+const uint32_t JOURNAL_VERSION = 1;
+
+struct RecordHeader {
+  uint64_t size;
+  crypto::chacha8_iv iv;
+  crypto::hash checksum;
+};
+
+crypto::hash recordChecksum(const RecordHeader& header, const std::string& cipher) {
+  std::string data(reinterpret_cast<const char*>(&header.size), sizeof(header.size));
+  data.append(reinterpret_cast<const char*>(&header.iv), sizeof(header.iv));
+  data.append(cipher);
+
+  return crypto::cn_fast_hash(data.data(), data.size());
+}
+
+void throwIfBad(const std::ios& stream) {
+  if (!stream.good()) {
+    throw std::system_error(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
+  }
+}
+
+} //namespace
+
+namespace CryptoNote {
+
+bool WalletJournal::isJournal(std::istream& source) {
+  //a legacy wallet file starts with a boost archive, which can't start with the signature
+  return source.peek() == JOURNAL_SIGNATURE[0];
+}
+
+void WalletJournal::writeHeader(std::ostream& destination) {
+  destination.write(JOURNAL_SIGNATURE, sizeof(JOURNAL_SIGNATURE));
+  destination.write(reinterpret_cast<const char*>(&JOURNAL_VERSION), sizeof(JOURNAL_VERSION));
+  throwIfBad(destination);
+}
+
+void WalletJournal::readHeader(std::istream& source) {
+  char signature[sizeof(JOURNAL_SIGNATURE)];
+  uint32_t version;
+
+  source.read(signature, sizeof(signature));
+  source.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+  if (!source.good() || memcmp(signature, JOURNAL_SIGNATURE, sizeof(signature)) != 0 || version != JOURNAL_VERSION) {
+    throw std::system_error(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
+  }
+}
+
+size_t WalletJournal::writeRecord(std::ostream& destination, const std::string& plain, const crypto::chacha8_key& key) {
+  RecordHeader header;
+  header.size = plain.size();
+  header.iv = crypto::rand<crypto::chacha8_iv>();
+
+  std::string cipher;
+  cipher.resize(plain.size());
+  crypto::chacha8(plain.data(), plain.size(), key, header.iv, &cipher[0]);
+
+  header.checksum = recordChecksum(header, cipher);
+
+  destination.write(reinterpret_cast<const char*>(&header.size), sizeof(header.size));
+  destination.write(reinterpret_cast<const char*>(&header.iv), sizeof(header.iv));
+  destination.write(reinterpret_cast<const char*>(&header.checksum), sizeof(header.checksum));
+  destination.write(cipher.data(), cipher.size());
+  destination.flush();
+  throwIfBad(destination);
+
+  return sizeof(header.size) + sizeof(header.iv) + sizeof(header.checksum) + cipher.size();
+}
+
+WalletJournal::ReadResult WalletJournal::readRecord(std::istream& source, const crypto::chacha8_key& key, std::string& plain, size_t& recordSize) {
+  RecordHeader header;
+
+  if (source.peek() == std::char_traits<char>::eof()) {
+    return JOURNAL_END;
+  }
+
+  source.read(reinterpret_cast<char*>(&header.size), sizeof(header.size));
+  source.read(reinterpret_cast<char*>(&header.iv), sizeof(header.iv));
+  source.read(reinterpret_cast<char*>(&header.checksum), sizeof(header.checksum));
+  if (!source.good()) {
+    return RECORD_TORN;
+  }
+
+  //don't trust the size of a torn record: read it in chunks, so garbage can't make us allocate too much
+  std::string cipher;
+  const size_t chunkSize = 1 << 20;
+  while (cipher.size() < header.size) {
+    size_t offset = cipher.size();
+    size_t count = static_cast<size_t>(std::min<uint64_t>(chunkSize, header.size - offset));
+    cipher.resize(offset + count);
+
+    source.read(&cipher[offset], count);
+    if (static_cast<size_t>(source.gcount()) != count) {
+      return RECORD_TORN;
+    }
+  }
+
+  if (recordChecksum(header, cipher) != header.checksum) {
+    return RECORD_TORN;
+  }
+
+  plain.resize(cipher.size());
+  crypto::chacha8(cipher.data(), cipher.size(), key, header.iv, &plain[0]);
+  recordSize = sizeof(header.size) + sizeof(header.iv) + sizeof(header.checksum) + cipher.size();
+
+  return RECORD_READ;
+}
+
+} //namespace CryptoNote
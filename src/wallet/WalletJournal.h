@@ -0,0 +1,51 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "crypto/chacha8.h"
+
+namespace CryptoNote {
+
+//The wallet cache as a sequence of records: a full snapshot followed by the changes of the later saves.
+//Every record is encrypted with its own iv and checksummed, so appending a record never touches the
+//previous ones and a record torn by a crash is detected and dropped on load.
+class WalletJournal
+{
+public:
+  static bool isJournal(std::istream& source);
+
+  static void writeHeader(std::ostream& destination);
+  static void readHeader(std::istream& source);
+
+  //returns the number of bytes written
+  static size_t writeRecord(std::ostream& destination, const std::string& plain, const crypto::chacha8_key& key);
+  enum ReadResult {
+    RECORD_READ,
+    JOURNAL_END,
+    RECORD_TORN
+  };
+
+  //a torn record isn't the end of the file, so whatever is appended after it can't be read back
+  static ReadResult readRecord(std::istream& source, const crypto::chacha8_key& key, std::string& plain, size_t& recordSize);
+};
+
+} //namespace CryptoNote
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <memory>
@@ -56,20 +57,51 @@ private:
   Callback m_cb;
 };
 
-class WalletGetTransactionOutsGlobalIndicesRequest: public WalletRequest
+class WalletGetPrefetchedBlocksRequest: public WalletRequest
 {
 public:
-  WalletGetTransactionOutsGlobalIndicesRequest(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, Callback cb) : m_hash(transactionHash), m_outs(outsGlobalIndices), m_cb(cb) {};
-  virtual ~WalletGetTransactionOutsGlobalIndicesRequest() {};
+  WalletGetPrefetchedBlocksRequest(std::shared_ptr<BlocksPrefetch> prefetch, std::shared_ptr<SynchronizationContext> context, Callback cb) : m_prefetch(prefetch), m_context(context), m_cb(cb) {};
+  virtual ~WalletGetPrefetchedBlocksRequest() {};
 
   virtual void perform(INode& node, std::function<void (WalletRequest::Callback, std::error_code)> cb)
   {
-    node.getTransactionOutsGlobalIndices(m_hash, std::ref(m_outs), std::bind(cb, m_cb, std::placeholders::_1));
+    std::shared_ptr<BlocksPrefetch> prefetch = m_prefetch;
+    std::shared_ptr<SynchronizationContext> context = m_context;
+    Callback callback = m_cb;
+
+    auto onBlocks = [prefetch, context, callback, cb] (std::error_code ec) {
+      context->newBlocks = std::move(prefetch->newBlocks);
+      context->startHeight = prefetch->startHeight;
+      cb(callback, ec);
+    };
+
+    if (!prefetch->wait(onBlocks)) {
+      //the portion is already here. The wallet runs a callback made on this stack after perform returns
+      onBlocks(prefetch->error());
+    }
   };
 
 private:
-  crypto::hash m_hash;
-  std::vector<uint64_t>& m_outs;
+  std::shared_ptr<BlocksPrefetch> m_prefetch;
+  std::shared_ptr<SynchronizationContext> m_context;
+  Callback m_cb;
+};
+
+class WalletGetTransactionsOutsGlobalIndicesRequest: public WalletRequest
+{
+public:
+  WalletGetTransactionsOutsGlobalIndicesRequest(const std::vector<crypto::hash>& transactionHashes, std::shared_ptr<SynchronizationContext> context, Callback cb) :
+    m_hashes(transactionHashes), m_context(context), m_cb(cb) {};
+  virtual ~WalletGetTransactionsOutsGlobalIndicesRequest() {};
+
+  virtual void perform(INode& node, std::function<void (WalletRequest::Callback, std::error_code)> cb)
+  {
+    node.getTransactionsOutsGlobalIndices(std::move(m_hashes), std::ref(m_context->requestedGlobalIndices), std::bind(cb, m_cb, std::placeholders::_1));
+  };
+
+private:
+  std::vector<crypto::hash> m_hashes;
+  std::shared_ptr<SynchronizationContext> m_context;
   Callback m_cb;
 };
 
@@ -93,6 +125,26 @@ private:
   Callback m_cb;
 };
 
+class WalletGetBatchRandomOutsByAmountsRequest: public WalletRequest
+{
+public:
+  WalletGetBatchRandomOutsByAmountsRequest(const std::vector<uint64_t>& amounts, uint64_t outsCount, std::shared_ptr<SendBatchContext> context, Callback cb) :
+    m_amounts(amounts), m_outsCount(outsCount), m_context(context), m_cb(cb) {};
+
+  virtual ~WalletGetBatchRandomOutsByAmountsRequest() {};
+
+  virtual void perform(INode& node, std::function<void (WalletRequest::Callback, std::error_code)> cb)
+  {
+    node.getRandomOutsByAmounts(std::move(m_amounts), m_outsCount, std::ref(m_context->outs), std::bind(cb, m_cb, std::placeholders::_1));
+  };
+
+private:
+  std::vector<uint64_t> m_amounts;
+  uint64_t m_outsCount;
+  std::shared_ptr<SendBatchContext> m_context;
+  Callback m_cb;
+};
+
 class WalletRelayTransactionRequest: public WalletRequest
 {
 public:
@@ -109,4 +161,35 @@ private:
   Callback m_cb;
 };
 
+class WalletRelayTransactionsRequest: public WalletRequest
+{
+public:
+  WalletRelayTransactionsRequest(std::vector<cryptonote::Transaction>&& txs, std::shared_ptr<SendBatchContext> context, Callback cb) :
+    m_txs(std::make_shared<std::vector<cryptonote::Transaction> >(std::move(txs))), m_context(context), m_cb(cb) {};
+  virtual ~WalletRelayTransactionsRequest() {};
+
+  //all the relays are in flight at once, the callback is called when the last of them completes
+  virtual void perform(INode& node, std::function<void (WalletRequest::Callback, std::error_code)> cb)
+  {
+    std::shared_ptr<std::vector<cryptonote::Transaction> > txs = m_txs;
+    std::shared_ptr<SendBatchContext> context = m_context;
+    std::shared_ptr<std::atomic<size_t> > pending = std::make_shared<std::atomic<size_t> >(txs->size());
+    Callback callback = m_cb;
+
+    context->relayResults.assign(txs->size(), std::error_code());
+    for (size_t i = 0; i < txs->size(); ++i) {
+      node.relayTransaction((*txs)[i], [txs, context, pending, callback, cb, i] (std::error_code ec) {
+        context->relayResults[i] = ec;
+        if (--(*pending) == 0)
+          cb(callback, std::error_code());
+      });
+    }
+  }
+
+private:
+  std::shared_ptr<std::vector<cryptonote::Transaction> > m_txs;
+  std::shared_ptr<SendBatchContext> m_context;
+  Callback m_cb;
+};
+
 } //namespace CryptoNote
@@ -18,6 +18,8 @@
 #pragma once
 
 #include <list>
+#include <memory>
+#include <system_error>
 #include <vector>
 
 #include "cryptonote_core/cryptonote_basic.h"
@@ -50,4 +52,13 @@ struct SendTransactionContext
   uint64_t mixIn;
 };
 
+//transactions of one batch share a single random outputs request and a single relay request
+struct SendBatchContext
+{
+  std::vector<std::shared_ptr<SendTransactionContext> > transactions;
+  std::vector<cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount> outs;
+  std::vector<TransactionId> relayedTransactions;
+  std::vector<std::error_code> relayResults;
+};
+
 } //namespace CryptoNote
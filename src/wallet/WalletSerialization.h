@@ -22,13 +22,22 @@
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/array.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "cryptonote_core/AccountKVSerialization.h"
 #include "cryptonote_core/cryptonote_boost_serialization.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
 #include "common/unordered_containers_boost_serialization.h"
 #include "storages/portable_storage_template_helper.h"
 
+#include "WalletTransferDetails.h"
+#include "WalletUnconfirmedTransactions.h"
+
 BOOST_SERIALIZATION_SPLIT_FREE(cryptonote::account_base);
+BOOST_SERIALIZATION_SPLIT_FREE(CryptoNote::TransferDetails);
+
+//version 0 kept the whole transaction of every owned output
+BOOST_CLASS_VERSION(CryptoNote::TransferDetails, 1)
 
 namespace boost {
 namespace serialization {
@@ -73,14 +82,49 @@ inline void serialize(Archive & ar, CryptoNote::Transfer& tr, const unsigned int
 }
 
 template<class Archive>
-inline void serialize(Archive & ar, CryptoNote::TransferDetails& details, const unsigned int version)
+inline void load(Archive & ar, CryptoNote::TransferDetails& details, const unsigned int version)
 {
-  ar & details.blockHeight;
-  ar & details.tx;
-  ar & details.internalOutputIndex;
-  ar & details.globalOutputIndex;
-  ar & details.spent;
-  ar & details.keyImage;
+  ar >> details.blockHeight;
+
+  if (version < 1) {
+    cryptonote::Transaction tx;
+    ar >> tx;
+    ar >> details.internalOutputIndex;
+
+    if (details.internalOutputIndex >= tx.vout.size() || tx.vout[details.internalOutputIndex].target.type() != typeid(cryptonote::TransactionOutputToKey)) {
+      throw std::runtime_error("Wrong output index in the wallet cache");
+    }
+
+    const cryptonote::TransactionOutput& out = tx.vout[details.internalOutputIndex];
+    details.amount = out.amount;
+    details.outputKey = boost::get<cryptonote::TransactionOutputToKey>(out.target).key;
+    details.transactionPublicKey = cryptonote::get_tx_pub_key_from_extra(tx);
+    details.unlockTime = tx.unlockTime;
+  } else {
+    ar >> details.amount;
+    ar >> details.outputKey;
+    ar >> details.transactionPublicKey;
+    ar >> details.unlockTime;
+    ar >> details.internalOutputIndex;
+  }
+
+  ar >> details.globalOutputIndex;
+  ar >> details.spent;
+  ar >> details.keyImage;
+}
+
+template<class Archive>
+inline void save(Archive & ar, const CryptoNote::TransferDetails& details, const unsigned int version)
+{
+  ar << details.blockHeight;
+  ar << details.amount;
+  ar << details.outputKey;
+  ar << details.transactionPublicKey;
+  ar << details.unlockTime;
+  ar << details.internalOutputIndex;
+  ar << details.globalOutputIndex;
+  ar << details.spent;
+  ar << details.keyImage;
 }
 
 template<class Archive>
@@ -18,9 +18,12 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <list>
+#include <system_error>
 #include <unordered_map>
 
 #include "crypto/crypto.h"
@@ -32,7 +35,7 @@ struct TransactionContextInfo
 {
   std::vector<size_t> requestedOuts;
   std::vector<uint64_t> globalIndices;
-  cryptonote::Transaction transaction;
+  uint64_t receivedAmount;
   crypto::public_key transactionPubKey;
 };
 
@@ -44,12 +47,62 @@ struct SynchronizationState
   bool minersTxProcessed; //is miner's tx in the block processed
 };
 
+//next blocks portion requested from the node while the current one is being processed
+class BlocksPrefetch
+{
+public:
+  BlocksPrefetch() : startHeight(0), m_done(false) {}
+
+  void complete(std::error_code ec) {
+    std::function<void (std::error_code)> waiter;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done = true;
+      m_ec = ec;
+      waiter = std::move(m_waiter);
+    }
+
+    if (waiter)
+      waiter(ec);
+  }
+
+  //returns false if the portion has already arrived, the waiter is not stored then
+  bool wait(std::function<void (std::error_code)> waiter) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_done)
+      return false;
+
+    m_waiter = std::move(waiter);
+    return true;
+  }
+
+  std::error_code error() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_ec;
+  }
+
+  std::list<cryptonote::block_complete_entry> newBlocks;
+  uint64_t startHeight;
+
+private:
+  std::mutex m_mutex;
+  bool m_done;
+  std::error_code m_ec;
+  std::function<void (std::error_code)> m_waiter;
+};
+
 struct SynchronizationContext
 {
+  SynchronizationContext() : startHeight(0), outsScanned(false) {}
   std::list<cryptonote::block_complete_entry> newBlocks;
   uint64_t startHeight;
+  //outputs to us found in newBlocks, filled by one pass before the blocks are processed
+  bool outsScanned;
   std::unordered_map<crypto::hash, TransactionContextInfo> transactionContext;
+  std::vector<crypto::hash> requestedTransactions;
+  std::vector<std::vector<uint64_t> > requestedGlobalIndices;
   SynchronizationState progress;
+  std::shared_ptr<BlocksPrefetch> prefetch;
 };
 
 } //namespace CryptoNote
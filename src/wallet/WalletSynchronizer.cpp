@@ -18,6 +18,11 @@
 #include "WalletSynchronizer.h"
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <thread>
 
 #include "cryptonote_core/account.h"
 
@@ -26,6 +31,9 @@
 
 namespace {
 
+//blocks are scanned in runs, the key derivations of the transactions of a run share one field inversion
+const size_t SCAN_RUN_BLOCKS = 16;
+
 void throwIf(bool expr, cryptonote::error::WalletErrorCodes ec) {
   if (expr)
     throw std::system_error(make_error_code(ec));
@@ -45,8 +53,9 @@ bool getTxPubKey(const cryptonote::Transaction& tx, crypto::public_key& key) {
   return true;
 }
 
-void findMyOuts(const cryptonote::account_keys& acc, const cryptonote::Transaction& tx, const crypto::public_key& txPubKey, std::vector<size_t>& outs, uint64_t& moneyTransfered) {
-  bool r = cryptonote::lookup_acc_outs(acc, tx, txPubKey, outs, moneyTransfered);
+void findMyOuts(const cryptonote::account_keys& acc, const cryptonote::Transaction& tx, const crypto::key_derivation& derivation,
+    std::vector<size_t>& outs, uint64_t& moneyTransfered) {
+  bool r = cryptonote::lookup_acc_outs(acc, tx, derivation, outs, moneyTransfered);
   throwIf(!r, cryptonote::error::INTERNAL_WALLET_ERROR);
 }
 
@@ -81,7 +90,7 @@ void fillTransactionHash(const cryptonote::Transaction& tx, CryptoNote::Transact
 namespace CryptoNote
 {
 
-WalletSynchronizer::WalletSynchronizer(const cryptonote::account_base& account, INode& node, std::vector<crypto::hash>& blockchain,
+WalletSynchronizer::WalletSynchronizer(const cryptonote::account_base& account, INode& node, WalletBlockchainHistory& blockchain,
     WalletTransferDetails& transferDetails, WalletUnconfirmedTransactions& unconfirmedTransactions,
     WalletUserTransactionsCache& transactionsCache) :
       m_account(account),
@@ -92,7 +101,10 @@ WalletSynchronizer::WalletSynchronizer(const cryptonote::account_base& account,
       m_transactionsCache(transactionsCache),
       m_actualBalance(0),
       m_pendingBalance(0),
+      m_scanThreadCount(std::thread::hardware_concurrency()),
       m_isStoping(false) {
+  if (m_scanThreadCount == 0)
+    m_scanThreadCount = 4;
 }
 
 void WalletSynchronizer::stop() {
@@ -106,15 +118,19 @@ std::shared_ptr<WalletRequest> WalletSynchronizer::makeStartRefreshRequest() {
   return request;
 }
 
-void WalletSynchronizer::postGetTransactionOutsGlobalIndicesRequest(ProcessParameters& parameters, const crypto::hash& hash, std::vector<uint64_t>& outsGlobalIndices, uint64_t height) {
-  parameters.nextRequest = std::make_shared<WalletGetTransactionOutsGlobalIndicesRequest>(hash, outsGlobalIndices,
-                      std::bind(&WalletSynchronizer::handleTransactionOutGlobalIndicesResponse, this, parameters.context, hash, height, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+void WalletSynchronizer::resetContext(SynchronizationContext& context) {
+  context.newBlocks.clear();
+  context.startHeight = 0;
+  context.outsScanned = false;
+  context.transactionContext.clear();
+  context.requestedTransactions.clear();
+  context.requestedGlobalIndices.clear();
+  context.progress = SynchronizationState();
+  context.prefetch.reset();
 }
 
 std::shared_ptr<WalletRequest> WalletSynchronizer::makeGetNewBlocksRequest(std::shared_ptr<SynchronizationContext> context) {
-  context->newBlocks.clear();
-  context->startHeight = 0;
-  context->progress = SynchronizationState();
+  resetContext(*context);
 
   std::list<crypto::hash> ids;
   getShortChainHistory(ids);
@@ -125,32 +141,33 @@ std::shared_ptr<WalletRequest> WalletSynchronizer::makeGetNewBlocksRequest(std::
   return req;
 }
 
+std::shared_ptr<WalletRequest> WalletSynchronizer::makeGetPrefetchedBlocksRequest(std::shared_ptr<SynchronizationContext> context) {
+  std::shared_ptr<BlocksPrefetch> prefetch = context->prefetch;
+  resetContext(*context);
+
+  std::shared_ptr<WalletRequest>req = std::make_shared<WalletGetPrefetchedBlocksRequest>(prefetch, context, std::bind(&WalletSynchronizer::handleNewBlocksPortion, this,
+                                                                                          context, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+  return req;
+}
+
 void WalletSynchronizer::getShortChainHistory(std::list<crypto::hash>& ids) {
-  size_t i = 0;
-  size_t current_multiplier = 1;
-  size_t sz = m_blockchain.size();
+  m_blockchain.getShortChainHistory(ids);
+}
 
-  if(!sz)
-    return;
+void WalletSynchronizer::startBlocksPrefetch(std::shared_ptr<SynchronizationContext> context, const std::vector<crypto::hash>& portionIds) {
+  uint64_t startHeight = context->startHeight;
+  if (startHeight > m_blockchain.size())
+    return; //the portion can't be attached, processing fails anyway
 
-  size_t current_back_offset = 1;
-  bool genesis_included = false;
-
-  while(current_back_offset < sz) {
-    ids.push_back(m_blockchain[sz-current_back_offset]);
-    if(sz-current_back_offset == 0)
-      genesis_included = true;
-    if(i < 10) {
-      ++current_back_offset;
-    }else
-    {
-      current_back_offset += current_multiplier *= 2;
-    }
-    ++i;
-  }
+  //the blockchain we'll have once the portion is processed: our blocks below startHeight followed by the portion
+  std::list<crypto::hash> ids;
+  m_blockchain.getShortChainHistory(startHeight, portionIds, ids);
+
+  std::shared_ptr<BlocksPrefetch> prefetch = std::make_shared<BlocksPrefetch>();
+  context->prefetch = prefetch;
 
-  if(!genesis_included)
-    ids.push_back(m_blockchain[0]);
+  m_node.getNewBlocks(std::move(ids), prefetch->newBlocks, prefetch->startHeight, [prefetch] (std::error_code ec) { prefetch->complete(ec); });
 }
 
 void WalletSynchronizer::handleNewBlocksPortion(std::shared_ptr<SynchronizationContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
@@ -169,10 +186,10 @@ void WalletSynchronizer::handleNewBlocksPortion(std::shared_ptr<SynchronizationC
 
   try
   {
-    bool fillRequest = processNewBlocks(parameters);
-
-    if (fillRequest) {
-      parameters.nextRequest = makeGetNewBlocksRequest(context);
+    if (!context->outsScanned && scanNewBlocksForOuts(parameters)) {
+      //the blocks are processed when the global indices of our outputs arrive
+    } else if (processNewBlocks(parameters)) {
+      parameters.nextRequest = context->prefetch ? makeGetPrefetchedBlocksRequest(context) : makeGetNewBlocksRequest(context);
     }
   }
   catch (std::system_error& e) {
@@ -190,7 +207,148 @@ void WalletSynchronizer::handleNewBlocksPortion(std::shared_ptr<SynchronizationC
   nextRequest = parameters.nextRequest;
 }
 
-//returns true if new request should be performed
+//returns true if global indices of the found outputs should be requested before the blocks are processed
+bool WalletSynchronizer::scanNewBlocksForOuts(ProcessParameters& parameters) {
+  std::shared_ptr<SynchronizationContext> context = parameters.context;
+  context->outsScanned = true;
+
+  std::vector<BlockScanItem> items;
+  std::vector<crypto::hash> portionIds;
+  bool hasNewBlocks = false;
+
+  std::vector<cryptonote::Block> blocks(context->newBlocks.size());
+  std::vector<const cryptonote::Block*> blockPtrs;
+  size_t blockIndex = 0;
+  for (auto& blockEntry: context->newBlocks) {
+    if (m_isStoping) return false;
+
+    bool r = cryptonote::parse_and_validate_block_from_blob(blockEntry.block, blocks[blockIndex]);
+    throwIf(!r, cryptonote::error::INTERNAL_WALLET_ERROR);
+    blockPtrs.push_back(&blocks[blockIndex]);
+    ++blockIndex;
+  }
+
+  //the ids of the whole portion are hashed at once
+  bool r = cryptonote::get_block_hashes(blockPtrs, portionIds);
+  throwIf(!r, cryptonote::error::INTERNAL_WALLET_ERROR);
+
+  uint64_t height = context->startHeight;
+  blockIndex = 0;
+  for (auto& blockEntry: context->newBlocks) {
+    cryptonote::Block& b = blocks[blockIndex];
+    const crypto::hash& blockId = portionIds[blockIndex];
+    ++blockIndex;
+
+    bool alreadyHave = m_blockchain.hasBlock(height, blockId);
+    hasNewBlocks = hasNewBlocks || !alreadyHave;
+
+    if (!alreadyHave && b.timestamp + 60*60*24 > m_account.get_createtime()) {
+      items.push_back(BlockScanItem());
+      items.back().entry = &blockEntry;
+      items.back().block = std::move(b);
+    }
+
+    ++height;
+  }
+
+  //the portion brings new blocks, so we'll ask for the next one after processing it. Fetch it while this one is scanned
+  if (hasNewBlocks)
+    startBlocksPrefetch(context, portionIds);
+
+  std::atomic<size_t> nextItem(0);
+  auto worker = [this, &items, &nextItem] {
+    for (size_t i = nextItem.fetch_add(SCAN_RUN_BLOCKS); i < items.size() && !m_isStoping; i = nextItem.fetch_add(SCAN_RUN_BLOCKS)) {
+      scanBlocksForOuts(&items[i], std::min(SCAN_RUN_BLOCKS, items.size() - i));
+    }
+  };
+
+  size_t threadCount = std::min(m_scanThreadCount, (items.size() + SCAN_RUN_BLOCKS - 1) / SCAN_RUN_BLOCKS);
+  if (threadCount > 1) {
+    std::vector<std::future<void> > workers;
+    for (size_t i = 0; i < threadCount; ++i) {
+      workers.push_back(std::async(std::launch::async, worker));
+    }
+
+    for (auto& w: workers) {
+      w.get();
+    }
+  } else {
+    worker();
+  }
+
+  if (m_isStoping) return false;
+
+  //merge in the blocks order so the following requests and events don't depend on the scheduling
+  for (auto& item: items) {
+    for (auto& out: item.outs) {
+      context->transactionContext[out.first] = std::move(out.second);
+      context->requestedTransactions.push_back(out.first);
+    }
+  }
+
+  if (context->requestedTransactions.empty())
+    return false;
+
+  parameters.nextRequest = std::make_shared<WalletGetTransactionsOutsGlobalIndicesRequest>(context->requestedTransactions, context,
+      std::bind(&WalletSynchronizer::handleTransactionsOutsGlobalIndicesResponse, this, context, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+  return true;
+}
+
+void WalletSynchronizer::scanBlocksForOuts(BlockScanItem* items, size_t count) {
+  std::deque<cryptonote::Transaction> parsedTxs;
+  std::vector<const cryptonote::Transaction*> txs;
+  std::vector<BlockScanItem*> txItems;
+  std::vector<crypto::public_key> publicKeys;
+  auto addTransaction = [&](const cryptonote::Transaction& tx, BlockScanItem& item) {
+    crypto::public_key publicKey;
+    if (!getTxPubKey(tx, publicKey))
+      return; //Public key wasn't found in the transaction extra. Skipping transaction
+
+    txs.push_back(&tx);
+    txItems.push_back(&item);
+    publicKeys.push_back(publicKey);
+  };
+
+  for (size_t i = 0; i < count; ++i) {
+    addTransaction(items[i].block.minerTx, items[i]);
+
+    for (auto& txblob: items[i].entry->txs) {
+      parsedTxs.emplace_back();
+      bool r = parse_and_validate_tx_from_blob(txblob, parsedTxs.back());
+      throwIf(!r, cryptonote::error::INTERNAL_WALLET_ERROR);
+
+      addTransaction(parsedTxs.back(), items[i]);
+    }
+  }
+
+  std::vector<crypto::key_derivation> derivations(publicKeys.size());
+  std::unique_ptr<bool[]> validKeys(new bool[publicKeys.size()]);
+  crypto::generate_key_derivations(publicKeys.data(), publicKeys.size(), m_account.get_keys().m_view_secret_key, derivations.data(), validKeys.get());
+
+  for (size_t i = 0; i < txs.size(); ++i) {
+    //nobody can spend outputs sent with a key that isn't a point
+    if (validKeys[i])
+      scanTransactionForOuts(*txs[i], publicKeys[i], derivations[i], txItems[i]->outs);
+  }
+}
+
+void WalletSynchronizer::scanTransactionForOuts(const cryptonote::Transaction& tx, const crypto::public_key& publicKey, const crypto::key_derivation& derivation,
+    std::vector<std::pair<crypto::hash, TransactionContextInfo> >& outs) {
+  std::vector<size_t> myOuts;
+  uint64_t moneyInMyOuts = 0;
+  findMyOuts(m_account.get_keys(), tx, derivation, myOuts, moneyInMyOuts);
+
+  if (myOuts.empty() || !moneyInMyOuts)
+    return;
+
+  TransactionContextInfo txContext;
+  txContext.requestedOuts = std::move(myOuts);
+  txContext.receivedAmount = moneyInMyOuts;
+  txContext.transactionPubKey = publicKey;
+
+  outs.push_back(std::make_pair(cryptonote::get_transaction_hash(tx), std::move(txContext)));
+}
+
 bool WalletSynchronizer::processNewBlocks(ProcessParameters& parameters) {
   bool fillRequest = false;
   std::shared_ptr<SynchronizationContext> context = parameters.context;
@@ -209,9 +367,7 @@ bool WalletSynchronizer::processNewBlocks(ProcessParameters& parameters) {
 
       NextBlockAction action = handleNewBlockchainEntry(parameters, blockEntry, currentIndex);
 
-      if (action == INTERRUPT)
-        return false;
-      else if (action == CONTINUE)
+      if (action == CONTINUE)
         fillRequest = true;
 
       ++context->progress.blockIdx;
@@ -234,41 +390,33 @@ WalletSynchronizer::NextBlockAction WalletSynchronizer::handleNewBlockchainEntry
 
   crypto::hash blockId = get_block_hash(b);
   if (height >= m_blockchain.size()) {
-    r = processNewBlockchainEntry(parameters, blockEntry, b, blockId, height);
-
-    if (r) {
-      parameters.events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), std::error_code()));
-      return CONTINUE;
-    }
-    return INTERRUPT;
+    processNewBlockchainEntry(parameters, blockEntry, b, blockId, height);
+    parameters.events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), std::error_code()));
+    return CONTINUE;
   }
 
-  if(blockId != m_blockchain[height]) {
+  if(!m_blockchain.hasBlock(height, blockId)) {
     //split detected here !!!
+    //(or the id below the recent window isn't kept, then the same blocks are processed once more)
     //Wrong daemon response
     throwIf(height == parameters.context->startHeight, cryptonote::error::INTERNAL_WALLET_ERROR);
 
     detachBlockchain(height);
 
-    r = processNewBlockchainEntry(parameters, blockEntry, b, blockId, height);
-
-    if (r) {
-      parameters.events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), std::error_code()));
-      return CONTINUE;
-    }
-    return INTERRUPT;
+    processNewBlockchainEntry(parameters, blockEntry, b, blockId, height);
+    parameters.events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), std::error_code()));
+    return CONTINUE;
   }
 
   //we already have this block.
   return SKIP;
 }
 
-bool WalletSynchronizer::processNewBlockchainEntry(ProcessParameters& parameters, cryptonote::block_complete_entry& blockEntry, const cryptonote::Block& b, crypto::hash& blockId, uint64_t height) {
+void WalletSynchronizer::processNewBlockchainEntry(ProcessParameters& parameters, cryptonote::block_complete_entry& blockEntry, const cryptonote::Block& b, crypto::hash& blockId, uint64_t height) {
   throwIf(height != m_blockchain.size(), cryptonote::error::INTERNAL_WALLET_ERROR);
 
   if(b.timestamp + 60*60*24 > m_account.get_createtime()) {
-    if (!processMinersTx(parameters, b.minerTx, height, b.timestamp))
-      return false;
+    processMinersTx(parameters, b.minerTx, height, b.timestamp);
 
     auto txIt = blockEntry.txs.begin();
     std::advance(txIt, parameters.context->progress.transactionIdx);
@@ -280,56 +428,64 @@ bool WalletSynchronizer::processNewBlockchainEntry(ProcessParameters& parameters
       bool r = parse_and_validate_tx_from_blob(txblob, tx);
       throwIf(!r, cryptonote::error::INTERNAL_WALLET_ERROR);
 
-      r = processNewTransaction(parameters, tx, height, false, b.timestamp);
+      processNewTransaction(parameters, tx, height, false, b.timestamp);
       parameters.context->progress.transactionIdx++;
-
-      if (!r) return false;
     }
   }
 
   parameters.context->progress.transactionIdx = 0;
 
   m_blockchain.push_back(blockId);
-  return true;
 }
 
-bool WalletSynchronizer::processMinersTx(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, uint64_t timestamp) {
-  bool r = true;
-
+void WalletSynchronizer::processMinersTx(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, uint64_t timestamp) {
   if (!parameters.context->progress.minersTxProcessed) {
-    r = processNewTransaction(parameters, tx, height, true, timestamp);
+    processNewTransaction(parameters, tx, height, true, timestamp);
     parameters.context->progress.minersTxProcessed = true;
   }
-
-  return r;
 }
 
-bool WalletSynchronizer::processNewTransaction(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, bool isCoinbase, uint64_t timestamp) {
-  bool res = true;
-
+void WalletSynchronizer::processNewTransaction(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, bool isCoinbase, uint64_t timestamp) {
   processUnconfirmed(parameters, tx, height, timestamp);
-  std::vector<size_t> outs;
-  uint64_t moneyInMyOuts = 0;
-
-  crypto::public_key publicKey;
-  if (!getTxPubKey(tx, publicKey))
-    return true; //Public key wasn't found in the transaction extra. Skipping transaction
-
-  findMyOuts(m_account.get_keys(), tx, publicKey, outs, moneyInMyOuts);
-
-  if(!outs.empty() && moneyInMyOuts) {
-    fillGetTransactionOutsGlobalIndicesRequest(parameters, tx, outs, publicKey, height);
-    res = false;
-  }
 
+  uint64_t moneyInMyOuts = processMyOutputs(parameters, tx, height);
   uint64_t moneyInMyInputs = processMyInputs(tx);
 
   if (!moneyInMyOuts && !moneyInMyInputs)
-    return res; //There's nothing related to our account, skip it
+    return; //There's nothing related to our account, skip it
 
   updateTransactionsCache(parameters, tx, moneyInMyOuts, moneyInMyInputs, height, isCoinbase, timestamp);
+}
 
-  return res;
+//our outputs were found by scanNewBlocksForOuts, together with their global indices
+uint64_t WalletSynchronizer::processMyOutputs(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height) {
+  auto it = parameters.context->transactionContext.find(cryptonote::get_transaction_hash(tx));
+  if (it == parameters.context->transactionContext.end())
+    return 0;
+
+  const TransactionContextInfo& txContext = it->second;
+  for (size_t o: txContext.requestedOuts) {
+    throwIf(tx.vout.size() <= o || txContext.globalIndices.size() <= o, cryptonote::error::INTERNAL_WALLET_ERROR);
+
+    TransferDetails td;
+    td.blockHeight = height;
+    td.amount = tx.vout[o].amount;
+    td.outputKey = boost::get<cryptonote::TransactionOutputToKey>(tx.vout[o].target).key;
+    td.transactionPublicKey = txContext.transactionPubKey;
+    td.unlockTime = tx.unlockTime;
+    td.internalOutputIndex = o;
+    td.globalOutputIndex = txContext.globalIndices[o];
+    td.spent = false;
+    cryptonote::KeyPair in_ephemeral;
+    cryptonote::generate_key_image_helper(m_account.get_keys(), txContext.transactionPubKey, o, in_ephemeral, td.keyImage);
+    throwIf(in_ephemeral.pub != td.outputKey, cryptonote::error::INTERNAL_WALLET_ERROR);
+
+    m_transferDetails.addTransferDetails(td);
+  }
+
+  uint64_t money = txContext.receivedAmount;
+  parameters.context->transactionContext.erase(it);
+  return money;
 }
 
 uint64_t WalletSynchronizer::processMyInputs(const cryptonote::Transaction& tx) {
@@ -345,27 +501,12 @@ uint64_t WalletSynchronizer::processMyInputs(const cryptonote::Transaction& tx)
 
     money += boost::get<cryptonote::TransactionInputToKey>(in).amount;
 
-    TransferDetails& td = m_transferDetails.getTransferDetails(idx);
-    td.spent = true;
+    m_transferDetails.markTransferDetailsSpent(idx);
   }
 
   return money;
 }
 
-void WalletSynchronizer::fillGetTransactionOutsGlobalIndicesRequest(ProcessParameters& parameters, const cryptonote::Transaction& tx,
-    const std::vector<size_t>& outs, const crypto::public_key& publicKey, uint64_t height) {
-  crypto::hash txid = cryptonote::get_transaction_hash(tx);
-
-  TransactionContextInfo tx_context;
-  tx_context.requestedOuts = outs;
-  tx_context.transaction = tx;
-  tx_context.transactionPubKey = publicKey;
-
-  auto insert_result = parameters.context->transactionContext.emplace(txid, std::move(tx_context));
-
-  postGetTransactionOutsGlobalIndicesRequest(parameters, txid, insert_result.first->second.globalIndices, height);
-}
-
 void WalletSynchronizer::updateTransactionsCache(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t myOuts, uint64_t myInputs, uint64_t height, bool isCoinbase, uint64_t timestamp) {
 
   uint64_t allOuts = countOverallTxOutputs(tx);
@@ -414,60 +555,36 @@ void WalletSynchronizer::processUnconfirmed(ProcessParameters& parameters, const
   parameters.events.push_back(std::make_shared<WalletTransactionUpdatedEvent>(id));
 }
 
-void WalletSynchronizer::handleTransactionOutGlobalIndicesResponse(std::shared_ptr<SynchronizationContext> context, crypto::hash txid, uint64_t height,
+void WalletSynchronizer::handleTransactionsOutsGlobalIndicesResponse(std::shared_ptr<SynchronizationContext> context,
     std::deque<std::shared_ptr<WalletEvent> >& events, boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec) {
   if (m_isStoping) {
     return;
   }
 
   if (ec) {
-    events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), ec));
+    events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(context->startHeight, m_node.getLastLocalBlockHeight(), ec));
     return;
   }
 
-  try
-  {
-    auto it = context->transactionContext.find(txid);
-    if (it == context->transactionContext.end()) {
-      events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR)));
-      return;
-    }
-
-    cryptonote::Transaction& tx = it->second.transaction;
-    std::vector<size_t>& outs = it->second.requestedOuts;
-    crypto::public_key& tx_pub_key = it->second.transactionPubKey;
-    std::vector<uint64_t>& global_indices = it->second.globalIndices;
-
-    for (size_t o: outs) {
-      throwIf(tx.vout.size() <= o, cryptonote::error::INTERNAL_WALLET_ERROR);
-
-      TransferDetails td;
-      td.blockHeight = height;
-      td.internalOutputIndex = o;
-      td.globalOutputIndex = global_indices[o];
-      td.tx = tx;
-      td.spent = false;
-      cryptonote::KeyPair in_ephemeral;
-      cryptonote::generate_key_image_helper(m_account.get_keys(), tx_pub_key, o, in_ephemeral, td.keyImage);
-      throwIf(in_ephemeral.pub != boost::get<cryptonote::TransactionOutputToKey>(tx.vout[o].target).key, cryptonote::error::INTERNAL_WALLET_ERROR);
-
-      m_transferDetails.addTransferDetails(td);
-    }
-
-    context->transactionContext.erase(it);
-  }
-  catch (std::exception&) {
-    events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(height, m_node.getLastLocalBlockHeight(), make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR)));
+  if (context->requestedGlobalIndices.size() != context->requestedTransactions.size()) {
+    events.push_back(std::make_shared<WalletSynchronizationProgressUpdatedEvent>(context->startHeight, m_node.getLastLocalBlockHeight(), make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR)));
     return;
   }
 
+  for (size_t i = 0; i < context->requestedTransactions.size(); ++i) {
+    context->transactionContext[context->requestedTransactions[i]].globalIndices = std::move(context->requestedGlobalIndices[i]);
+  }
+
+  context->requestedTransactions.clear();
+  context->requestedGlobalIndices.clear();
+
   handleNewBlocksPortion(context, events, nextRequest, ec);
 }
 
 void WalletSynchronizer::detachBlockchain(uint64_t height) {
   m_transferDetails.detachTransferDetails(height);
 
-  m_blockchain.erase(m_blockchain.begin()+height, m_blockchain.end());
+  m_blockchain.detach(height);
 
   m_transactionsCache.detachTransactions(height);
 }
@@ -23,6 +23,7 @@
 
 #include "INode.h"
 #include "crypto/hash.h"
+#include "WalletBlockchainHistory.h"
 #include "WalletTransferDetails.h"
 #include "WalletUnconfirmedTransactions.h"
 #include "WalletUserTransactionsCache.h"
@@ -35,7 +36,7 @@ namespace CryptoNote {
 class WalletSynchronizer
 {
 public:
-  WalletSynchronizer(const cryptonote::account_base& account, INode& node, std::vector<crypto::hash>& blockchain, WalletTransferDetails& transferDetails,
+  WalletSynchronizer(const cryptonote::account_base& account, INode& node, WalletBlockchainHistory& blockchain, WalletTransferDetails& transferDetails,
       WalletUnconfirmedTransactions& unconfirmedTransactions, WalletUserTransactionsCache& transactionsCache);
 
   std::shared_ptr<WalletRequest> makeStartRefreshRequest();
@@ -50,39 +51,49 @@ private:
     boost::optional<std::shared_ptr<WalletRequest> > nextRequest;
   };
 
+  struct BlockScanItem {
+    const cryptonote::block_complete_entry* entry;
+    cryptonote::Block block;
+    std::vector<std::pair<crypto::hash, TransactionContextInfo> > outs;
+  };
+
   enum NextBlockAction {
-    INTERRUPT = 0,
-    CONTINUE,
+    CONTINUE = 0,
     SKIP
   };
 
   void handleNewBlocksPortion(std::shared_ptr<SynchronizationContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
       boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec);
-  void handleTransactionOutGlobalIndicesResponse(std::shared_ptr<SynchronizationContext> context, crypto::hash txid, uint64_t height,
+  void handleTransactionsOutsGlobalIndicesResponse(std::shared_ptr<SynchronizationContext> context,
       std::deque<std::shared_ptr<WalletEvent> >& events, boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec);
 
   void getShortChainHistory(std::list<crypto::hash>& ids);
+  void startBlocksPrefetch(std::shared_ptr<SynchronizationContext> context, const std::vector<crypto::hash>& portionIds);
 
+  bool scanNewBlocksForOuts(ProcessParameters& parameters);
+  void scanBlocksForOuts(BlockScanItem* items, size_t count);
+  void scanTransactionForOuts(const cryptonote::Transaction& tx, const crypto::public_key& publicKey, const crypto::key_derivation& derivation,
+      std::vector<std::pair<crypto::hash, TransactionContextInfo> >& outs);
   bool processNewBlocks(ProcessParameters& parameters);
   NextBlockAction handleNewBlockchainEntry(ProcessParameters& parameters, cryptonote::block_complete_entry& blockEntry, uint64_t height);
-  bool processNewBlockchainEntry(ProcessParameters& parameters, cryptonote::block_complete_entry& blockEntry, const cryptonote::Block& b, crypto::hash& blockId, uint64_t height);
-  bool processNewTransaction(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, bool isCoinbase, uint64_t timestamp);
-  bool processMinersTx(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, uint64_t timestamp);
+  void processNewBlockchainEntry(ProcessParameters& parameters, cryptonote::block_complete_entry& blockEntry, const cryptonote::Block& b, crypto::hash& blockId, uint64_t height);
+  void processNewTransaction(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, bool isCoinbase, uint64_t timestamp);
+  void processMinersTx(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, uint64_t timestamp);
   void processUnconfirmed(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height, uint64_t timestamp);
+  uint64_t processMyOutputs(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t height);
   uint64_t processMyInputs(const cryptonote::Transaction& tx);
   void updateTransactionsCache(ProcessParameters& parameters, const cryptonote::Transaction& tx, uint64_t myOuts, uint64_t myInputs, uint64_t height,
       bool isCoinbase, uint64_t timestamp);
   void detachBlockchain(uint64_t height);
   void refreshBalance(std::deque<std::shared_ptr<WalletEvent> >& events);
 
-  void fillGetTransactionOutsGlobalIndicesRequest(ProcessParameters& parameters, const cryptonote::Transaction& tx,
-      const std::vector<size_t>& outs, const crypto::public_key& publicKey, uint64_t height);
-  void postGetTransactionOutsGlobalIndicesRequest(ProcessParameters& parameters, const crypto::hash& hash, std::vector<uint64_t>& outsGlobalIndices, uint64_t height);
   std::shared_ptr<WalletRequest> makeGetNewBlocksRequest(std::shared_ptr<SynchronizationContext> context);
+  std::shared_ptr<WalletRequest> makeGetPrefetchedBlocksRequest(std::shared_ptr<SynchronizationContext> context);
+  void resetContext(SynchronizationContext& context);
 
   const cryptonote::account_base& m_account;
   INode& m_node;
-  std::vector<crypto::hash>& m_blockchain;
+  WalletBlockchainHistory& m_blockchain;
   WalletTransferDetails& m_transferDetails;
   WalletUnconfirmedTransactions& m_unconfirmedTransactions;
   WalletUserTransactionsCache& m_transactionsCache;
@@ -90,6 +101,7 @@ private:
   uint64_t m_actualBalance;
   uint64_t m_pendingBalance;
 
+  size_t m_scanThreadCount;
   bool m_isStoping;
 };
 
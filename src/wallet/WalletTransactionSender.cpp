@@ -15,6 +15,10 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <atomic>
+#include <future>
+#include <thread>
+
 // epee
 #include "misc_language.h"
 
@@ -46,12 +50,12 @@ void createChangeDestinations(const cryptonote::AccountPublicAddress& address, u
 }
 
 void constructTx(const cryptonote::account_keys keys, const std::vector<cryptonote::tx_source_entry>& sources, const std::vector<cryptonote::tx_destination_entry>& splittedDests,
-    const std::string& extra, uint64_t unlockTimestamp, uint64_t sizeLimit, cryptonote::Transaction& tx) {
+    const std::string& extra, uint64_t unlockTimestamp, uint64_t sizeLimit, size_t signThreads, cryptonote::Transaction& tx) {
   std::vector<uint8_t> extraVec;
   extraVec.reserve(extra.size());
   std::for_each(extra.begin(), extra.end(), [&extraVec] (const char el) { extraVec.push_back(el);});
 
-  bool r = cryptonote::construct_tx(keys, sources, splittedDests, extraVec, tx, unlockTimestamp);
+  bool r = cryptonote::construct_tx(keys, sources, splittedDests, extraVec, tx, unlockTimestamp, signThreads);
   CryptoNote::throwIf(!r, cryptonote::error::INTERNAL_WALLET_ERROR);
   CryptoNote::throwIf(cryptonote::get_object_blobsize(tx) >= sizeLimit, cryptonote::error::TRANSACTION_SIZE_TOO_BIG);
 }
@@ -61,6 +65,21 @@ void fillTransactionHash(const cryptonote::Transaction& tx, CryptoNote::Transact
   memcpy(hash.data(), reinterpret_cast<const uint8_t *>(&h), hash.size());
 }
 
+template <typename F>
+std::error_code catchError(F f) {
+  try {
+    f();
+  }
+  catch(std::system_error& ec) {
+    return ec.code();
+  }
+  catch(std::exception&) {
+    return make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR);
+  }
+
+  return std::error_code();
+}
+
 } //namespace
 
 namespace CryptoNote {
@@ -72,9 +91,12 @@ WalletTransactionSender::WalletTransactionSender(const cryptonote::Currency& cur
       m_sendingTxsStates(sendingTxsStates),
       m_transferDetails(transferDetails),
       m_unconfirmedTransactions(unconfirmedTransactions),
+      m_constructThreadCount(std::thread::hardware_concurrency()),
       m_isInitialized(false),
       m_isStoping(false) {
   m_upperTransactionSizeLimit = m_currency.blockGrantedFullRewardZone() * 125 / 100 - m_currency.minerTxBlobReservedSize();
+  if (m_constructThreadCount == 0)
+    m_constructThreadCount = 4;
 }
 
 void WalletTransactionSender::init(cryptonote::account_keys keys) {
@@ -119,19 +141,7 @@ std::shared_ptr<WalletRequest> WalletTransactionSender::makeSendRequest(Transact
   context->foundMoney = m_transferDetails.selectTransfersToSend(neededMoney, 0 == mixIn, context->dustPolicy.dustThreshold, context->selectedTransfers);
   throwIf(context->foundMoney < neededMoney, cryptonote::error::WRONG_AMOUNT);
 
-  TransferId firstTransferId = m_transactionsCache.insertTransfers(transfers);
-
-  TransactionInfo transaction;
-  transaction.firstTransferId = firstTransferId;
-  transaction.transferCount = transfers.size();
-  transaction.totalAmount = neededMoney;
-  transaction.fee = fee;
-  transaction.isCoinbase = false;
-  transaction.timestamp = 0;
-  transaction.extra = extra;
-  transaction.blockHeight = UNCONFIRMED_TRANSACTION_HEIGHT;
-
-  TransactionId txId = m_transactionsCache.insertTransaction(std::move(transaction));
+  TransactionId txId = insertTransaction(transfers, neededMoney, fee, extra);
   transactionId = txId;
   m_sendingTxsStates.sending(txId);
 
@@ -147,14 +157,91 @@ std::shared_ptr<WalletRequest> WalletTransactionSender::makeSendRequest(Transact
   return doSendTransaction(context, events);
 }
 
+std::shared_ptr<WalletRequest> WalletTransactionSender::makeSendBatchRequest(std::vector<TransactionId>& transactionIds, std::deque<std::shared_ptr<WalletEvent> >& events,
+    const std::vector<TransactionParameters>& transactions) {
+  if (!m_isInitialized)
+    throw std::system_error(make_error_code(cryptonote::error::NOT_INITIALIZED));
+
+  throwIf(transactions.empty(), cryptonote::error::ZERO_DESTINATION);
+
+  std::vector<TransfersSelection> selections(transactions.size());
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    const TransactionParameters& params = transactions[i];
+
+    throwIf(params.transfers.empty(), cryptonote::error::ZERO_DESTINATION);
+    validateTransfersAddresses(params.transfers);
+
+    selections[i].neededMoney = countNeededMoney(params.fee, params.transfers);
+    selections[i].addDust = 0 == params.mixIn;
+  }
+
+  //the whole batch is funded at once, so nothing is added to the cache if any of the transactions can't be
+  TxDustPolicy dustPolicy;
+  m_transferDetails.selectTransfersToSend(dustPolicy.dustThreshold, selections);
+  for (auto& selection: selections) {
+    throwIf(selection.foundMoney < selection.neededMoney, cryptonote::error::WRONG_AMOUNT);
+  }
+
+  std::shared_ptr<SendBatchContext> context = std::make_shared<SendBatchContext>();
+  std::vector<uint64_t> amounts;
+  uint64_t outsCount = 0;
+
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    const TransactionParameters& params = transactions[i];
+
+    TransactionId txId = insertTransaction(params.transfers, selections[i].neededMoney, params.fee, params.extra);
+    transactionIds.push_back(txId);
+    m_sendingTxsStates.sending(txId);
+
+    std::shared_ptr<SendTransactionContext> txContext = std::make_shared<SendTransactionContext>();
+    txContext->transactionId = txId;
+    txContext->foundMoney = selections[i].foundMoney;
+    txContext->selectedTransfers.swap(selections[i].selectedTransfers);
+    txContext->unlockTimestamp = params.unlockTimestamp;
+    txContext->dustPolicy = dustPolicy;
+    txContext->mixIn = params.mixIn;
+
+    if (txContext->mixIn) {
+      outsCount = std::max(outsCount, txContext->mixIn + 1);
+      for (auto idx: txContext->selectedTransfers) {
+        amounts.push_back(m_transferDetails.getTransferDetails(idx).amount);
+      }
+    }
+
+    context->transactions.push_back(txContext);
+  }
+
+  if (!amounts.empty()) {
+    return std::make_shared<WalletGetBatchRandomOutsByAmountsRequest>(amounts, outsCount, context, std::bind(&WalletTransactionSender::sendBatchRandomOutsByAmount,
+        this, context, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+  }
+
+  return doSendBatch(context, events);
+}
+
+TransactionId WalletTransactionSender::insertTransaction(const std::vector<Transfer>& transfers, uint64_t neededMoney, uint64_t fee, const std::string& extra) {
+  TransferId firstTransferId = m_transactionsCache.insertTransfers(transfers);
+
+  TransactionInfo transaction;
+  transaction.firstTransferId = firstTransferId;
+  transaction.transferCount = transfers.size();
+  transaction.totalAmount = neededMoney;
+  transaction.fee = fee;
+  transaction.isCoinbase = false;
+  transaction.timestamp = 0;
+  transaction.extra = extra;
+  transaction.blockHeight = UNCONFIRMED_TRANSACTION_HEIGHT;
+
+  return m_transactionsCache.insertTransaction(std::move(transaction));
+}
+
 std::shared_ptr<WalletRequest> WalletTransactionSender::makeGetRandomOutsRequest(std::shared_ptr<SendTransactionContext> context) {
   uint64_t outsCount = context->mixIn + 1;// add one to make possible (if need) to skip real output key
   std::vector<uint64_t> amounts;
 
   for (auto idx: context->selectedTransfers) {
     const TransferDetails& td = m_transferDetails.getTransferDetails(idx);
-    throwIf(td.tx.vout.size() <= td.internalOutputIndex, cryptonote::error::INTERNAL_WALLET_ERROR);
-    amounts.push_back(td.amount());
+    amounts.push_back(td.amount);
   }
 
   return std::make_shared<WalletGetRandomOutsByAmountsRequest>(amounts, outsCount, context, std::bind(&WalletTransactionSender::sendTransactionRandomOutsByAmount,
@@ -205,7 +292,7 @@ std::shared_ptr<WalletRequest> WalletTransactionSender::doSendTransaction(std::s
     splitDestinations(transaction.firstTransferId, transaction.transferCount, changeDts, context->dustPolicy, splittedDests);
 
     cryptonote::Transaction tx;
-    constructTx(m_keys, sources, splittedDests, transaction.extra, context->unlockTimestamp, m_upperTransactionSizeLimit, tx);
+    constructTx(m_keys, sources, splittedDests, transaction.extra, context->unlockTimestamp, m_upperTransactionSizeLimit, m_constructThreadCount, tx);
 
     fillTransactionHash(tx, transaction.hash);
 
@@ -225,6 +312,153 @@ std::shared_ptr<WalletRequest> WalletTransactionSender::doSendTransaction(std::s
   return std::shared_ptr<WalletRequest>();
 }
 
+void WalletTransactionSender::sendBatchRandomOutsByAmount(std::shared_ptr<SendBatchContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
+    boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec) {
+  if (m_isStoping) {
+    ec = make_error_code(cryptonote::error::TX_CANCELLED);
+  }
+
+  size_t requestedCount = 0;
+  for (auto& txContext: context->transactions) {
+    if (txContext->mixIn)
+      requestedCount += txContext->selectedTransfers.size();
+  }
+
+  if (!ec && context->outs.size() != requestedCount) {
+    ec = make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR);
+  }
+
+  if (ec) {
+    for (auto& txContext: context->transactions) {
+      events.push_back(std::make_shared<WalletSendTransactionCompletedEvent>(txContext->transactionId, ec));
+    }
+    return;
+  }
+
+  //the outs come in the order of the requested amounts, which is the order of the transactions
+  std::vector<std::shared_ptr<SendTransactionContext> > transactions;
+  auto outsIt = context->outs.begin();
+  for (auto& txContext: context->transactions) {
+    if (txContext->mixIn) {
+      auto outsEnd = outsIt + txContext->selectedTransfers.size();
+      txContext->outs.assign(std::make_move_iterator(outsIt), std::make_move_iterator(outsEnd));
+      outsIt = outsEnd;
+
+      auto scanty_it = std::find_if(txContext->outs.begin(), txContext->outs.end(), [&] (cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& out) {return out.outs.size() < txContext->mixIn;});
+      if (scanty_it != txContext->outs.end()) {
+        events.push_back(std::make_shared<WalletSendTransactionCompletedEvent>(txContext->transactionId, make_error_code(cryptonote::error::MIXIN_COUNT_TOO_BIG)));
+        continue;
+      }
+    }
+
+    transactions.push_back(txContext);
+  }
+
+  context->transactions.swap(transactions);
+  context->outs.clear();
+
+  std::shared_ptr<WalletRequest> req = doSendBatch(context, events);
+  if (req)
+    nextRequest = req;
+}
+
+std::shared_ptr<WalletRequest> WalletTransactionSender::doSendBatch(std::shared_ptr<SendBatchContext> context, std::deque<std::shared_ptr<WalletEvent> >& events) {
+  if (m_isStoping) {
+    for (auto& txContext: context->transactions) {
+      events.push_back(std::make_shared<WalletSendTransactionCompletedEvent>(txContext->transactionId, make_error_code(cryptonote::error::TX_CANCELLED)));
+    }
+    return std::shared_ptr<WalletRequest>();
+  }
+
+  size_t count = context->transactions.size();
+  std::vector<std::vector<cryptonote::tx_source_entry> > sources(count);
+  std::vector<std::vector<cryptonote::tx_destination_entry> > splittedDests(count);
+  std::vector<cryptonote::tx_destination_entry> changeDts(count);
+  std::vector<std::string> extras(count);
+  std::vector<cryptonote::Transaction> txs(count);
+  std::vector<std::error_code> errors(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    SendTransactionContext& txContext = *context->transactions[i];
+    errors[i] = catchError([&] {
+      const TransactionInfo& transaction = m_transactionsCache.getTransaction(txContext.transactionId);
+
+      prepareInputs(txContext.selectedTransfers, txContext.outs, sources[i], txContext.mixIn);
+
+      createChangeDestinations(m_keys.m_account_address, transaction.totalAmount, txContext.foundMoney, changeDts[i]);
+
+      splitDestinations(transaction.firstTransferId, transaction.transferCount, changeDts[i], txContext.dustPolicy, splittedDests[i]);
+      extras[i] = transaction.extra;
+    });
+  }
+
+  //ring signatures are the expensive part of a batch, the workers don't touch the wallet caches.
+  //Transactions are signed in parallel, the cores left over by a small batch sign the inputs of each of them
+  size_t threadCount = std::min(m_constructThreadCount, count);
+  size_t signThreadCount = std::max<size_t>(1, m_constructThreadCount / std::max<size_t>(1, threadCount));
+  std::atomic<size_t> nextTx(0);
+  auto worker = [&] {
+    for (size_t i = nextTx++; i < count; i = nextTx++) {
+      if (errors[i])
+        continue;
+
+      uint64_t unlockTimestamp = context->transactions[i]->unlockTimestamp;
+      errors[i] = catchError([&] {
+        constructTx(m_keys, sources[i], splittedDests[i], extras[i], unlockTimestamp, m_upperTransactionSizeLimit, signThreadCount, txs[i]);
+      });
+    }
+  };
+
+  if (threadCount > 1) {
+    std::vector<std::future<void> > workers;
+    for (size_t i = 0; i < threadCount; ++i) {
+      workers.push_back(std::async(std::launch::async, worker));
+    }
+
+    for (auto& w: workers) {
+      w.get();
+    }
+  } else {
+    worker();
+  }
+
+  std::vector<cryptonote::Transaction> relayedTxs;
+  for (size_t i = 0; i < count; ++i) {
+    TransactionId txId = context->transactions[i]->transactionId;
+    if (!errors[i]) {
+      errors[i] = catchError([&] {
+        TransactionInfo& transaction = m_transactionsCache.getTransaction(txId);
+        fillTransactionHash(txs[i], transaction.hash);
+
+        m_unconfirmedTransactions.add(txs[i], txId, changeDts[i].amount);
+      });
+    }
+
+    if (errors[i]) {
+      events.push_back(std::make_shared<WalletSendTransactionCompletedEvent>(txId, errors[i]));
+      continue;
+    }
+
+    context->relayedTransactions.push_back(txId);
+    relayedTxs.push_back(std::move(txs[i]));
+  }
+
+  if (relayedTxs.empty())
+    return std::shared_ptr<WalletRequest>();
+
+  notifyBalanceChanged(events);
+
+  return std::make_shared<WalletRelayTransactionsRequest>(std::move(relayedTxs), context, std::bind(&WalletTransactionSender::relayTransactionsCallback, this, context,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+}
+
+void WalletTransactionSender::relayTransactionsCallback(std::shared_ptr<SendBatchContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
+                                                         boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec) {
+  for (size_t i = 0; i < context->relayedTransactions.size(); ++i) {
+    relayTransactionCallback(context->relayedTransactions[i], events, nextRequest, ec ? ec : context->relayResults[i]);
+  }
+}
+
 void WalletTransactionSender::relayTransactionCallback(TransactionId txId, std::deque<std::shared_ptr<WalletEvent> >& events,
                                                         boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec) {
   if (m_isStoping) return;
@@ -283,8 +517,8 @@ void WalletTransactionSender::prepareInputs(const std::list<size_t>& selectedTra
   for (size_t idx: selectedTransfers) {
     sources.resize(sources.size()+1);
     cryptonote::tx_source_entry& src = sources.back();
-    TransferDetails& td = m_transferDetails.getTransferDetails(idx);
-    src.amount = td.amount();
+    const TransferDetails& td = m_transferDetails.getTransferDetails(idx);
+    src.amount = td.amount;
 
     //paste mixin transaction
     if(outs.size()) {
@@ -306,11 +540,11 @@ void WalletTransactionSender::prepareInputs(const std::list<size_t>& selectedTra
 
     cryptonote::tx_source_entry::output_entry real_oe;
     real_oe.first = td.globalOutputIndex;
-    real_oe.second = boost::get<cryptonote::TransactionOutputToKey>(td.tx.vout[td.internalOutputIndex].target).key;
+    real_oe.second = td.outputKey;
 
     auto interted_it = src.outputs.insert(it_to_insert, real_oe);
 
-    src.real_out_tx_key = get_tx_pub_key_from_extra(td.tx);
+    src.real_out_tx_key = td.transactionPublicKey;
     src.real_output = interted_it - src.outputs.begin();
     src.real_output_in_tx_index = td.internalOutputIndex;
     ++i;
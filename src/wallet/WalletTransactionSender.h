@@ -40,8 +40,11 @@ public:
 
   std::shared_ptr<WalletRequest> makeSendRequest(TransactionId& transactionId, std::deque<std::shared_ptr<WalletEvent> >& events, const std::vector<Transfer>& transfers,
       uint64_t fee, const std::string& extra = "", uint64_t mixIn = 0, uint64_t unlockTimestamp = 0);
+  std::shared_ptr<WalletRequest> makeSendBatchRequest(std::vector<TransactionId>& transactionIds, std::deque<std::shared_ptr<WalletEvent> >& events,
+      const std::vector<TransactionParameters>& transactions);
 
 private:
+  TransactionId insertTransaction(const std::vector<Transfer>& transfers, uint64_t neededMoney, uint64_t fee, const std::string& extra);
   std::shared_ptr<WalletRequest> makeGetRandomOutsRequest(std::shared_ptr<SendTransactionContext> context);
   std::shared_ptr<WalletRequest> doSendTransaction(std::shared_ptr<SendTransactionContext> context, std::deque<std::shared_ptr<WalletEvent> >& events);
   void prepareInputs(const std::list<size_t>& selectedTransfers, std::vector<cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& outs,
@@ -52,6 +55,11 @@ private:
     std::vector<cryptonote::tx_destination_entry>& splitted_dsts, uint64_t& dust);
   void sendTransactionRandomOutsByAmount(std::shared_ptr<SendTransactionContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
       boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec);
+  void sendBatchRandomOutsByAmount(std::shared_ptr<SendBatchContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
+      boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec);
+  std::shared_ptr<WalletRequest> doSendBatch(std::shared_ptr<SendBatchContext> context, std::deque<std::shared_ptr<WalletEvent> >& events);
+  void relayTransactionsCallback(std::shared_ptr<SendBatchContext> context, std::deque<std::shared_ptr<WalletEvent> >& events,
+      boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec);
   void relayTransactionCallback(TransactionId txId, std::deque<std::shared_ptr<WalletEvent> >& events,
                                 boost::optional<std::shared_ptr<WalletRequest> >& nextRequest, std::error_code ec);
   void notifyBalanceChanged(std::deque<std::shared_ptr<WalletEvent> >& events);
@@ -65,6 +73,7 @@ private:
   WalletTransferDetails& m_transferDetails;
   WalletUnconfirmedTransactions& m_unconfirmedTransactions;
   uint64_t m_upperTransactionSizeLimit;
+  size_t m_constructThreadCount;
 
   bool m_isInitialized;
   bool m_isStoping;
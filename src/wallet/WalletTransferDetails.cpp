@@ -17,6 +17,8 @@
 
 #include "WalletTransferDetails.h"
 
+#include <algorithm>
+#include <limits>
 #include <utility>
 #include <chrono>
 #include <random>
@@ -29,20 +31,62 @@
 
 namespace {
 
-template<typename URNG, typename T>
-T popRandomValue(URNG& randomGenerator, std::vector<T>& vec) {
-  CHECK_AND_ASSERT_MES(!vec.empty(), T(), "Vector must be non-empty");
+//bucket 0 holds zero amounts, bucket k > 0 holds amounts in (bucketUpperBound(k-1), bucketUpperBound(k)]
+uint64_t bucketUpperBound(size_t bucket) {
+  if (bucket == 0)
+    return 0;
 
-  std::uniform_int_distribution<size_t> distribution(0, vec.size() - 1);
-  size_t idx = distribution(randomGenerator);
+  uint64_t bound = 1;
+  for (size_t i = 1; i < bucket; ++i) {
+    if (bound > std::numeric_limits<uint64_t>::max() / 10)
+      return std::numeric_limits<uint64_t>::max();
 
-  T res = vec[idx];
-  if (idx + 1 != vec.size()) {
-    vec[idx] = vec.back();
+    bound *= 10;
   }
-  vec.resize(vec.size() - 1);
 
-  return res;
+  return bound;
+}
+
+size_t amountBucket(uint64_t amount) {
+  size_t bucket = 0;
+  while (amount > bucketUpperBound(bucket))
+    ++bucket;
+
+  return bucket;
+}
+
+struct TransfersPool {
+  std::vector<size_t>* transfers;
+  size_t available;
+  bool isBucket;
+};
+
+//picks a random transfer out of all pools, every transfer has the same chance. Picked transfers are moved to the pool's tail
+template<typename URNG, typename SwapHandler>
+size_t popRandomTransfer(URNG& randomGenerator, std::vector<TransfersPool>& pools, size_t& available, SwapHandler onSwap) {
+  std::uniform_int_distribution<size_t> distribution(0, available - 1);
+  size_t n = distribution(randomGenerator);
+
+  for (auto& pool: pools) {
+    if (n >= pool.available) {
+      n -= pool.available;
+      continue;
+    }
+
+    std::vector<size_t>& transfers = *pool.transfers;
+    size_t last = pool.available - 1;
+    if (n != last) {
+      std::swap(transfers[n], transfers[last]);
+      if (pool.isBucket)
+        onSwap(transfers, n, last);
+    }
+
+    --pool.available;
+    --available;
+    return transfers[last];
+  }
+
+  throw std::system_error(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
 }
 
 }
@@ -50,22 +94,39 @@ T popRandomValue(URNG& randomGenerator, std::vector<T>& vec) {
 namespace CryptoNote
 {
 
-WalletTransferDetails::WalletTransferDetails(const cryptonote::Currency& currency, const std::vector<crypto::hash>& blockchain) :
-  m_currency(currency), m_blockchain(blockchain) {
+WalletTransferDetails::WalletTransferDetails(const cryptonote::Currency& currency, const WalletBlockchainHistory& blockchain) :
+  m_unlockedBalance(0), m_unspentBalance(0), m_indexedBlockchainSize(0), m_savedTransfersCount(0), m_currency(currency), m_blockchain(blockchain) {
 }
 
 WalletTransferDetails::~WalletTransferDetails() {
 }
 
-TransferDetails& WalletTransferDetails::getTransferDetails(size_t idx) {
+const TransferDetails& WalletTransferDetails::getTransferDetails(size_t idx) const {
   return m_transfers.at(idx);
 }
 
 void WalletTransferDetails::addTransferDetails(const TransferDetails& details) {
+  refreshLocks();
+
   m_transfers.push_back(details);
   size_t idx = m_transfers.size() - 1;
 
   m_keyImages.insert(std::make_pair(details.keyImage, idx));
+
+  m_index.push_back(TransferIndexEntry());
+  indexTransfer(idx);
+}
+
+void WalletTransferDetails::markTransferDetailsSpent(size_t idx) {
+  TransferDetails& td = m_transfers.at(idx);
+  if (td.spent)
+    return;
+
+  unindexTransfer(idx);
+  td.spent = true;
+
+  if (idx < m_savedTransfersCount)
+    m_spentSinceSave.push_back(idx);
 }
 
 bool WalletTransferDetails::getTransferDetailsIdxByKeyImage(const crypto::key_image& image, size_t& idx) {
@@ -91,7 +152,7 @@ bool WalletTransferDetails::isTxSpendtimeUnlocked(uint64_t unlockTime) const {
 
 bool WalletTransferDetails::isTransferUnlocked(const TransferDetails& td) const
 {
-  if(!isTxSpendtimeUnlocked(td.tx.unlockTime))
+  if(!isTxSpendtimeUnlocked(td.unlockTime))
     return false;
 
   if(td.blockHeight + DEFAULT_TX_SPENDABLE_AGE > m_blockchain.size())
@@ -100,65 +161,251 @@ bool WalletTransferDetails::isTransferUnlocked(const TransferDetails& td) const
   return true;
 }
 
-uint64_t WalletTransferDetails::countActualBalance() const
-{
-  uint64_t amount = 0;
-  for (auto& transfer: m_transfers) {
-    if(!transfer.spent && isTransferUnlocked(transfer))
-      amount += transfer.amount();
+//the blockchain size starting from which the transfer is unlocked by height, see isTransferUnlocked
+uint64_t WalletTransferDetails::unlockBlockchainSize(const TransferDetails& td) const {
+  uint64_t size = td.blockHeight + DEFAULT_TX_SPENDABLE_AGE;
+
+  if (td.unlockTime < m_currency.maxBlockHeight() && td.unlockTime + 1 > m_currency.lockedTxAllowedDeltaBlocks()) {
+    size = std::max<uint64_t>(size, td.unlockTime + 1 - m_currency.lockedTxAllowedDeltaBlocks());
   }
 
-  return amount;
+  return size;
 }
 
-uint64_t WalletTransferDetails::countPendingBalance() const
-{
-  uint64_t amount = 0;
-  for (auto& td: m_transfers) {
-    if (!td.spent)
-      amount += td.amount();
-  }
+//the time starting from which the transfer is unlocked by its unlock time, zero for transfers locked by height only
+uint64_t WalletTransferDetails::unlockTimestamp(const TransferDetails& td) const {
+  if (td.unlockTime < m_currency.maxBlockHeight() || td.unlockTime <= m_currency.lockedTxAllowedDeltaSeconds())
+    return 0;
 
-  return amount;
+  return td.unlockTime - m_currency.lockedTxAllowedDeltaSeconds();
 }
 
-uint64_t WalletTransferDetails::selectTransfersToSend(uint64_t neededMoney, bool addDust, uint64_t dust, std::list<size_t>& selectedTransfers) {
-  std::vector<size_t> unusedTransfers;
-  std::vector<size_t> unusedDust;
+void WalletTransferDetails::rebuildIndex() {
+  m_index.assign(m_transfers.size(), TransferIndexEntry());
+  m_timeLockedTransfers.clear();
+  m_heightLockedTransfers.clear();
+  m_unlockedTransfers.clear();
+  for (auto& bucket: m_unlockedBuckets) {
+    bucket.clear();
+  }
+
+  m_unlockedBalance = 0;
+  m_unspentBalance = 0;
+  m_indexedBlockchainSize = m_blockchain.size();
 
   for (size_t i = 0; i < m_transfers.size(); ++i) {
-    const TransferDetails& td = m_transfers[i];
-    if (!td.spent && isTransferUnlocked(td)) {
-      if (dust < td.amount())
-        unusedTransfers.push_back(i);
-      else
-        unusedDust.push_back(i);
-    }
+    indexTransfer(i);
   }
+}
 
-  std::default_random_engine randomGenerator(crypto::rand<std::default_random_engine::result_type>());
-  bool selectOneDust = addDust && !unusedDust.empty();
-  uint64_t foundMoney = 0;
-  while (foundMoney < neededMoney && (!unusedTransfers.empty() || !unusedDust.empty())) {
-    size_t idx;
-    if (selectOneDust) {
-      idx = popRandomValue(randomGenerator, unusedDust);
-      selectOneDust = false;
+//moves transfers between locked and unlocked sets according to the current blockchain size and time
+void WalletTransferDetails::refreshLocks() {
+  size_t blockchainSize = m_blockchain.size();
+
+  if (blockchainSize < m_indexedBlockchainSize) {
+    //the blockchain was detached, some transfers are locked again
+    auto it = m_unlockedTransfers.upper_bound(std::make_pair(static_cast<uint64_t>(blockchainSize), std::numeric_limits<size_t>::max()));
+    while (it != m_unlockedTransfers.end()) {
+      size_t idx = it->second;
+      it = m_unlockedTransfers.erase(it);
+
+      removeFromBucket(idx);
+      m_unlockedBalance -= m_transfers[idx].amount;
+
+      m_index[idx].state = HEIGHT_LOCKED;
+      m_heightLockedTransfers.insert(std::make_pair(m_index[idx].lockKey, idx));
     }
-    else
-    {
-      idx = !unusedTransfers.empty() ? popRandomValue(randomGenerator, unusedTransfers) : popRandomValue(randomGenerator, unusedDust);
+  }
+
+  m_indexedBlockchainSize = blockchainSize;
+
+  uint64_t now = static_cast<uint64_t>(time(NULL));
+  while (!m_timeLockedTransfers.empty() && m_timeLockedTransfers.begin()->first <= now) {
+    size_t idx = m_timeLockedTransfers.begin()->second;
+    m_timeLockedTransfers.erase(m_timeLockedTransfers.begin());
+    lockOrUnlockTransfer(idx);
+  }
+
+  while (!m_heightLockedTransfers.empty() && m_heightLockedTransfers.begin()->first <= blockchainSize) {
+    size_t idx = m_heightLockedTransfers.begin()->second;
+    m_heightLockedTransfers.erase(m_heightLockedTransfers.begin());
+    unlockTransfer(idx);
+  }
+}
+
+void WalletTransferDetails::indexTransfer(size_t idx) {
+  const TransferDetails& td = m_transfers[idx];
+  if (td.spent) {
+    m_index[idx].state = SPENT;
+    return;
+  }
+
+  m_unspentBalance += td.amount;
+  lockOrUnlockTransfer(idx);
+}
+
+void WalletTransferDetails::unindexTransfer(size_t idx) {
+  TransferIndexEntry& entry = m_index[idx];
+  const TransferDetails& td = m_transfers[idx];
+
+  switch (entry.state) {
+  case SPENT:
+    return;
+  case TIME_LOCKED:
+    m_timeLockedTransfers.erase(std::make_pair(entry.lockKey, idx));
+    break;
+  case HEIGHT_LOCKED:
+    m_heightLockedTransfers.erase(std::make_pair(entry.lockKey, idx));
+    break;
+  case UNLOCKED:
+    m_unlockedTransfers.erase(std::make_pair(entry.lockKey, idx));
+    removeFromBucket(idx);
+    m_unlockedBalance -= td.amount;
+    break;
+  }
+
+  m_unspentBalance -= td.amount;
+  entry.state = SPENT;
+}
+
+void WalletTransferDetails::lockOrUnlockTransfer(size_t idx) {
+  const TransferDetails& td = m_transfers[idx];
+  TransferIndexEntry& entry = m_index[idx];
+
+  uint64_t timestamp = unlockTimestamp(td);
+  if (timestamp > static_cast<uint64_t>(time(NULL))) {
+    entry.state = TIME_LOCKED;
+    entry.lockKey = timestamp;
+    m_timeLockedTransfers.insert(std::make_pair(timestamp, idx));
+    return;
+  }
+
+  entry.lockKey = unlockBlockchainSize(td);
+  if (entry.lockKey > m_indexedBlockchainSize) {
+    entry.state = HEIGHT_LOCKED;
+    m_heightLockedTransfers.insert(std::make_pair(entry.lockKey, idx));
+    return;
+  }
+
+  unlockTransfer(idx);
+}
+
+void WalletTransferDetails::unlockTransfer(size_t idx) {
+  TransferIndexEntry& entry = m_index[idx];
+  std::vector<size_t>& bucket = m_unlockedBuckets[amountBucket(m_transfers[idx].amount)];
+
+  entry.state = UNLOCKED;
+  entry.bucketPosition = bucket.size();
+  bucket.push_back(idx);
+  m_unlockedTransfers.insert(std::make_pair(entry.lockKey, idx));
+  m_unlockedBalance += m_transfers[idx].amount;
+}
+
+void WalletTransferDetails::removeFromBucket(size_t idx) {
+  std::vector<size_t>& bucket = m_unlockedBuckets[amountBucket(m_transfers[idx].amount)];
+  size_t position = m_index[idx].bucketPosition;
+
+  bucket[position] = bucket.back();
+  m_index[bucket[position]].bucketPosition = position;
+  bucket.pop_back();
+}
+
+uint64_t WalletTransferDetails::countActualBalance()
+{
+  refreshLocks();
+  return m_unlockedBalance;
+}
+
+uint64_t WalletTransferDetails::countPendingBalance() const
+{
+  return m_unspentBalance;
+}
+
+uint64_t WalletTransferDetails::selectTransfersToSend(uint64_t neededMoney, bool addDust, uint64_t dust, std::list<size_t>& selectedTransfers) {
+  std::vector<TransfersSelection> selections(1);
+  selections[0].neededMoney = neededMoney;
+  selections[0].addDust = addDust;
+
+  selectTransfersToSend(dust, selections);
+
+  selectedTransfers.splice(selectedTransfers.end(), selections[0].selectedTransfers);
+  return selections[0].foundMoney;
+}
+
+void WalletTransferDetails::selectTransfersToSend(uint64_t dust, std::vector<TransfersSelection>& selections) {
+  refreshLocks();
+
+  std::vector<TransfersPool> unusedTransfers;
+  std::vector<TransfersPool> unusedDust;
+  size_t transfersCount = 0;
+  size_t dustCount = 0;
+
+  //only the bucket the dust threshold falls into has to be split
+  std::vector<size_t> splitTransfers;
+  std::vector<size_t> splitDust;
+
+  for (size_t i = 0; i < m_unlockedBuckets.size(); ++i) {
+    std::vector<size_t>& bucket = m_unlockedBuckets[i];
+    if (bucket.empty())
+      continue;
+
+    if (bucketUpperBound(i) <= dust) {
+      unusedDust.push_back(TransfersPool{&bucket, bucket.size(), true});
+      dustCount += bucket.size();
+    } else if (bucketUpperBound(i - 1) >= dust) {
+      unusedTransfers.push_back(TransfersPool{&bucket, bucket.size(), true});
+      transfersCount += bucket.size();
+    } else {
+      for (size_t idx: bucket) {
+        if (dust < m_transfers[idx].amount)
+          splitTransfers.push_back(idx);
+        else
+          splitDust.push_back(idx);
+      }
     }
+  }
+
+  if (!splitTransfers.empty()) {
+    unusedTransfers.push_back(TransfersPool{&splitTransfers, splitTransfers.size(), false});
+    transfersCount += splitTransfers.size();
+  }
 
-    selectedTransfers.push_back(idx);
-    foundMoney += m_transfers[idx].amount();
+  if (!splitDust.empty()) {
+    unusedDust.push_back(TransfersPool{&splitDust, splitDust.size(), false});
+    dustCount += splitDust.size();
   }
 
-  return foundMoney;
+  auto onSwap = [this] (std::vector<size_t>& bucket, size_t a, size_t b) {
+    m_index[bucket[a]].bucketPosition = a;
+    m_index[bucket[b]].bucketPosition = b;
+  };
+
+  std::default_random_engine randomGenerator(crypto::rand<std::default_random_engine::result_type>());
+
+  //popped transfers leave the pools, so the selections of a batch never share an output
+  for (auto& selection: selections) {
+    bool selectOneDust = selection.addDust && dustCount != 0;
+    selection.foundMoney = 0;
+    while (selection.foundMoney < selection.neededMoney && (transfersCount != 0 || dustCount != 0)) {
+      size_t idx;
+      if (selectOneDust) {
+        idx = popRandomTransfer(randomGenerator, unusedDust, dustCount, onSwap);
+        selectOneDust = false;
+      }
+      else
+      {
+        idx = transfersCount != 0 ? popRandomTransfer(randomGenerator, unusedTransfers, transfersCount, onSwap) : popRandomTransfer(randomGenerator, unusedDust, dustCount, onSwap);
+      }
+
+      selection.selectedTransfers.push_back(idx);
+      selection.foundMoney += m_transfers[idx].amount;
+    }
+  }
 }
 
 void WalletTransferDetails::detachTransferDetails(size_t height) {
-  auto it = std::find_if(m_transfers.begin(), m_transfers.end(), [&](const TransferDetails& td){return td.blockHeight >= height;});
+  //transfers are added in the blockchain order
+  auto it = std::lower_bound(m_transfers.begin(), m_transfers.end(), height, [](const TransferDetails& td, size_t h) { return td.blockHeight < h; });
   size_t start = it - m_transfers.begin();
 
   for(size_t i = start; i!= m_transfers.size();i++) {
@@ -166,8 +413,17 @@ void WalletTransferDetails::detachTransferDetails(size_t height) {
     if(ki == m_keyImages.end()) throw std::system_error(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
 
     m_keyImages.erase(ki);
+    unindexTransfer(i);
   }
   m_transfers.erase(it, m_transfers.end());
+  m_index.resize(start);
+
+  m_savedTransfersCount = std::min(m_savedTransfersCount, start);
+}
+
+void WalletTransferDetails::resetChanges() {
+  m_savedTransfersCount = m_transfers.size();
+  m_spentSinceSave.clear();
 }
 
 } /* namespace CryptoNote */
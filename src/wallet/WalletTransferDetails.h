@@ -17,44 +17,61 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <list>
+#include <set>
 #include <unordered_map>
 
 #include "cryptonote_core/cryptonote_format_utils.h"
 #include "cryptonote_core/Currency.h"
 #include "IWallet.h"
+#include "WalletBlockchainHistory.h"
+#include "WalletErrors.h"
 
 namespace CryptoNote {
 
+//an output owned by the wallet. Keeps only what spending the output needs, not the whole transaction
 struct TransferDetails
 {
   uint64_t blockHeight;
-  cryptonote::Transaction tx;
+  uint64_t amount;
+  crypto::public_key outputKey;
+  crypto::public_key transactionPublicKey;
+  uint64_t unlockTime;
   size_t internalOutputIndex;
   uint64_t globalOutputIndex;
   bool spent;
   crypto::key_image keyImage;
+};
 
-  uint64_t amount() const
-  {
-    return tx.vout[internalOutputIndex].amount;
-  }
+//a coin selection request of one transaction in a batch
+struct TransfersSelection
+{
+  uint64_t neededMoney;
+  bool addDust;
+  uint64_t foundMoney;
+  std::list<size_t> selectedTransfers;
 };
 
 class WalletTransferDetails
 {
 public:
-  WalletTransferDetails(const cryptonote::Currency& currency, const std::vector<crypto::hash>& blockchain);
+  WalletTransferDetails(const cryptonote::Currency& currency, const WalletBlockchainHistory& blockchain);
   ~WalletTransferDetails();
 
-  TransferDetails& getTransferDetails(size_t idx);
+  const TransferDetails& getTransferDetails(size_t idx) const;
   void addTransferDetails(const TransferDetails& details);
+  void markTransferDetailsSpent(size_t idx);
   bool getTransferDetailsIdxByKeyImage(const crypto::key_image& image, size_t& idx);
 
-  uint64_t countActualBalance() const;
+  uint64_t countActualBalance();
   uint64_t countPendingBalance() const;
   bool isTransferUnlocked(const TransferDetails& td) const;
 
   uint64_t selectTransfersToSend(uint64_t neededMoney, bool addDust, uint64_t dust, std::list<size_t>& selectedTransfers);
+  void selectTransfersToSend(uint64_t dust, std::vector<TransfersSelection>& selections);
 
   void detachTransferDetails(size_t height);
 
@@ -64,17 +81,67 @@ public:
   template<typename Archive>
   void load(Archive& ar);
 
+  //changes since the last save or load, for the wallet journal
+  template <typename Archive>
+  void saveChanges(Archive& ar) const;
+  //the index isn't updated, call rebuildIndex after the last of the changes
+  template<typename Archive>
+  void loadChanges(Archive& ar);
+  void resetChanges();
+
+  void rebuildIndex();
+
 private:
   bool isTxSpendtimeUnlocked(uint64_t unlock_time) const;
 
+  uint64_t unlockBlockchainSize(const TransferDetails& td) const;
+  uint64_t unlockTimestamp(const TransferDetails& td) const;
+
+  void refreshLocks();
+  void indexTransfer(size_t idx);
+  void unindexTransfer(size_t idx);
+  void lockOrUnlockTransfer(size_t idx);
+  void unlockTransfer(size_t idx);
+  void removeFromBucket(size_t idx);
+
   typedef std::vector<TransferDetails> TransferContainer;
   TransferContainer m_transfers;
 
+  //where an unspent transfer lives in the index, kept in parallel to m_transfers
+  enum TransferState {
+    SPENT = 0,
+    TIME_LOCKED,
+    HEIGHT_LOCKED,
+    UNLOCKED
+  };
+
+  struct TransferIndexEntry {
+    TransferState state;
+    uint64_t lockKey;
+    size_t bucketPosition;
+  };
+
+  static const size_t AMOUNT_BUCKETS_COUNT = 22;
+
+  //unspent transfers, rebuilt on load and kept up to date on receive, spend and detach
+  std::vector<TransferIndexEntry> m_index;
+  std::set<std::pair<uint64_t, size_t> > m_timeLockedTransfers;
+  std::set<std::pair<uint64_t, size_t> > m_heightLockedTransfers;
+  std::set<std::pair<uint64_t, size_t> > m_unlockedTransfers;
+  std::array<std::vector<size_t>, AMOUNT_BUCKETS_COUNT> m_unlockedBuckets;
+  uint64_t m_unlockedBalance;
+  uint64_t m_unspentBalance;
+  size_t m_indexedBlockchainSize;
+
   typedef std::unordered_map<crypto::key_image, size_t> KeyImagesContainer;
   KeyImagesContainer m_keyImages;
 
+  //transfers below m_savedTransfersCount are in the journal, only their spent flags can change
+  size_t m_savedTransfersCount;
+  std::vector<size_t> m_spentSinceSave;
+
   const cryptonote::Currency& m_currency;
-  const std::vector<crypto::hash>& m_blockchain;
+  const WalletBlockchainHistory& m_blockchain;
 };
 
 template <typename Archive>
@@ -92,6 +159,56 @@ void WalletTransferDetails::load(Archive& ar)
 {
   ar >> m_transfers;
   ar >> m_keyImages;
+
+  rebuildIndex();
+  resetChanges();
+}
+
+template <typename Archive>
+void WalletTransferDetails::saveChanges(Archive& ar) const
+{
+  uint64_t keptCount = m_savedTransfersCount;
+
+  std::vector<size_t> spent;
+  std::copy_if(m_spentSinceSave.begin(), m_spentSinceSave.end(), std::back_inserter(spent), [keptCount] (size_t idx) { return idx < keptCount; });
+
+  TransferContainer added(m_transfers.begin() + m_savedTransfersCount, m_transfers.end());
+
+  ar << keptCount;
+  ar << spent;
+  ar << added;
+}
+
+template<typename Archive>
+void WalletTransferDetails::loadChanges(Archive& ar)
+{
+  uint64_t keptCount;
+  std::vector<size_t> spent;
+  TransferContainer added;
+
+  ar >> keptCount;
+  ar >> spent;
+  ar >> added;
+
+  if (keptCount > m_transfers.size()) {
+    throw std::system_error(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
+  }
+
+  for (size_t i = keptCount; i < m_transfers.size(); ++i) {
+    m_keyImages.erase(m_transfers[i].keyImage);
+  }
+  m_transfers.resize(keptCount);
+
+  for (size_t idx: spent) {
+    m_transfers.at(idx).spent = true;
+  }
+
+  for (const TransferDetails& td: added) {
+    m_keyImages[td.keyImage] = m_transfers.size();
+    m_transfers.push_back(td);
+  }
+
+  resetChanges();
 }
 
 } //namespace CryptoNote
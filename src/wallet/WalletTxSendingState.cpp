@@ -39,4 +39,14 @@ WalletTxSendingState::State WalletTxSendingState::state(TransactionId id) {
 
   return it->second;
 }
+
+std::vector<TransactionId> WalletTxSendingState::erroredTransactions() const {
+  std::vector<TransactionId> ids;
+  for (auto& state: m_states) {
+    if (state.second == ERRORED)
+      ids.push_back(state.first);
+  }
+
+  return ids;
+}
 } //namespace CryptoNote
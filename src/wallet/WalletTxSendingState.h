@@ -20,6 +20,7 @@
 #include "IWallet.h"
 
 #include <map>
+#include <vector>
 #include <mutex>
 
 namespace CryptoNote {
@@ -38,6 +39,7 @@ public:
   void sent(TransactionId id);
   void error(TransactionId id);
   State state(TransactionId id);
+  std::vector<TransactionId> erroredTransactions() const;
 
 private:
   std::map<TransactionId, State> m_states;
@@ -96,12 +96,20 @@ void WalletUserTransactionsCache::detachTransactions(uint64_t height) {
     if (tx.blockHeight >= height) {
       tx.blockHeight = UNCONFIRMED_TRANSACTION_HEIGHT;
       tx.timestamp = 0;
+
+      if (id < m_savedTransactionsCount)
+        m_changedTransactions.insert(id);
     }
   }
 }
 
 TransactionInfo& WalletUserTransactionsCache::getTransaction(TransactionId transactionId) {
-  return m_transactions.at(transactionId);
+  TransactionInfo& transaction = m_transactions.at(transactionId);
+
+  if (transactionId < m_savedTransactionsCount)
+    m_changedTransactions.insert(transactionId);
+
+  return transaction;
 }
 
 void WalletUserTransactionsCache::getGoodItems(bool saveDetailed, UserTransactions& transactions, UserTransfers& transfers) {
@@ -172,7 +180,19 @@ TransferId WalletUserTransactionsCache::insertTransfers(const std::vector<Transf
 }
 
 Transfer& WalletUserTransactionsCache::getTransfer(TransferId transferId) {
-  return m_transfers.at(transferId);
+  Transfer& transfer = m_transfers.at(transferId);
+
+  if (transferId < m_savedTransfersCount)
+    m_changedTransfers.insert(transferId);
+
+  return transfer;
+}
+
+void WalletUserTransactionsCache::resetChanges() {
+  m_savedTransactionsCount = m_transactions.size();
+  m_savedTransfersCount = m_transfers.size();
+  m_changedTransactions.clear();
+  m_changedTransfers.clear();
 }
 
 } //namespace CryptoNote
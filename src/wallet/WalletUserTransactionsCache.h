@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <set>
+#include <utility>
+#include <vector>
+
 #include "crypto/hash.h"
 #include "IWallet.h"
 #include "WalletTxSendingState.h"
@@ -26,7 +30,7 @@ namespace CryptoNote {
 class WalletUserTransactionsCache
 {
 public:
-  WalletUserTransactionsCache(WalletTxSendingState& states) : m_sendingTxsStates(states) {}
+  WalletUserTransactionsCache(WalletTxSendingState& states) : m_savedTransactionsCount(0), m_savedTransfersCount(0), m_sendingTxsStates(states) {}
 
   template <typename Archive>
   void save(Archive& ar, bool saveDetailed, bool saveCache);
@@ -34,6 +38,17 @@ public:
   template<typename Archive>
   void load(Archive& ar);
 
+  //the journal keeps the ids stable, so errored transactions are saved too
+  template <typename Archive>
+  void saveAll(Archive& ar) const;
+
+  //changes since the last save or load, for the wallet journal
+  template <typename Archive>
+  void saveChanges(Archive& ar) const;
+  template<typename Archive>
+  void loadChanges(Archive& ar);
+  void resetChanges();
+
   size_t getTransactionCount() const;
   size_t getTransferCount() const;
 
@@ -63,6 +78,12 @@ private:
   UserTransactions m_transactions;
   UserTransfers m_transfers;
 
+  //items below the saved counts are in the journal, the changed ones have been handed out for modification since
+  size_t m_savedTransactionsCount;
+  size_t m_savedTransfersCount;
+  std::set<TransactionId> m_changedTransactions;
+  std::set<TransferId> m_changedTransfers;
+
   WalletTxSendingState& m_sendingTxsStates;
 };
 
@@ -70,6 +91,60 @@ template<typename Archive>
 void WalletUserTransactionsCache::load(Archive& ar) {
   ar >> m_transactions;
   ar >> m_transfers;
+
+  resetChanges();
+}
+
+template <typename Archive>
+void WalletUserTransactionsCache::saveAll(Archive& ar) const {
+  ar << m_transactions;
+  ar << m_transfers;
+}
+
+template <typename Archive>
+void WalletUserTransactionsCache::saveChanges(Archive& ar) const {
+  std::vector<std::pair<TransactionId, TransactionInfo> > changedTransactions;
+  for (TransactionId id: m_changedTransactions) {
+    changedTransactions.push_back(std::make_pair(id, m_transactions[id]));
+  }
+
+  std::vector<std::pair<TransferId, Transfer> > changedTransfers;
+  for (TransferId id: m_changedTransfers) {
+    changedTransfers.push_back(std::make_pair(id, m_transfers[id]));
+  }
+
+  UserTransactions addedTransactions(m_transactions.begin() + m_savedTransactionsCount, m_transactions.end());
+  UserTransfers addedTransfers(m_transfers.begin() + m_savedTransfersCount, m_transfers.end());
+
+  ar << changedTransactions;
+  ar << addedTransactions;
+  ar << changedTransfers;
+  ar << addedTransfers;
+}
+
+template<typename Archive>
+void WalletUserTransactionsCache::loadChanges(Archive& ar) {
+  std::vector<std::pair<TransactionId, TransactionInfo> > changedTransactions;
+  UserTransactions addedTransactions;
+  std::vector<std::pair<TransferId, Transfer> > changedTransfers;
+  UserTransfers addedTransfers;
+
+  ar >> changedTransactions;
+  ar >> addedTransactions;
+  ar >> changedTransfers;
+  ar >> addedTransfers;
+
+  for (auto& changed: changedTransactions) {
+    m_transactions.at(changed.first) = changed.second;
+  }
+  m_transactions.insert(m_transactions.end(), addedTransactions.begin(), addedTransactions.end());
+
+  for (auto& changed: changedTransfers) {
+    m_transfers.at(changed.first) = changed.second;
+  }
+  m_transfers.insert(m_transfers.end(), addedTransfers.begin(), addedTransfers.end());
+
+  resetChanges();
 }
 
 template <typename Archive>
@@ -226,12 +226,14 @@ void wallet2::process_unconfirmed(const cryptonote::Transaction& tx)
 bool wallet2::addNewBlockchainEntry(const crypto::hash& bl_id, uint64_t start_height, uint64_t current_index)
 {
   if (current_index < m_blockchain.size()) {
-    if (bl_id != m_blockchain[current_index]) {
-      //split detected here !!!
+    if (!m_blockchain.hasBlock(current_index, bl_id)) {
+      //split detected here !!! (or the id isn't kept below the recent window, then the block is processed once more)
+      crypto::hash local_id = null_hash;
+      m_blockchain.getBlockId(current_index, local_id);
       THROW_WALLET_EXCEPTION_IF(current_index == start_height, error::wallet_internal_error,
         "wrong daemon response: split starts from the first block in response " + string_tools::pod_to_hex(bl_id) +
         " (height " + std::to_string(start_height) + "), local block id at this height: " +
-        string_tools::pod_to_hex(m_blockchain[current_index]));
+        string_tools::pod_to_hex(local_id));
 
       detach_blockchain(current_index);
     } else {
@@ -294,29 +296,7 @@ size_t wallet2::processNewBlockchainEntry(TxQueue& queue, const cryptonote::bloc
 //----------------------------------------------------------------------------------------------------
 void wallet2::get_short_chain_history(std::list<crypto::hash>& ids) const
 {
-  size_t i = 0;
-  size_t current_multiplier = 1;
-  size_t sz = m_blockchain.size();
-  if(!sz)
-    return;
-  size_t current_back_offset = 1;
-  bool genesis_included = false;
-  while(current_back_offset < sz)
-  {
-    ids.push_back(m_blockchain[sz-current_back_offset]);
-    if(sz-current_back_offset == 0)
-      genesis_included = true;
-    if(i < 10)
-    {
-      ++current_back_offset;
-    }else
-    {
-      current_back_offset += current_multiplier *= 2;
-    }
-    ++i;
-  }
-  if(!genesis_included)
-    ids.push_back(m_blockchain[0]);
+  m_blockchain.getShortChainHistory(ids);
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -542,8 +522,8 @@ size_t wallet2::detach_blockchain(uint64_t height)
     }
   }
 
-  size_t blocks_detached = m_blockchain.end() - (m_blockchain.begin()+height);
-  m_blockchain.erase(m_blockchain.begin()+height, m_blockchain.end());
+  size_t blocks_detached = m_blockchain.size() - height;
+  m_blockchain.detach(height);
 
   for (auto it = m_payments.begin(); it != m_payments.end(); )
   {
@@ -587,8 +567,7 @@ bool wallet2::store_keys(const std::string& keys_file_name, const std::string& p
   wallet2::keys_file_data keys_file_data = boost::value_initialized<wallet2::keys_file_data>();
 
   crypto::chacha8_key key;
-  crypto::cn_context cn_context;
-  crypto::generate_chacha8_key(cn_context, password, key);
+  crypto::generate_chacha8_key(password, key);
   std::string cipher;
   cipher.resize(account_data.size());
   keys_file_data.iv = crypto::rand<crypto::chacha8_iv>();
@@ -623,8 +602,7 @@ void wallet2::load_keys(const std::string& keys_file_name, const std::string& pa
   THROW_WALLET_EXCEPTION_IF(!r, error::wallet_internal_error, "internal error: failed to deserialize \"" + keys_file_name + '\"');
 
   crypto::chacha8_key key;
-  crypto::cn_context cn_context;
-  crypto::generate_chacha8_key(cn_context, password, key);
+  crypto::generate_chacha8_key(password, key);
   std::string account_data;
   account_data.resize(keys_file_data.account_data.size());
   crypto::chacha8(keys_file_data.account_data.data(), keys_file_data.account_data.size(), key, keys_file_data.iv, &account_data[0]);
@@ -737,7 +715,7 @@ void wallet2::load(const std::string& wallet_, const std::string& password)
   if (m_blockchain.empty()) {
     m_blockchain.push_back(m_currency.genesisBlockHash());
   } else {
-    THROW_WALLET_EXCEPTION_IF(m_blockchain[0] != m_currency.genesisBlockHash(), error::wallet_internal_error,
+    THROW_WALLET_EXCEPTION_IF(!m_blockchain.hasBlock(0, m_currency.genesisBlockHash()), error::wallet_internal_error,
       "Genesis block missmatch. You probably use wallet without testnet flag with blockchain from test network or vice versa");
   }
 }
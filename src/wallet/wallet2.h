@@ -36,6 +36,7 @@
 #include "common/BlockingQueue.h"
 
 #include "wallet_errors.h"
+#include "WalletBlockchainHistory.h"
 
 #define DEFAULT_TX_SPENDABLE_AGE                               10
 #define WALLET_RCP_CONNECTION_TIMEOUT                          200000
@@ -191,7 +192,14 @@ namespace tools
     {
       if(ver < 5)
         return;
-      a & m_blockchain;
+      if (ver < 9) {
+        //one id per height
+        std::vector<crypto::hash> blockchain;
+        a & blockchain;
+        m_blockchain.assign(blockchain);
+      } else {
+        a & m_blockchain;
+      }
       a & m_transfers;
       a & m_account_public_address;
       a & m_key_images;
@@ -269,7 +277,7 @@ namespace tools
     std::string m_wallet_file;
     std::string m_keys_file;
     epee::net_utils::http::http_simple_client m_http_client;
-    std::vector<crypto::hash> m_blockchain;
+    CryptoNote::WalletBlockchainHistory m_blockchain;
     std::unordered_map<crypto::hash, unconfirmed_transfer_details> m_unconfirmed_txs;
 
     transfer_container m_transfers;
@@ -284,7 +292,7 @@ namespace tools
     Transfers transfers;
   };
 }
-BOOST_CLASS_VERSION(tools::wallet2, 8)
+BOOST_CLASS_VERSION(tools::wallet2, 9)
 
 namespace boost
 {
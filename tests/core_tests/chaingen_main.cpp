@@ -178,6 +178,7 @@ int main(int argc, char* argv[])
     GENERATE_AND_PLAY_EX(MultiSigTx_Input(2, 2, 1, false));
     GENERATE_AND_PLAY_EX(MultiSigTx_Input(3, 2, 1, false));
     GENERATE_AND_PLAY_EX(MultiSigTx_BadInputSignature());
+    GENERATE_AND_PLAY_EX(MultiSigTx_BadInputSignatureKeptByBlock());
 
     // Double spend
     GENERATE_AND_PLAY(gen_double_spend_in_tx<false>);
@@ -852,6 +852,22 @@ bool MultiSigTx_BadInputSignature::generate(std::vector<test_event_entry>& event
 
   TestGenerator generator(m_currency, events);
 
+  Transaction tx;
+  generateTx(generator, tx);
+
+  // transaction with bad signature should be rejected
+  generator.addCallback("mark_invalid_tx");
+  generator.addEvent(tx);
+
+  // blocks with transaction with bad signature should be rejected
+  generator.addCallback("mark_invalid_block");
+  generator.makeNextBlock(tx);
+  
+  return true;
+}
+
+void MultiSigTx_BadInputSignature::generateTx(TestGenerator& generator, Transaction& tx) const {
+
   // create outputs
   MultiSigTx_OutputSignatures::generate(generator);
 
@@ -874,13 +890,43 @@ bool MultiSigTx_BadInputSignature::generate(std::vector<test_event_entry>& event
   crypto::generate_signature(badHash, pk, sk, sig);
   outsigs.push_back(sig);
 
-  // transaction with bad signature should be rejected
-  generator.addCallback("mark_invalid_tx");
-  generator.addEvent(builder.m_tx);
+  tx = builder.m_tx;
+}
+
+
+MultiSigTx_BadInputSignatureKeptByBlock::MultiSigTx_BadInputSignatureKeptByBlock() {
+  REGISTER_CALLBACK_METHOD(MultiSigTx_BadInputSignatureKeptByBlock, checkBlockTemplateIsEmpty);
+}
+
+bool MultiSigTx_BadInputSignatureKeptByBlock::generate(std::vector<test_event_entry>& events) const {
+
+  TestGenerator generator(m_currency, events);
+
+  Transaction tx;
+  generateTx(generator, tx);
+
+  // a transaction kept by block gets into the pool even though its inputs are invalid
+  SET_EVENT_VISITOR_SETT(events, event_visitor_settings::set_txs_keeped_by_block, true);
+  generator.addEvent(tx);
+  SET_EVENT_VISITOR_SETT(events, event_visitor_settings::set_txs_keeped_by_block, false);
+
+  generator.addCallback("checkBlockTemplateIsEmpty");
+  return true;
+}
+
+bool MultiSigTx_BadInputSignatureKeptByBlock::checkBlockTemplateIsEmpty(cryptonote::core& c, size_t /*evIndex*/, const std::vector<test_event_entry>& /*events*/) {
+  DEFINE_TESTS_ERROR_CONTEXT("MultiSigTx_BadInputSignatureKeptByBlock::checkBlockTemplateIsEmpty");
+
+  CHECK_EQ(1, c.get_pool_transactions_count());
+
+  // the pool remembers the result of the first check, the second template must not trust it
+  for (size_t i = 0; i < 2; ++i) {
+    Block b;
+    difficulty_type diff;
+    uint64_t height;
+    CHECK_TEST_CONDITION(c.get_block_template(b, m_outputAccounts[0].get_keys().m_account_address, diff, height, blobdata()));
+    CHECK_TEST_CONDITION(b.txHashes.empty());
+  }
 
-  // blocks with transaction with bad signature should be rejected
-  generator.addCallback("mark_invalid_block");
-  generator.makeNextBlock(builder.m_tx);
-  
   return true;
 }
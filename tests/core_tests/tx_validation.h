@@ -174,4 +174,11 @@ struct MultiSigTx_Input : public MultiSigTx_OutputSignatures {
 struct MultiSigTx_BadInputSignature : public MultiSigTx_OutputSignatures {
   MultiSigTx_BadInputSignature();
   bool generate(std::vector<test_event_entry>& events) const;
+  void generateTx(TestGenerator& generator, cryptonote::Transaction& tx) const;
+};
+
+struct MultiSigTx_BadInputSignatureKeptByBlock : public MultiSigTx_BadInputSignature {
+  MultiSigTx_BadInputSignatureKeptByBlock();
+  bool generate(std::vector<test_event_entry>& events) const;
+  bool checkBlockTemplateIsEmpty(cryptonote::core& c, size_t evIndex, const std::vector<test_event_entry>& events);
 };
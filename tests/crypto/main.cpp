@@ -131,6 +131,10 @@ int main(int argc, char *argv[]) {
       if (expected1 != actual1 || (expected1 && expected2 != actual2)) {
         goto error;
       }
+      generate_key_derivations(&key1, 1, key2, &actual2, &actual1);
+      if (expected1 != actual1 || (expected1 && expected2 != actual2)) {
+        goto error;
+      }
     } else if (cmd == "derive_public_key") {
       key_derivation derivation;
       size_t output_index;
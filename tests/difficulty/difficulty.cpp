@@ -19,15 +19,50 @@
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 
+#include "crypto/crypto.h"
 #include "cryptonote_config.h"
 #include "cryptonote_core/difficulty.h"
 #include "cryptonote_core/Currency.h"
 
 using namespace std;
 
+// the batched check against a precomputed target has to agree with check_hash,
+// on random hashes and on the hashes next to the target
+static bool checkTarget(uint64_t difficulty) {
+    cryptonote::difficulty_target target = cryptonote::get_difficulty_target(difficulty);
+    vector<crypto::hash> hashes;
+    for (int i = 0; i < 16; ++i) {
+        hashes.push_back(crypto::rand<crypto::hash>());
+    }
+    crypto::hash h;
+    memcpy(&h, target.words, sizeof(h));
+    hashes.push_back(h);
+    for (int word = 0; word < 4; ++word) {
+        memcpy(&h, target.words, sizeof(h));
+        ++reinterpret_cast<uint64_t *>(&h)[word];
+        hashes.push_back(h);
+        memcpy(&h, target.words, sizeof(h));
+        --reinterpret_cast<uint64_t *>(&h)[word];
+        hashes.push_back(h);
+    }
+    unique_ptr<bool[]> results(new bool[hashes.size()]);
+    cryptonote::check_hashes(hashes.data(), hashes.size(), target, results.get());
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        bool expected = cryptonote::check_hash(hashes[i], difficulty);
+        if (results[i] != expected || cryptonote::check_hash(hashes[i], target) != expected) {
+            cerr << "Wrong target check for difficulty " << difficulty << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     if (argc != 2) {
         cerr << "Wrong arguments" << endl;
@@ -63,10 +98,18 @@ int main(int argc, char *argv[]) {
                 << "Found: " << res << endl;
             return 1;
         }
+        if (!checkTarget(difficulty)) {
+            return 1;
+        }
         timestamps.push_back(timestamp);
         cumulative_difficulties.push_back(cumulative_difficulty += difficulty);
         ++n;
     }
+    for (uint64_t difficulty : {uint64_t(0), uint64_t(1), uint64_t(2), uint64_t(3), uint64_t(1) << 32, numeric_limits<uint64_t>::max()}) {
+        if (!checkTarget(difficulty)) {
+            return 1;
+        }
+    }
     if (!data.eof()) {
         data.clear(fstream::badbit);
     }
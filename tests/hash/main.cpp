@@ -15,11 +15,15 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <ios>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "warnings.h"
 #include "crypto/hash.h"
@@ -46,13 +50,91 @@ POP_WARNINGS
   static void slow_hash(const void *data, size_t length, char *hash) {
     cn_slow_hash(*context, data, length, *reinterpret_cast<chash *>(hash));
   }
+
+PUSH_WARNINGS
+DISABLE_VS_WARNINGS(4297)
+  // hashes the input together with some of its prefixes, so that the 8-, 4- and 1-lane paths
+  // all run and lanes of different lengths are absorbed side by side
+  static void fast_hash_multi(const void *data, size_t length, char *hash) {
+    const size_t count = 13;
+    const void *inputs[count];
+    size_t lengths[count];
+    chash hashes[count];
+    for (size_t i = 0; i < count; i++) {
+      inputs[i] = data;
+      lengths[i] = length - std::min(length, i % 3 == 0 ? 0 : i * 11);
+    }
+    cn_fast_hash_multi(inputs, lengths, hashes, count);
+    for (size_t i = 1; i < count; i++) {
+      if (hashes[i] != cn_fast_hash(inputs[i], lengths[i])) {
+        throw ios_base::failure("cn_fast_hash_multi differs from cn_fast_hash");
+      }
+    }
+    memcpy(hash, &hashes[0], sizeof(chash));
+  }
+POP_WARNINGS
+}
+
+// hashes every window of group_size consecutive vectors in one call, so that groups of 2 and 3 take
+// the x2 kernel and the x2 kernel followed by the scalar tail whatever the number of vectors in the file
+static void slow_hash_groups(const vector<vector<char>> &data, cn_context *const *contexts, size_t group_size, const vector<chash> &hashes) {
+  size_t count = data.size();
+  vector<const void *> inputs(group_size);
+  vector<size_t> lengths(group_size);
+  vector<chash> lanes(group_size);
+  for (size_t start = 0; start < count; start++) {
+    for (size_t i = 0; i < group_size; i++) {
+      inputs[i] = data[(start + i) % count].data();
+      lengths[i] = data[(start + i) % count].size();
+    }
+    cn_slow_hash_multi(contexts, inputs.data(), lengths.data(), lanes.data(), group_size);
+    for (size_t i = 0; i < group_size; i++) {
+      if (lanes[i] != hashes[(start + i) % count]) {
+        throw ios_base::failure("cn_slow_hash_multi differs for a group of " + to_string(group_size) + " inputs");
+      }
+    }
+  }
+}
+
+// hashes every vector of the file in its own lane, once per rotation of the vectors over the lanes,
+// so that each lane absorbs a different input and every input goes through every lane
+static void slow_hash_multi(const vector<vector<char>> &data, vector<chash> &hashes) {
+  size_t count = data.size();
+  vector<unique_ptr<cn_context>> contextStorage;
+  vector<cn_context *> contexts;
+  for (size_t i = 0; i < count; i++) {
+    contextStorage.emplace_back(new cn_context());
+    contexts.push_back(contextStorage.back().get());
+  }
+  hashes.resize(count);
+  vector<const void *> inputs(count);
+  vector<size_t> lengths(count);
+  vector<chash> lanes(count);
+  for (size_t shift = 0; shift < count; shift++) {
+    for (size_t i = 0; i < count; i++) {
+      inputs[i] = data[(i + shift) % count].data();
+      lengths[i] = data[(i + shift) % count].size();
+    }
+    cn_slow_hash_multi(contexts.data(), inputs.data(), lengths.data(), lanes.data(), count);
+    for (size_t i = 0; i < count; i++) {
+      if (shift == 0) {
+        hashes[i] = lanes[i];
+      } else if (lanes[i] != hashes[(i + shift) % count]) {
+        throw ios_base::failure("cn_slow_hash_multi depends on the lane of the input");
+      }
+    }
+  }
+  for (size_t group_size = 2; group_size <= 3 && group_size <= count; group_size++) {
+    slow_hash_groups(data, contexts.data(), group_size, hashes);
+  }
 }
 
 extern "C" typedef void hash_f(const void *, size_t, char *);
 struct hash_func {
   const string name;
   hash_f &f;
-} hashes[] = {{"fast", cn_fast_hash}, {"slow", slow_hash}, {"tree", hash_tree},
+} hashes[] = {{"fast", cn_fast_hash}, {"fast-multi", fast_hash_multi}, {"slow", slow_hash},
+  {"slow-multi", slow_hash}, {"tree", hash_tree},
   {"extra-blake", hash_extra_blake}, {"extra-groestl", hash_extra_groestl},
   {"extra-jh", hash_extra_jh}, {"extra-skein", hash_extra_skein}};
 
@@ -61,7 +143,9 @@ int main(int argc, char *argv[]) {
   hash_func *hf;
   fstream input;
   vector<char> data;
+  vector<vector<char>> inputs;
   chash expected, actual;
+  vector<chash> expectedHashes, actualHashes;
   size_t test = 0;
   bool error = false;
   if (argc != 3) {
@@ -83,7 +167,6 @@ int main(int argc, char *argv[]) {
   }
   input.open(argv[2], ios_base::in);
   for (;;) {
-    ++test;
     input.exceptions(ios_base::badbit);
     get(input, expected);
     if (input.rdstate() & ios_base::eofbit) {
@@ -92,10 +175,24 @@ int main(int argc, char *argv[]) {
     input.exceptions(ios_base::badbit | ios_base::failbit | ios_base::eofbit);
     input.clear(input.rdstate());
     get(input, data);
-    f(data.data(), data.size(), (char *) &actual);
+    expectedHashes.push_back(expected);
+    inputs.push_back(data);
+  }
+  if (hf->name == "slow-multi") {
+    slow_hash_multi(inputs, actualHashes);
+  } else {
+    for (auto &d : inputs) {
+      f(d.data(), d.size(), (char *) &actual);
+      actualHashes.push_back(actual);
+    }
+  }
+  for (; test < inputs.size(); ++test) {
+    data = inputs[test];
+    expected = expectedHashes[test];
+    actual = actualHashes[test];
     if (expected != actual) {
       size_t i;
-      cerr << "Hash mismatch on test " << test << endl << "Input: ";
+      cerr << "Hash mismatch on test " << test + 1 << endl << "Input: ";
       if (data.size() == 0) {
         cerr << "empty";
       } else {
@@ -0,0 +1,61 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "crypto/crypto.h"
+
+// m of n multisignature input signed by the last m keys, so that the other keys are tried first
+template<size_t a_key_count, size_t a_required_signatures>
+class test_check_multisignature
+{
+  static_assert(0 < a_required_signatures && a_required_signatures <= a_key_count, "wrong number of required signatures");
+
+public:
+  static const size_t loop_count = 100;
+
+  bool init()
+  {
+    m_prefix_hash = crypto::rand<crypto::hash>();
+    for (size_t i = 0; i < a_key_count; ++i)
+    {
+      crypto::public_key pub;
+      crypto::secret_key sec;
+      crypto::generate_keys(pub, sec);
+      m_keys.push_back(pub);
+      if (i >= a_key_count - a_required_signatures)
+      {
+        m_signatures.emplace_back();
+        crypto::generate_signature(m_prefix_hash, pub, sec, m_signatures.back());
+      }
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    return crypto::check_multisignature(m_prefix_hash, m_keys.data(), m_keys.size(), m_signatures.data(), m_signatures.size());
+  }
+
+private:
+  crypto::hash m_prefix_hash;
+  std::vector<crypto::public_key> m_keys;
+  std::vector<crypto::signature> m_signatures;
+};
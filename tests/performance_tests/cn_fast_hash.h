@@ -0,0 +1,69 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+template<bool multi>
+class test_cn_fast_hash
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t message_count = 1024;
+  static const size_t message_size = 64;
+  static const size_t items_per_call = message_count;
+
+  bool init()
+  {
+    m_messages.resize(message_count * message_size);
+    crypto::generate_random_bytes(m_messages.size(), m_messages.data());
+    for (size_t i = 0; i < message_count; ++i)
+    {
+      m_inputs.push_back(&m_messages[i * message_size]);
+    }
+    m_sizes.assign(message_count, static_cast<size_t>(message_size));
+    m_hashes.resize(message_count);
+    return true;
+  }
+
+  bool test()
+  {
+    if (multi)
+    {
+      crypto::cn_fast_hash_multi(m_inputs.data(), m_sizes.data(), m_hashes.data(), message_count);
+    }
+    else
+    {
+      for (size_t i = 0; i < message_count; ++i)
+      {
+        crypto::cn_fast_hash(m_inputs[i], m_sizes[i], m_hashes[i]);
+      }
+    }
+
+    return true;
+  }
+
+private:
+  std::vector<uint8_t> m_messages;
+  std::vector<const void*> m_inputs;
+  std::vector<size_t> m_sizes;
+  std::vector<crypto::hash> m_hashes;
+};
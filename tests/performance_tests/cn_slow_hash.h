@@ -17,13 +17,22 @@
 
 #pragma once
 
+#include <memory>
+
 #include "crypto/crypto.h"
 #include "cryptonote_core/cryptonote_basic.h"
 
+template<bool large_pages>
 class test_cn_slow_hash
 {
 public:
+  test_cn_slow_hash()
+    : m_context(large_pages ? crypto::cn_context::large_pages : crypto::cn_context::normal_pages, false)
+  {
+  }
+
   static const size_t loop_count = 10;
+  static const size_t items_per_call = 1;
 
 #pragma pack(push, 1)
   struct data_t
@@ -57,3 +66,51 @@ private:
   crypto::hash m_expected_hash;
   crypto::cn_context m_context;
 };
+
+template<size_t lanes, bool large_pages>
+class test_cn_slow_hash_multi
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t items_per_call = lanes;
+
+  bool init()
+  {
+    if (!epee::string_tools::hex_to_pod("63617665617420656d70746f72", m_data))
+      return false;
+
+    if (!epee::string_tools::hex_to_pod("bbec2cacf69866a8e740380fe7b818fc78f8571221742d729d9d02d7f8989b87", m_expected_hash))
+      return false;
+
+    for (size_t i = 0; i < lanes; ++i)
+    {
+      m_contextStorage[i].reset(new crypto::cn_context(large_pages ? crypto::cn_context::large_pages : crypto::cn_context::normal_pages, false));
+      m_contexts[i] = m_contextStorage[i].get();
+      m_inputs[i] = &m_data;
+      m_sizes[i] = sizeof(m_data);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::hash hashes[lanes];
+    crypto::cn_slow_hash_multi(m_contexts, m_inputs, m_sizes, hashes, lanes);
+    for (size_t i = 0; i < lanes; ++i)
+    {
+      if (hashes[i] != m_expected_hash)
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  typename test_cn_slow_hash<large_pages>::data_t m_data;
+  crypto::hash m_expected_hash;
+  std::unique_ptr<crypto::cn_context> m_contextStorage[lanes];
+  crypto::cn_context* m_contexts[lanes];
+  const void* m_inputs[lanes];
+  size_t m_sizes[lanes];
+};
@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "common/compression.h"
+#include "crypto/crypto.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+#include "storages/portable_storage_template_helper.h"
+
+// Models NOTIFY_RESPONSE_GET_OBJECTS: key material is random, framing and amounts are not
+class test_compression_base
+{
+public:
+  bool init()
+  {
+    if (!tools::compression::is_available())
+      return false;
+
+    cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request request;
+    request.current_blockchain_height = 1;
+    for (size_t i = 0; i < 200; ++i)
+    {
+      cryptonote::block_complete_entry entry;
+      entry.block = make_blob(4);
+      for (size_t j = 0; j < 20; ++j)
+      {
+        entry.txs.push_back(make_blob(40));
+      }
+      request.blocks.push_back(entry);
+    }
+
+    if (!epee::serialization::store_t_to_binary(request, m_blob))
+      return false;
+
+    return tools::compression::compress(m_blob, m_compressed);
+  }
+
+protected:
+  static std::string make_blob(size_t keys_count)
+  {
+    std::string blob;
+    for (size_t i = 0; i < keys_count; ++i)
+    {
+      crypto::public_key key;
+      crypto::secret_key sec;
+      crypto::generate_keys(key, sec);
+      blob.append(reinterpret_cast<const char*>(&key), sizeof(key));
+      blob.append("\x02\x00\x01\xe8\x07\x00\x00", 7);
+    }
+    return blob;
+  }
+
+  std::string m_blob;
+  std::string m_compressed;
+};
+
+class test_compress_objects : public test_compression_base
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool test()
+  {
+    std::string compressed;
+    return tools::compression::compress(m_blob, compressed);
+  }
+};
+
+class test_decompress_objects : public test_compression_base
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool test()
+  {
+    std::string blob;
+    return tools::compression::decompress(m_compressed, m_blob.size(), blob) && blob.size() == m_blob.size();
+  }
+};
@@ -22,6 +22,7 @@
 #include "cryptonote_core/cryptonote_format_utils.h"
 
 #include "multi_tx_test_base.h"
+#include "performance_utils.h"
 
 template<size_t a_in_count, size_t a_out_count>
 class test_construct_tx : private multi_tx_test_base<a_in_count>
@@ -63,3 +64,44 @@ private:
   std::vector<cryptonote::tx_destination_entry> m_destinations;
   cryptonote::Transaction m_tx;
 };
+
+//a_in_count inputs spending the same output with rings of a_ring_size, signed by up to a_sign_threads threads
+template<size_t a_in_count, size_t a_ring_size, size_t a_sign_threads>
+class test_construct_tx_parallel : private multi_tx_test_base<a_ring_size>
+{
+  static_assert(0 < a_in_count, "in_count must be greater than 0");
+  static_assert(0 < a_sign_threads, "sign_threads must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+  static const size_t in_count = a_in_count;
+  static const size_t sign_threads = a_sign_threads;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace cryptonote;
+
+    if (!base_class::init())
+      return false;
+
+    this->m_sources.resize(in_count, this->m_sources.front());
+
+    m_alice.generate();
+    m_destinations.push_back(tx_destination_entry(this->m_source_amount, m_alice.get_keys().m_account_address));
+
+    return true;
+  }
+
+  bool test()
+  {
+    return cryptonote::construct_tx(this->m_miners[this->real_source_idx].get_keys(), this->m_sources, m_destinations, std::vector<uint8_t>(), m_tx, 0, sign_threads);
+  }
+
+private:
+  all_cores_affinity_guard m_affinity;
+  cryptonote::account_base m_alice;
+  std::vector<cryptonote::tx_destination_entry> m_destinations;
+  cryptonote::Transaction m_tx;
+};
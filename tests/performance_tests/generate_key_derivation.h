@@ -26,6 +26,7 @@ class test_generate_key_derivation : public single_tx_test_base
 {
 public:
   static const size_t loop_count = 1000;
+  static const size_t items_per_call = 1;
 
   bool test()
   {
@@ -34,3 +35,36 @@ public:
     return true;
   }
 };
+
+//derivations of the keys of key_count transactions with the same view key, sharing one field inversion
+template<size_t key_count>
+class test_generate_key_derivations : public single_tx_test_base
+{
+public:
+  static const size_t loop_count = 1000 / key_count;
+  static const size_t items_per_call = key_count;
+
+  bool init()
+  {
+    if (!single_tx_test_base::init())
+      return false;
+
+    for (size_t i = 0; i < key_count; ++i)
+    {
+      crypto::secret_key sec;
+      crypto::generate_keys(m_tx_pub_keys[i], sec);
+    }
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::key_derivation recv_derivations[key_count];
+    bool valid[key_count];
+    crypto::generate_key_derivations(m_tx_pub_keys, key_count, m_bob.get_keys().m_view_secret_key, recv_derivations, valid);
+    return valid[0];
+  }
+
+private:
+  crypto::public_key m_tx_pub_keys[key_count];
+};
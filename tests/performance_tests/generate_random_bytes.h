@@ -0,0 +1,79 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+// threads draw random scalars side by side; locked serializes them on one mutex the way every caller did
+// before the generator became per thread
+template<size_t thread_count, bool locked>
+class test_generate_random_bytes
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t draws_per_thread = 10000;
+  static const size_t items_per_call = thread_count * draws_per_thread;
+
+  bool init()
+  {
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<std::future<uint64_t>> threads;
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+      threads.push_back(std::async(std::launch::async, [this] { return draw(); }));
+    }
+
+    uint64_t sum = 0;
+    for (auto& thread : threads)
+    {
+      sum ^= thread.get();
+    }
+
+    return sum != 0;
+  }
+
+private:
+  uint64_t draw()
+  {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < draws_per_thread; ++i)
+    {
+      if (locked)
+      {
+        std::lock_guard<std::mutex> lock(m_lock);
+        sum ^= crypto::rand<uint64_t>();
+      }
+      else
+      {
+        sum ^= crypto::rand<uint64_t>();
+      }
+    }
+
+    return sum;
+  }
+
+  std::mutex m_lock;
+};
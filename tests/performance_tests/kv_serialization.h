@@ -0,0 +1,95 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+#include "storages/portable_storage_template_helper.h"
+
+class test_kv_serialization_base
+{
+public:
+  bool init()
+  {
+    m_request.current_blockchain_height = 1;
+    for (size_t i = 0; i < 200; ++i)
+    {
+      cryptonote::block_complete_entry entry;
+      entry.block.assign(2000, 'b');
+      entry.txs.assign(20, std::string(1500, 't'));
+      m_request.blocks.push_back(entry);
+    }
+
+    return epee::serialization::store_t_to_binary(m_request, m_blob);
+  }
+
+protected:
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request m_request;
+  std::string m_blob;
+};
+
+class test_portable_storage_to_bin : public test_kv_serialization_base
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool test()
+  {
+    epee::serialization::portable_storage ps;
+    m_request.store(ps);
+    std::string blob;
+    return ps.store_to_binary(blob);
+  }
+};
+
+class test_portable_storage_bin_writer : public test_kv_serialization_base
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool test()
+  {
+    std::string blob;
+    return epee::serialization::store_t_to_binary(m_request, blob);
+  }
+};
+
+class test_portable_storage_from_bin : public test_kv_serialization_base
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool test()
+  {
+    epee::serialization::portable_storage ps;
+    if (!ps.load_from_binary(m_blob))
+      return false;
+    cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request request;
+    return request.load(ps);
+  }
+};
+
+class test_portable_storage_bin_reader : public test_kv_serialization_base
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool test()
+  {
+    cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request request;
+    return epee::serialization::load_t_from_binary(request, m_blob);
+  }
+};
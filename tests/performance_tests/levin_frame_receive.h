@@ -0,0 +1,108 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+
+#include "net/levin_protocol_handler_async.h"
+#include "net/net_utils_base.h"
+
+// Cost of receiving a notification of frame_size bytes in socket reads of 8 KB. Frames up to
+// LEVIN_MAX_POOLED_FRAME_BUFFER_SIZE are copied once into a reused buffer, bigger ones grow it as they come
+template<size_t frame_size>
+class test_levin_frame_receive
+{
+public:
+  static const size_t loop_count = frame_size < 1024 * 1024 ? 1000 : 50;
+  static const size_t items_per_call = frame_size;
+  static const size_t read_size = 8192;
+
+  test_levin_frame_receive()
+    : m_protocol_handler(&m_endpoint, m_config, m_context)
+  {
+  }
+
+  bool init()
+  {
+    m_config.m_pcommands_handler = &m_commands_handler;
+    m_config.m_max_packet_size = frame_size + sizeof(epee::levin::bucket_head2);
+
+    epee::levin::bucket_head2 head = epee::levin::bucket_head2();
+    head.m_signature = LEVIN_SIGNATURE;
+    head.m_cb = frame_size;
+    head.m_have_to_return_data = false;
+    head.m_command = 1;
+    head.m_flags = LEVIN_PACKET_REQUEST;
+    head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
+
+    m_frame.assign(reinterpret_cast<const char*>(&head), sizeof(head));
+    m_frame.append(frame_size, 'b');
+    return true;
+  }
+
+  bool test()
+  {
+    for (size_t offset = 0; offset < m_frame.size(); offset += read_size)
+    {
+      if (!m_protocol_handler.handle_recv(m_frame.data() + offset, std::min(read_size, m_frame.size() - offset)))
+        return false;
+    }
+
+    return m_commands_handler.m_last_size == frame_size;
+  }
+
+private:
+  struct commands_handler : public epee::levin::levin_commands_handler<epee::net_utils::connection_context_base>
+  {
+    commands_handler() : m_last_size(0) {}
+
+    virtual int invoke(int command, const std::string& in_buff, std::string& buff_out, epee::net_utils::connection_context_base& context)
+    {
+      return LEVIN_ERROR_FORMAT;
+    }
+
+    virtual int notify(int command, const std::string& in_buff, epee::net_utils::connection_context_base& context)
+    {
+      m_last_size = in_buff.size();
+      return LEVIN_OK;
+    }
+
+    size_t m_last_size;
+  };
+
+  struct endpoint : public epee::net_utils::i_service_endpoint
+  {
+    virtual bool do_send(const void* ptr, size_t cb)           { return true; }
+    virtual bool close()                                       { return true; }
+    virtual bool call_run_once_service_io()                    { return true; }
+    virtual bool request_callback()                            { return true; }
+    virtual boost::asio::io_service& get_io_service()          { return m_io_service; }
+    virtual bool add_ref()                                     { return true; }
+    virtual bool release()                                     { return true; }
+
+    boost::asio::io_service m_io_service;
+  };
+
+  commands_handler m_commands_handler;
+  endpoint m_endpoint;
+  epee::net_utils::connection_context_base m_context;
+  epee::levin::async_protocol_handler_config<epee::net_utils::connection_context_base> m_config;
+  epee::levin::async_protocol_handler<epee::net_utils::connection_context_base> m_protocol_handler;
+  std::string m_frame;
+};
@@ -21,14 +21,26 @@
 
 // tests
 #include "construct_tx.h"
+#include "check_multisignature.h"
 #include "check_ring_signature.h"
+#include "compression.h"
+#include "cn_fast_hash.h"
 #include "cn_slow_hash.h"
 #include "derive_public_key.h"
 #include "derive_secret_key.h"
 #include "generate_key_derivation.h"
 #include "generate_key_image.h"
 #include "generate_key_image_helper.h"
+#include "generate_random_bytes.h"
 #include "is_out_to_acc.h"
+#include "kv_serialization.h"
+#include "levin_frame_receive.h"
+#include "multi_account_scan.h"
+#include "peerlist.h"
+#include "save_transfer_details.h"
+#include "select_transfers.h"
+#include "tree_hash.h"
+#include "wallet_sync.h"
 
 int main(int argc, char** argv)
 {
@@ -59,19 +71,77 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE2(test_construct_tx, 100, 10);
   TEST_PERFORMANCE2(test_construct_tx, 100, 100);
 
+  TEST_PERFORMANCE3(test_construct_tx_parallel, 100, 11, 1);
+  TEST_PERFORMANCE3(test_construct_tx_parallel, 100, 11, 4);
+  TEST_PERFORMANCE3(test_construct_tx_parallel, 100, 11, 8);
+  TEST_PERFORMANCE3(test_construct_tx_parallel, 100, 11, 16);
+
   TEST_PERFORMANCE1(test_check_ring_signature, 1);
   TEST_PERFORMANCE1(test_check_ring_signature, 2);
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
 
+  TEST_PERFORMANCE2(test_check_multisignature, 1, 1);
+  TEST_PERFORMANCE2(test_check_multisignature, 3, 2);
+  TEST_PERFORMANCE2(test_check_multisignature, 10, 5);
+
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
+  TEST_PERFORMANCE1(test_generate_key_derivations, 1);
+  TEST_PERFORMANCE1(test_generate_key_derivations, 16);
+  TEST_PERFORMANCE1(test_generate_key_derivations, 100);
   TEST_PERFORMANCE0(test_generate_key_image);
   TEST_PERFORMANCE0(test_derive_public_key);
   TEST_PERFORMANCE0(test_derive_secret_key);
 
-  TEST_PERFORMANCE0(test_cn_slow_hash);
+  TEST_PERFORMANCE2(test_generate_random_bytes, 1, false);
+  TEST_PERFORMANCE2(test_generate_random_bytes, 4, true);
+  TEST_PERFORMANCE2(test_generate_random_bytes, 4, false);
+
+  TEST_PERFORMANCE1(test_multi_account_scan, 1);
+  TEST_PERFORMANCE1(test_multi_account_scan, 100);
+  TEST_PERFORMANCE1(test_multi_account_scan, 10000);
+
+  TEST_PERFORMANCE1(test_save_transfer_details, true);
+  TEST_PERFORMANCE1(test_save_transfer_details, false);
+  TEST_PERFORMANCE1(test_transfer_details_size, true);
+  TEST_PERFORMANCE1(test_transfer_details_size, false);
+
+  TEST_PERFORMANCE2(test_wallet_sync, 200, 10);
+  TEST_PERFORMANCE2(test_wallet_sync, 200, 50);
+  TEST_PERFORMANCE2(test_wallet_sync, 200, 200);
+
+  TEST_PERFORMANCE1(test_select_transfers, 1000);
+  TEST_PERFORMANCE1(test_select_transfers, 100000);
+
+  TEST_PERFORMANCE1(test_cn_fast_hash, false);
+  TEST_PERFORMANCE1(test_cn_fast_hash, true);
+
+  TEST_PERFORMANCE2(test_tree_hash, 1000, false);
+  TEST_PERFORMANCE2(test_tree_hash, 1000, true);
+
+  TEST_PERFORMANCE1(test_cn_slow_hash, false);
+  TEST_PERFORMANCE1(test_cn_slow_hash, true);
+  TEST_PERFORMANCE2(test_cn_slow_hash_multi, 2, false);
+  TEST_PERFORMANCE2(test_cn_slow_hash_multi, 2, true);
+  TEST_PERFORMANCE2(test_cn_slow_hash_multi, 4, false);
+  TEST_PERFORMANCE2(test_cn_slow_hash_multi, 4, true);
+
+  TEST_PERFORMANCE1(test_levin_frame_receive, 65536);
+  TEST_PERFORMANCE1(test_levin_frame_receive, 1048576);
+  TEST_PERFORMANCE1(test_levin_frame_receive, 16777216);
+
+  TEST_PERFORMANCE0(test_portable_storage_to_bin);
+  TEST_PERFORMANCE0(test_portable_storage_bin_writer);
+  TEST_PERFORMANCE0(test_portable_storage_from_bin);
+  TEST_PERFORMANCE0(test_portable_storage_bin_reader);
+
+  TEST_PERFORMANCE0(test_compress_objects);
+  TEST_PERFORMANCE0(test_decompress_objects);
+
+  TEST_PERFORMANCE0(test_peerlist_merge);
+  TEST_PERFORMANCE0(test_peerlist_random_pick);
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
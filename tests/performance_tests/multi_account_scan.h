@@ -0,0 +1,88 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "cryptonote_core/account.h"
+#include "cryptonote_core/cryptonote_basic.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/MultiAccountScanner.h"
+
+template<size_t a_account_count>
+class test_multi_account_scan
+{
+public:
+  static const size_t account_count = a_account_count;
+  static const size_t tx_count = 10;
+  static const size_t outs_per_tx = 2;
+  static const size_t loop_count = account_count < 100 ? 1000 : (account_count < 10000 ? 20 : 1);
+  // every output is checked against every account
+  static const size_t items_per_call = tx_count * outs_per_tx * account_count;
+
+  bool init()
+  {
+    using namespace cryptonote;
+
+    std::vector<account_keys> keys;
+    for (size_t i = 0; i < account_count; ++i)
+    {
+      account_base acc;
+      acc.generate();
+      keys.push_back(acc.get_keys());
+    }
+
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      KeyPair txkey = KeyPair::generate();
+      Transaction tx;
+      tx.version = CURRENT_TRANSACTION_VERSION;
+      tx.unlockTime = 0;
+      add_tx_pub_key_to_extra(tx, txkey.pub);
+      for (size_t j = 0; j < outs_per_tx; ++j)
+      {
+        const AccountPublicAddress& addr = keys[(i * outs_per_tx + j) % account_count].m_account_address;
+        crypto::key_derivation derivation;
+        TransactionOutputToKey out;
+        if (!crypto::generate_key_derivation(addr.m_viewPublicKey, txkey.sec, derivation) ||
+            !crypto::derive_public_key(derivation, j, addr.m_spendPublicKey, out.key))
+          return false;
+
+        TransactionOutput o;
+        o.amount = 1;
+        o.target = out;
+        tx.vout.push_back(o);
+      }
+      m_txs.push_back(tx);
+    }
+
+    m_scanner.reset(new MultiAccountScanner(keys));
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<std::vector<cryptonote::ScannedOutput>> outputs;
+    m_scanner->scanTransactions(m_txs, 0, outputs);
+    return outputs.size() == account_count && !outputs[0].empty();
+  }
+
+private:
+  std::unique_ptr<cryptonote::MultiAccountScanner> m_scanner;
+  std::vector<cryptonote::Transaction> m_txs;
+};
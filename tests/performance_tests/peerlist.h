@@ -0,0 +1,97 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "p2p/net_peerlist.h"
+
+class test_peerlist_base
+{
+public:
+  static const size_t gray_peers_count = 5000;
+
+  bool init()
+  {
+    m_peerlist.init(false);
+
+    std::list<nodetool::peerlist_entry> peers;
+    for (uint32_t i = 0; i < gray_peers_count; ++i)
+    {
+      peers.push_back(make_entry(i, i));
+    }
+    if (!m_peerlist.merge_peerlist(peers))
+      return false;
+
+    //handshake peerlist: half of it is already known
+    for (uint32_t i = 0; i < cryptonote::P2P_DEFAULT_PEERS_IN_HANDSHAKE; ++i)
+    {
+      uint32_t n = i % 2 ? i : gray_peers_count + i;
+      m_handshake_peers.push_back(make_entry(n, gray_peers_count + i));
+    }
+
+    return gray_peers_count == m_peerlist.get_gray_peers_count();
+  }
+
+protected:
+  static nodetool::peerlist_entry make_entry(uint32_t n, time_t last_seen)
+  {
+    nodetool::peerlist_entry ple = AUTO_VAL_INIT(ple);
+    uint32_t b = (n >> 16) & 0xff;
+    uint32_t c = (n >> 8) & 0xff;
+    uint32_t d = n & 0xff;
+    ple.adr.ip = MAKE_IP(100, b, c, d);
+    ple.adr.port = 8080;
+    ple.id = n;
+    ple.last_seen = last_seen;
+    return ple;
+  }
+
+  nodetool::peerlist_manager m_peerlist;
+  std::list<nodetool::peerlist_entry> m_handshake_peers;
+};
+
+class test_peerlist_merge : public test_peerlist_base
+{
+public:
+  static const size_t loop_count = 1000;
+
+  bool test()
+  {
+    return m_peerlist.merge_peerlist(m_handshake_peers);
+  }
+};
+
+class test_peerlist_random_pick : public test_peerlist_base
+{
+public:
+  static const size_t loop_count = 100000;
+
+  test_peerlist_random_pick() : m_index(0)
+  {
+  }
+
+  bool test()
+  {
+    //cheap index walk keeps the RNG out of the measurement
+    m_index = (m_index + 2999) % gray_peers_count;
+    nodetool::peerlist_entry ple;
+    return m_peerlist.get_gray_peer_by_random_index(ple, m_index);
+  }
+
+private:
+  size_t m_index;
+};
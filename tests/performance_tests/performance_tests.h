@@ -60,7 +60,7 @@ public:
 
   bool run()
   {
-    T test;
+    T& test = m_test;
     if (!test.init())
       return false;
 
@@ -82,6 +82,8 @@ public:
 
   int elapsed_time() const { return m_elapsed; }
 
+  const T& test() const { return m_test; }
+
   int time_per_call() const
   {
     static_assert(0 < T::loop_count, "T::loop_count must be greater than 0");
@@ -106,8 +108,39 @@ private:
 private:
   volatile uint64_t m_warm_up;  ///<! This field is intended for preclude compiler optimizations
   int m_elapsed;
+  T m_test;
 };
 
+/**
+ * Tests that process a known number of items per call (T::items_per_call) also get their throughput printed
+ */
+template <typename T>
+auto print_items_per_sec(const test_runner<T>& runner, int) -> decltype(T::items_per_call, void())
+{
+  if (0 < runner.elapsed_time())
+    std::cout << "  items per sec: " << static_cast<uint64_t>(T::items_per_call) * T::loop_count * 1000 / runner.elapsed_time() << '\n';
+}
+
+template <typename T>
+void print_items_per_sec(const test_runner<T>&, long)
+{
+}
+
+/**
+ * Tests that measure a data layout (T::memory_size() and T::serialized_size()) also get its footprint printed
+ */
+template <typename T>
+auto print_footprint(const test_runner<T>& runner, int) -> decltype(runner.test().memory_size(), runner.test().serialized_size(), void())
+{
+  std::cout << "  memory:        " << runner.test().memory_size() << " bytes\n";
+  std::cout << "  serialized:    " << runner.test().serialized_size() << " bytes\n";
+}
+
+template <typename T>
+void print_footprint(const test_runner<T>&, long)
+{
+}
+
 template <typename T>
 void run_test(const char* test_name)
 {
@@ -117,6 +150,8 @@ void run_test(const char* test_name)
     std::cout << test_name << " - OK:\n";
     std::cout << "  loop count:    " << T::loop_count << '\n';
     std::cout << "  elapsed:       " << runner.elapsed_time() << " ms\n";
+    print_items_per_sec(runner, 0);
+    print_footprint(runner, 0);
     std::cout << "  time per call: " << runner.time_per_call() << " ms/call\n" << std::endl;
   }
   else
@@ -129,3 +164,4 @@ void run_test(const char* test_name)
 #define TEST_PERFORMANCE0(test_class)         run_test< test_class >(QUOTEME(test_class))
 #define TEST_PERFORMANCE1(test_class, a0)     run_test< test_class<a0> >(QUOTEME(test_class<a0>))
 #define TEST_PERFORMANCE2(test_class, a0, a1) run_test< test_class<a0, a1> >(QUOTEME(test_class) "<" QUOTEME(a0) ", " QUOTEME(a1) ">")
+#define TEST_PERFORMANCE3(test_class, a0, a1, a2) run_test< test_class<a0, a1, a2> >(QUOTEME(test_class) "<" QUOTEME(a0) ", " QUOTEME(a1) ", " QUOTEME(a2) ">")
@@ -70,3 +70,39 @@ void set_thread_high_priority()
   ::pthread_attr_destroy(&attr);
 #endif
 }
+
+//lets the threads started by a multithreaded test run on every core, the pinned affinity is restored on destruction
+class all_cores_affinity_guard
+{
+public:
+  all_cores_affinity_guard()
+  {
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__)
+    m_restore = 0 == ::pthread_getaffinity_np(::pthread_self(), sizeof(m_cpuset), &m_cpuset);
+
+    cpu_set_t all_cores;
+    CPU_ZERO(&all_cores);
+    for (int i = 0; i < CPU_SETSIZE; ++i)
+    {
+      CPU_SET(i, &all_cores);
+    }
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(all_cores), &all_cores);
+#endif
+  }
+
+  ~all_cores_affinity_guard()
+  {
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__)
+    if (m_restore)
+    {
+      ::pthread_setaffinity_np(::pthread_self(), sizeof(m_cpuset), &m_cpuset);
+    }
+#endif
+  }
+
+private:
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__)
+  cpu_set_t m_cpuset;
+  bool m_restore;
+#endif
+};
@@ -0,0 +1,181 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/archive/binary_oarchive.hpp>
+
+#include "wallet/WalletSerialization.h"
+
+#include "single_tx_test_base.h"
+
+//transfer details as they were kept before version 1: with the whole transaction
+struct legacy_transfer_details
+{
+  uint64_t blockHeight;
+  cryptonote::Transaction tx;
+  size_t internalOutputIndex;
+  uint64_t globalOutputIndex;
+  bool spent;
+  crypto::key_image keyImage;
+
+  template<class Archive>
+  void serialize(Archive& ar, const unsigned int version)
+  {
+    ar & blockHeight;
+    ar & tx;
+    ar & internalOutputIndex;
+    ar & globalOutputIndex;
+    ar & spent;
+    ar & keyImage;
+  }
+};
+
+//heap memory held by a transaction, on top of sizeof(cryptonote::Transaction)
+inline size_t transaction_heap_size(const cryptonote::Transaction& tx)
+{
+  size_t size = tx.vin.capacity() * sizeof(cryptonote::TransactionInput) +
+    tx.vout.capacity() * sizeof(cryptonote::TransactionOutput) +
+    tx.extra.capacity() +
+    tx.signatures.capacity() * sizeof(std::vector<crypto::signature>);
+
+  for (const auto& in : tx.vin)
+  {
+    if (const cryptonote::TransactionInputToKey* key = boost::get<cryptonote::TransactionInputToKey>(&in))
+      size += key->keyOffsets.capacity() * sizeof(uint64_t);
+  }
+
+  for (const auto& out : tx.vout)
+  {
+    if (const cryptonote::TransactionOutputMultisignature* multisig = boost::get<cryptonote::TransactionOutputMultisignature>(&out.target))
+      size += multisig->keys.capacity() * sizeof(crypto::public_key);
+  }
+
+  for (const auto& signatures : tx.signatures)
+    size += signatures.capacity() * sizeof(crypto::signature);
+
+  return size;
+}
+
+//the owned outputs of a wallet in both layouts, all of them received in a miner transaction,
+//the smallest transaction there is, so the legacy figures are a lower bound
+template<size_t a_transfers_count>
+class transfer_details_test_base : public single_tx_test_base
+{
+public:
+  static const size_t transfers_count = a_transfers_count;
+
+  bool init()
+  {
+    if (!single_tx_test_base::init())
+      return false;
+
+    m_legacy_transfers.reserve(transfers_count);
+    m_transfers.reserve(transfers_count);
+    for (size_t i = 0; i < transfers_count; ++i)
+    {
+      legacy_transfer_details legacy;
+      legacy.blockHeight = i;
+      legacy.tx = m_tx;
+      legacy.internalOutputIndex = 0;
+      legacy.globalOutputIndex = i;
+      legacy.spent = false;
+      legacy.keyImage = AUTO_VAL_INIT(legacy.keyImage);
+      m_legacy_transfers.push_back(legacy);
+
+      CryptoNote::TransferDetails td;
+      td.blockHeight = i;
+      td.amount = m_tx.vout[0].amount;
+      td.outputKey = boost::get<cryptonote::TransactionOutputToKey>(m_tx.vout[0].target).key;
+      td.transactionPublicKey = m_tx_pub_key;
+      td.unlockTime = m_tx.unlockTime;
+      td.internalOutputIndex = 0;
+      td.globalOutputIndex = i;
+      td.spent = false;
+      td.keyImage = legacy.keyImage;
+      m_transfers.push_back(td);
+    }
+
+    return true;
+  }
+
+protected:
+  template<class T>
+  static std::string save(const std::vector<T>& transfers)
+  {
+    std::stringstream stream;
+    boost::archive::binary_oarchive ar(stream);
+    ar << transfers;
+    return stream.str();
+  }
+
+  std::vector<legacy_transfer_details> m_legacy_transfers;
+  std::vector<CryptoNote::TransferDetails> m_transfers;
+};
+
+template<bool a_legacy>
+class test_save_transfer_details : public transfer_details_test_base<1000>
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t items_per_call = transfers_count;
+
+  bool test()
+  {
+    return !(a_legacy ? save(m_legacy_transfers) : save(m_transfers)).empty();
+  }
+};
+
+//memory taken by the owned outputs of a big wallet and the size of their saved cache
+template<bool a_legacy>
+class test_transfer_details_size : public transfer_details_test_base<100000>
+{
+public:
+  static const size_t loop_count = 1;
+  static const size_t items_per_call = transfers_count;
+
+  test_transfer_details_size()
+    : m_serialized_size(0)
+  {
+  }
+
+  bool test()
+  {
+    m_serialized_size = (a_legacy ? save(m_legacy_transfers) : save(m_transfers)).size();
+    return m_serialized_size != 0;
+  }
+
+  size_t memory_size() const
+  {
+    if (!a_legacy)
+      return m_transfers.capacity() * sizeof(CryptoNote::TransferDetails);
+
+    size_t size = m_legacy_transfers.capacity() * sizeof(legacy_transfer_details);
+    for (const auto& td : m_legacy_transfers)
+      size += transaction_heap_size(td.tx);
+
+    return size;
+  }
+
+  size_t serialized_size() const { return m_serialized_size; }
+
+private:
+  size_t m_serialized_size;
+};
@@ -0,0 +1,69 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <list>
+#include <vector>
+
+// epee
+#include "misc_language.h"
+
+#include "cryptonote_core/Currency.h"
+#include "wallet/WalletTransferDetails.h"
+
+template<size_t a_transfers_count>
+class test_select_transfers
+{
+public:
+  static const size_t loop_count = 1000;
+  static const size_t transfers_count = a_transfers_count;
+
+  test_select_transfers()
+    : m_currency(cryptonote::CurrencyBuilder().currency())
+    , m_transfers(m_currency, m_blockchain)
+  {
+  }
+
+  bool init()
+  {
+    m_blockchain.resize(transfers_count + 100);
+
+    for (uint64_t i = 0; i < transfers_count; ++i)
+    {
+      CryptoNote::TransferDetails td = AUTO_VAL_INIT(td);
+      td.blockHeight = i;
+      td.amount = (i % 9 + 1) * 1000000;
+      td.globalOutputIndex = i;
+      td.spent = false;
+      memcpy(&td.keyImage, &i, sizeof(i));
+      m_transfers.addTransferDetails(td);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::list<size_t> selected;
+    return m_transfers.selectTransfersToSend(50000000, false, 0, selected) >= 50000000;
+  }
+
+private:
+  cryptonote::Currency m_currency;
+  std::vector<crypto::hash> m_blockchain;
+  CryptoNote::WalletTransferDetails m_transfers;
+};
@@ -0,0 +1,63 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "cryptonote_core/TreeHash.h"
+
+// A new miner transaction in a block template of tx_count transactions
+template<size_t tx_count, bool incremental>
+class test_tree_hash
+{
+public:
+  static const size_t loop_count = 1000;
+
+  bool init()
+  {
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      m_hashes.push_back(crypto::rand<crypto::hash>());
+    }
+    m_tree.assign(m_hashes);
+    m_tree.root();
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::hash root;
+    m_hashes[0] = crypto::rand<crypto::hash>();
+    if (incremental)
+    {
+      m_tree.replace(0, m_hashes[0]);
+      root = m_tree.root();
+    }
+    else
+    {
+      crypto::tree_hash(m_hashes.data(), m_hashes.size(), root);
+    }
+    return true;
+  }
+
+private:
+  std::vector<crypto::hash> m_hashes;
+  cryptonote::TreeHash m_tree;
+};
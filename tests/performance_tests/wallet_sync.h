@@ -0,0 +1,149 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "cryptonote_core/Currency.h"
+#include "wallet/Wallet.h"
+
+#include "performance_utils.h"
+
+#include "../unit_tests/INodeStubs.h"
+#include "../unit_tests/TestBlockchainGenerator.h"
+
+// Synchronizes a wallet with blocks_count generated blocks that each pay it a reward, fetched from the node
+// in portions of portion_size blocks. Every call loads the wallet as it was before the blocks and syncs it again
+template<size_t blocks_count, size_t portion_size>
+class test_wallet_sync
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t items_per_call = blocks_count;
+
+  test_wallet_sync()
+    : m_currency(cryptonote::CurrencyBuilder().currency())
+    , m_generator(m_currency)
+    , m_node(m_generator)
+  {
+  }
+
+  bool init()
+  {
+    m_generator.generateEmptyBlocks(3);
+    m_node.setGetNewBlocksLimit(portion_size);
+
+    sync_observer observer;
+    CryptoNote::Wallet wallet(m_currency, m_node);
+    wallet.addObserver(&observer);
+    wallet.initAndGenerate("pass");
+    if (!observer.wait_for_sync())
+      return false;
+
+    std::stringstream archive;
+    wallet.save(archive, true, true);
+    if (!observer.wait_for_save())
+      return false;
+
+    m_archive = archive.str();
+
+    cryptonote::AccountPublicAddress address;
+    if (!m_currency.parseAccountAddressString(wallet.getAddress(), address))
+      return false;
+
+    wallet.removeObserver(&observer);
+    wallet.shutdown();
+
+    for (size_t i = 0; i < blocks_count; ++i)
+    {
+      if (!m_generator.getBlockRewardForAddress(address))
+        return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    sync_observer observer;
+    CryptoNote::Wallet wallet(m_currency, m_node);
+    wallet.addObserver(&observer);
+
+    std::stringstream archive(m_archive);
+    wallet.initAndLoad(archive, "pass");
+    bool synchronized = observer.wait_for_sync() && wallet.getTransactionCount() == blocks_count;
+
+    wallet.removeObserver(&observer);
+    wallet.shutdown();
+    return synchronized;
+  }
+
+private:
+  struct sync_observer : public CryptoNote::IWalletObserver
+  {
+    sync_observer() : m_sync_done(false), m_save_done(false) {}
+
+    virtual void synchronizationProgressUpdated(uint64_t current, uint64_t total, std::error_code result)
+    {
+      if (result || current == total)
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sync_done = true;
+        m_sync_result = result;
+        m_condition.notify_all();
+      }
+    }
+
+    virtual void saveCompleted(std::error_code result)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_save_done = true;
+      m_save_result = result;
+      m_condition.notify_all();
+    }
+
+    bool wait_for_sync()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      return m_condition.wait_for(lock, std::chrono::seconds(60), [this] { return m_sync_done; }) && !m_sync_result;
+    }
+
+    bool wait_for_save()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      return m_condition.wait_for(lock, std::chrono::seconds(60), [this] { return m_save_done; }) && !m_save_result;
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_sync_done;
+    std::error_code m_sync_result;
+    bool m_save_done;
+    std::error_code m_save_result;
+  };
+
+  all_cores_affinity_guard m_affinity;
+  cryptonote::Currency m_currency;
+  TestBlockchainGenerator m_generator;
+  INodeTrivialRefreshStub m_node;
+  std::string m_archive;
+};
@@ -19,6 +19,7 @@
 #include "cryptonote_core/cryptonote_format_utils.h"
 #include "wallet/WalletErrors.h"
 
+#include <algorithm>
 #include <functional>
 #include <thread>
 #include <iterator>
@@ -38,7 +39,8 @@ void INodeTrivialRefreshStub::doGetNewBlocks(std::list<crypto::hash> knownBlockI
 
   startHeight = m_lastHeight;
 
-  for (; m_lastHeight < blockchain.size(); ++m_lastHeight)
+  size_t count = 0;
+  for (; m_lastHeight < blockchain.size() && count < m_getNewBlocksLimit; ++m_lastHeight, ++count)
   {
     cryptonote::block_complete_entry e;
     e.block = cryptonote::t_serializable_object_to_blob(blockchain[m_lastHeight]);
@@ -55,7 +57,7 @@ void INodeTrivialRefreshStub::doGetNewBlocks(std::list<crypto::hash> knownBlockI
     newBlocks.push_back(e);
   }
 
-  m_lastHeight = blockchain.size() - 1;
+  m_lastHeight = std::min<uint64_t>(m_lastHeight, blockchain.size()) - 1;
 
   callback(std::error_code());
 }
@@ -72,6 +74,20 @@ void INodeTrivialRefreshStub::doGetTransactionOutsGlobalIndices(const crypto::ha
   callback(std::error_code());
 }
 
+void INodeTrivialRefreshStub::getTransactionsOutsGlobalIndices(std::vector<crypto::hash>&& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback)
+{
+  std::thread task(&INodeTrivialRefreshStub::doGetTransactionsOutsGlobalIndices, this, std::move(transactionHashes), std::ref(outsGlobalIndices), callback);
+  task.detach();
+}
+
+void INodeTrivialRefreshStub::doGetTransactionsOutsGlobalIndices(std::vector<crypto::hash> transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback)
+{
+  outsGlobalIndices.resize(transactionHashes.size());
+  for (auto& indices : outsGlobalIndices)
+    indices.resize(20); //random
+  callback(std::error_code());
+}
+
 void INodeTrivialRefreshStub::relayTransaction(const cryptonote::Transaction& transaction, const Callback& callback)
 {
   std::thread task(&INodeTrivialRefreshStub::doRelayTransaction, this, transaction, callback);
@@ -80,6 +96,8 @@ void INodeTrivialRefreshStub::relayTransaction(const cryptonote::Transaction& tr
 
 void INodeTrivialRefreshStub::doRelayTransaction(const cryptonote::Transaction& transaction, const Callback& callback)
 {
+  std::unique_lock<std::mutex> lock(m_relayMutex);
+
   if (m_nextTxError)
   {
     callback(make_error_code(cryptonote::error::INTERNAL_WALLET_ERROR));
@@ -115,6 +133,8 @@ void INodeTrivialRefreshStub::doGetRandomOutsByAmounts(std::vector<uint64_t> amo
 
       out.outs.push_back(e);
     }
+
+    result.push_back(out);
   }
 
   callback(std::error_code());
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <limits>
+#include <mutex>
 #include <vector>
 
 #include "INode.h"
@@ -41,12 +43,13 @@ public:
   virtual void relayTransaction(const cryptonote::Transaction& transaction, const Callback& callback) {callback(std::error_code());};
   virtual void getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint64_t outsCount, std::vector<cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback) {callback(std::error_code());};
   virtual void getTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback) { callback(std::error_code()); };
+  virtual void getTransactionsOutsGlobalIndices(std::vector<crypto::hash>&& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback) { callback(std::error_code()); };
 };
 
 class INodeTrivialRefreshStub : public INodeDummyStub
 {
 public:
-  INodeTrivialRefreshStub(TestBlockchainGenerator& generator) : m_lastHeight(1), m_blockchainGenerator(generator), m_nextTxError(false) {};
+  INodeTrivialRefreshStub(TestBlockchainGenerator& generator) : m_lastHeight(1), m_blockchainGenerator(generator), m_nextTxError(false), m_getNewBlocksLimit(std::numeric_limits<size_t>::max()) {};
 
   virtual uint64_t getLastLocalBlockHeight() const { return m_blockchainGenerator.getBlockchain().size() - 1; };
   virtual uint64_t getLastKnownBlockHeight() const { return m_blockchainGenerator.getBlockchain().size() - 1; };
@@ -56,17 +59,23 @@ public:
   virtual void relayTransaction(const cryptonote::Transaction& transaction, const Callback& callback);
   virtual void getRandomOutsByAmounts(std::vector<uint64_t>&& amounts, uint64_t outsCount, std::vector<cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback);
   virtual void getTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback);
+  virtual void getTransactionsOutsGlobalIndices(std::vector<crypto::hash>&& transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback);
 
   virtual void startAlternativeChain(uint64_t height);
   virtual void setNextTransactionError();
+  //returns new blocks in portions of at most limit blocks like the daemon does
+  virtual void setGetNewBlocksLimit(size_t limit) { m_getNewBlocksLimit = limit; };
 
 private:
   void doGetNewBlocks(std::list<crypto::hash> knownBlockIds, std::list<cryptonote::block_complete_entry>& newBlocks, uint64_t& startHeight, const Callback& callback);
   void doGetTransactionOutsGlobalIndices(const crypto::hash& transactionHash, std::vector<uint64_t>& outsGlobalIndices, const Callback& callback);
+  void doGetTransactionsOutsGlobalIndices(std::vector<crypto::hash> transactionHashes, std::vector<std::vector<uint64_t>>& outsGlobalIndices, const Callback& callback);
   void doRelayTransaction(const cryptonote::Transaction& transaction, const Callback& callback);
   void doGetRandomOutsByAmounts(std::vector<uint64_t> amounts, uint64_t outsCount, std::vector<cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>& result, const Callback& callback);
 
   uint64_t m_lastHeight;
   TestBlockchainGenerator& m_blockchainGenerator;
   bool m_nextTxError;
+  std::mutex m_relayMutex;
+  size_t m_getNewBlocksLimit;
 };
@@ -15,6 +15,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <cstring>
 #include <string>
 
 #include "gtest/gtest.h"
@@ -95,3 +96,31 @@ TEST_CHACHA8(0)
 TEST_CHACHA8(1)
 TEST_CHACHA8(2)
 TEST_CHACHA8(3)
+
+TEST(chacha8, pooled_key_generation_matches_own_context)
+{
+  crypto::chacha8_key expected;
+  crypto::cn_context context;
+  crypto::generate_chacha8_key(context, "password", expected);
+
+  for (int i = 0; i < 2; ++i)
+  {
+    crypto::chacha8_key key;
+    crypto::generate_chacha8_key("password", key);
+    ASSERT_EQ(0, memcmp(&expected, &key, sizeof(key)));
+  }
+}
+
+TEST(chacha8, released_context_is_reused)
+{
+  crypto::cn_context* released;
+  {
+    crypto::pooled_cn_context context = crypto::acquire_cn_context();
+    released = context.get();
+  }
+
+  crypto::pooled_cn_context first = crypto::acquire_cn_context();
+  crypto::pooled_cn_context second = crypto::acquire_cn_context();
+  ASSERT_EQ(released, first.get());
+  ASSERT_NE(first.get(), second.get());
+}
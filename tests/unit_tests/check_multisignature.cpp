@@ -0,0 +1,134 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace
+{
+  struct Multisignature
+  {
+    crypto::hash prefixHash;
+    std::vector<crypto::public_key> keys;
+    std::vector<crypto::secret_key> secretKeys;
+    std::vector<crypto::signature> signatures;
+
+    Multisignature(size_t keyCount) : prefixHash(crypto::rand<crypto::hash>()), keys(keyCount), secretKeys(keyCount)
+    {
+      for (size_t i = 0; i < keyCount; ++i) {
+        crypto::generate_keys(keys[i], secretKeys[i]);
+      }
+    }
+
+    void sign(size_t keyIndex)
+    {
+      signatures.emplace_back();
+      crypto::generate_signature(prefixHash, keys[keyIndex], secretKeys[keyIndex], signatures.back());
+    }
+
+    bool check() const
+    {
+      return crypto::check_multisignature(prefixHash, keys.data(), keys.size(), signatures.data(), signatures.size());
+    }
+
+    // the signature by signature matching the blockchain did before
+    bool checkSequentially() const
+    {
+      size_t signatureIndex = 0;
+      for (size_t keyIndex = 0; signatureIndex < signatures.size(); ++keyIndex) {
+        if (keyIndex == keys.size()) {
+          return false;
+        }
+        if (crypto::check_signature(prefixHash, keys[keyIndex], signatures[signatureIndex])) {
+          ++signatureIndex;
+        }
+      }
+      return true;
+    }
+  };
+}
+
+TEST(check_multisignature, acceptsSignaturesInKeyOrder)
+{
+  Multisignature ms(5);
+  ms.sign(0);
+  ms.sign(2);
+  ms.sign(4);
+  ASSERT_TRUE(ms.check());
+
+  Multisignature all(3);
+  all.sign(0);
+  all.sign(1);
+  all.sign(2);
+  ASSERT_TRUE(all.check());
+
+  Multisignature none(2);
+  ASSERT_TRUE(none.check());
+}
+
+TEST(check_multisignature, rejectsReorderedReusedAndForeignSignatures)
+{
+  Multisignature reordered(3);
+  reordered.sign(2);
+  reordered.sign(0);
+  ASSERT_FALSE(reordered.check());
+
+  Multisignature reused(3);
+  reused.sign(1);
+  reused.sign(1);
+  ASSERT_FALSE(reused.check());
+
+  Multisignature foreign(3);
+  Multisignature other(1);
+  other.sign(0);
+  foreign.sign(0);
+  foreign.signatures.push_back(other.signatures[0]);
+  ASSERT_FALSE(foreign.check());
+
+  Multisignature malformed(2);
+  malformed.sign(0);
+  // r is the second scalar of the signature, all ones is above the group order
+  memset(reinterpret_cast<char*>(&malformed.signatures[0]) + sizeof(crypto::signature) / 2, 0xff, sizeof(crypto::signature) / 2);
+  ASSERT_FALSE(malformed.check());
+}
+
+TEST(check_multisignature, matchesSequentialCheck)
+{
+  for (size_t keyCount = 1; keyCount <= 6; ++keyCount) {
+    for (uint32_t signers = 0; signers < (1u << keyCount); ++signers) {
+      Multisignature ms(keyCount);
+      for (size_t i = 0; i < keyCount; ++i) {
+        if (signers & (1u << i)) {
+          ms.sign(i);
+        }
+      }
+      // swapping two signatures or dropping a key breaks most of the sets
+      std::vector<Multisignature> variants(3, ms);
+      if (variants[1].signatures.size() >= 2) {
+        std::swap(variants[1].signatures.front(), variants[1].signatures.back());
+      }
+      variants[2].keys.pop_back();
+      for (const Multisignature& variant : variants) {
+        ASSERT_EQ(variant.checkSequentially(), variant.check());
+      }
+    }
+  }
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common/compression.h"
+
+using namespace tools;
+
+namespace
+{
+  std::string make_payload(size_t size)
+  {
+    std::string data;
+    data.reserve(size);
+    for (size_t i = 0; data.size() < size; ++i)
+    {
+      data += "block_ids";
+      data.push_back(static_cast<char>(i % 7));
+    }
+    data.resize(size);
+    return data;
+  }
+}
+
+TEST(compression, round_trip)
+{
+  if (!compression::is_available())
+    return;
+
+  std::string data = make_payload(100000);
+  std::string compressed;
+  ASSERT_TRUE(compression::compress(data, compressed));
+  ASSERT_LT(compressed.size(), data.size());
+
+  std::string unpacked;
+  ASSERT_TRUE(compression::decompress(compressed, data.size(), unpacked));
+  ASSERT_EQ(data, unpacked);
+}
+
+TEST(compression, round_trip_empty)
+{
+  if (!compression::is_available())
+    return;
+
+  std::string compressed;
+  ASSERT_TRUE(compression::compress(std::string(), compressed));
+
+  std::string unpacked = "garbage";
+  ASSERT_TRUE(compression::decompress(compressed, 0, unpacked));
+  ASSERT_TRUE(unpacked.empty());
+}
+
+TEST(compression, decompress_fails_if_size_limit_exceeded)
+{
+  if (!compression::is_available())
+    return;
+
+  std::string data = make_payload(100000);
+  std::string compressed;
+  ASSERT_TRUE(compression::compress(data, compressed));
+
+  std::string unpacked;
+  ASSERT_FALSE(compression::decompress(compressed, data.size() - 1, unpacked));
+  ASSERT_TRUE(unpacked.empty());
+}
+
+TEST(compression, decompress_fails_on_corrupted_data)
+{
+  if (!compression::is_available())
+    return;
+
+  std::string data = make_payload(100000);
+  std::string compressed;
+  ASSERT_TRUE(compression::compress(data, compressed));
+
+  std::string unpacked;
+  ASSERT_FALSE(compression::decompress(compressed.substr(0, compressed.size() / 2), data.size(), unpacked));
+  compressed[compressed.size() / 2] ^= 0x5a;
+  compressed[compressed.size() / 2 + 1] ^= 0x5a;
+  ASSERT_FALSE(compression::decompress(compressed, data.size(), unpacked));
+}
@@ -206,13 +206,13 @@ namespace
   {
   };
 
-  class test_levin_protocol_handler__hanle_recv_with_invalid_data : public async_protocol_handler_test
+  class test_levin_protocol_handler__hanle_recv : public async_protocol_handler_test
   {
   public:
     static const int expected_command = 5615871;
     static const int expected_return_code = 782546;
 
-    test_levin_protocol_handler__hanle_recv_with_invalid_data()
+    test_levin_protocol_handler__hanle_recv()
       : m_expected_invoke_out_buf(512, 'y')
     {
     }
@@ -250,6 +250,14 @@ namespace
     std::string m_buf;
     std::string m_expected_invoke_out_buf;
   };
+
+  class test_levin_protocol_handler__hanle_recv_with_invalid_data : public test_levin_protocol_handler__hanle_recv
+  {
+  };
+
+  class test_levin_protocol_handler__hanle_recv_with_valid_data : public test_levin_protocol_handler__hanle_recv
+  {
+  };
 }
 
 TEST_F(positive_test_connection_to_levin_protocol_handler_calls, new_handler_is_not_initialized)
@@ -517,3 +525,37 @@ TEST_F(test_levin_protocol_handler__hanle_recv_with_invalid_data, handles_unexpe
 
   ASSERT_FALSE(m_conn->m_protocol_handler.handle_recv(m_buf.data(), m_buf.size()));
 }
+
+TEST_F(test_levin_protocol_handler__hanle_recv_with_valid_data, handles_requests_split_at_arbitrary_positions)
+{
+  prepare_buf();
+  std::string first_request = m_buf;
+  m_in_data.assign(300, 'u');
+  m_req_head.m_cb = m_in_data.size();
+  prepare_buf();
+  std::string data = first_request + m_buf;
+
+  const size_t chunk_size = 7;
+  for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+  {
+    size_t size = std::min(chunk_size, data.size() - offset);
+    ASSERT_TRUE(m_conn->m_protocol_handler.handle_recv(data.data() + offset, size));
+  }
+
+  ASSERT_EQ(2, m_commands_handler.invoke_counter());
+  ASSERT_EQ(m_in_data, m_commands_handler.last_in_buf());
+}
+
+TEST_F(test_levin_protocol_handler__hanle_recv_with_valid_data, does_not_reserve_announced_size_of_big_packet)
+{
+  m_in_data.assign(max_packet_size, 'b');
+  m_req_head.m_cb = m_in_data.size();
+  prepare_buf();
+
+  ASSERT_TRUE(m_conn->m_protocol_handler.handle_recv(m_buf.data(), sizeof(m_req_head)));
+  ASSERT_GE(static_cast<size_t>(LEVIN_MAX_POOLED_FRAME_BUFFER_SIZE), m_conn->m_protocol_handler.m_frame_buffer.capacity());
+
+  ASSERT_TRUE(m_conn->m_protocol_handler.handle_recv(m_buf.data() + sizeof(m_req_head), m_buf.size() - sizeof(m_req_head)));
+  ASSERT_EQ(1, m_commands_handler.invoke_counter());
+  ASSERT_EQ(m_in_data, m_commands_handler.last_in_buf());
+}
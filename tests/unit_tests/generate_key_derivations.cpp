@@ -0,0 +1,83 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace
+{
+  crypto::public_key invalidPublicKey(const crypto::secret_key& viewKey)
+  {
+    // about half of random encodings aren't points
+    for (;;) {
+      crypto::public_key key = crypto::rand<crypto::public_key>();
+      crypto::key_derivation derivation;
+      if (!crypto::generate_key_derivation(key, viewKey, derivation)) {
+        return key;
+      }
+    }
+  }
+}
+
+TEST(generate_key_derivations, match_single_derivations)
+{
+  crypto::public_key viewPublicKey;
+  crypto::secret_key viewKey;
+  crypto::generate_keys(viewPublicKey, viewKey);
+
+  std::vector<crypto::public_key> keys(20);
+  for (auto& key : keys) {
+    crypto::secret_key sec;
+    crypto::generate_keys(key, sec);
+  }
+  keys[0] = invalidPublicKey(viewKey);
+  keys[7] = invalidPublicKey(viewKey);
+  keys[19] = invalidPublicKey(viewKey);
+
+  std::vector<crypto::key_derivation> derivations(keys.size());
+  std::unique_ptr<bool[]> valid(new bool[keys.size()]);
+  crypto::generate_key_derivations(keys.data(), keys.size(), viewKey, derivations.data(), valid.get());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    crypto::key_derivation expected;
+    bool expectedValid = crypto::generate_key_derivation(keys[i], viewKey, expected);
+    ASSERT_EQ(expectedValid, valid[i]);
+    if (expectedValid) {
+      ASSERT_EQ(0, memcmp(&expected, &derivations[i], sizeof(expected)));
+    }
+  }
+}
+
+TEST(generate_key_derivations, handle_no_valid_key)
+{
+  crypto::public_key viewPublicKey;
+  crypto::secret_key viewKey;
+  crypto::generate_keys(viewPublicKey, viewKey);
+
+  crypto::public_key keys[2] = {invalidPublicKey(viewKey), invalidPublicKey(viewKey)};
+  crypto::key_derivation derivations[2];
+  bool valid[2] = {true, true};
+  crypto::generate_key_derivations(keys, 2, viewKey, derivations, valid);
+  ASSERT_FALSE(valid[0]);
+  ASSERT_FALSE(valid[1]);
+
+  crypto::generate_key_derivations(keys, 0, viewKey, derivations, valid);
+}
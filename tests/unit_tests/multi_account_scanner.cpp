@@ -0,0 +1,187 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "gtest/gtest.h"
+
+#include <vector>
+
+// epee
+#include "misc_language.h"
+
+#include "cryptonote_core/account.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/MultiAccountScanner.h"
+
+using namespace cryptonote;
+
+namespace
+{
+  void addOutputToKey(Transaction& tx, const KeyPair& txKey, const AccountPublicAddress& addr, size_t keyIndex, uint64_t amount)
+  {
+    crypto::key_derivation derivation;
+    TransactionOutputToKey out;
+    ASSERT_TRUE(crypto::generate_key_derivation(addr.m_viewPublicKey, txKey.sec, derivation));
+    ASSERT_TRUE(crypto::derive_public_key(derivation, keyIndex, addr.m_spendPublicKey, out.key));
+
+    TransactionOutput o;
+    o.amount = amount;
+    o.target = out;
+    tx.vout.push_back(o);
+  }
+
+  class MultiAccountScannerTest : public ::testing::Test
+  {
+  public:
+    void SetUp()
+    {
+      for (size_t i = 0; i < 150; ++i)
+      {
+        account_base acc;
+        acc.generate();
+        m_accounts.push_back(acc.get_keys());
+      }
+    }
+
+    // Outputs: to key (account 1), multisignature with 2 keys, to key (account 3), to key (account 1)
+    Transaction makeTransaction(uint64_t amountBase)
+    {
+      KeyPair txKey = KeyPair::generate();
+      Transaction tx;
+      tx.version = CURRENT_TRANSACTION_VERSION;
+      tx.unlockTime = 0;
+      add_tx_pub_key_to_extra(tx, txKey.pub);
+
+      addOutputToKey(tx, txKey, m_accounts[1].m_account_address, 0, amountBase + 1);
+
+      TransactionOutputMultisignature msig;
+      msig.keys.push_back(m_accounts[3].m_account_address.m_spendPublicKey);
+      msig.keys.push_back(m_accounts[1].m_account_address.m_spendPublicKey);
+      msig.requiredSignatures = 1;
+      TransactionOutput o;
+      o.amount = amountBase + 2;
+      o.target = msig;
+      tx.vout.push_back(o);
+
+      addOutputToKey(tx, txKey, m_accounts[3].m_account_address, 3, amountBase + 3);
+      addOutputToKey(tx, txKey, m_accounts[1].m_account_address, 4, amountBase + 4);
+      addOutputToKey(tx, txKey, m_accounts[140].m_account_address, 5, amountBase + 5);
+      return tx;
+    }
+
+  protected:
+    std::vector<account_keys> m_accounts;
+  };
+}
+
+TEST_F(MultiAccountScannerTest, findsSameOutputsAsLookupAccOuts)
+{
+  std::vector<Transaction> txs;
+  txs.push_back(makeTransaction(100));
+  txs.push_back(makeTransaction(200));
+  Transaction noKey;
+  txs.push_back(noKey);
+
+  MultiAccountScanner scanner(m_accounts, 4);
+  std::vector<std::vector<ScannedOutput>> outputs;
+  scanner.scanTransactions(txs, 10, outputs);
+  ASSERT_EQ(m_accounts.size(), outputs.size());
+
+  for (size_t a = 0; a < m_accounts.size(); ++a)
+  {
+    std::vector<ScannedOutput> expected;
+    for (const Transaction& tx : txs)
+    {
+      std::vector<size_t> outs;
+      uint64_t money = 0;
+      if (!lookup_acc_outs(m_accounts[a], tx, outs, money))
+        continue;
+      for (size_t i : outs)
+      {
+        ScannedOutput out;
+        out.transactionHash = get_transaction_hash(tx);
+        out.outputIndex = i;
+        out.amount = tx.vout[i].amount;
+        expected.push_back(out);
+      }
+    }
+
+    ASSERT_EQ(expected.size(), outputs[a].size()) << "account " << a;
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      ASSERT_EQ(10, outputs[a][i].blockHeight);
+      ASSERT_EQ(expected[i].transactionHash, outputs[a][i].transactionHash);
+      ASSERT_EQ(expected[i].outputIndex, outputs[a][i].outputIndex);
+      ASSERT_EQ(expected[i].amount, outputs[a][i].amount);
+    }
+  }
+
+  ASSERT_EQ(4, outputs[1].size());
+  ASSERT_EQ(0, outputs[1][0].outputIndex);
+  ASSERT_EQ(3, outputs[1][1].outputIndex);
+  ASSERT_EQ(2, outputs[3].size());
+  ASSERT_EQ(2, outputs[3][0].outputIndex);
+  ASSERT_EQ(205, outputs[140][1].amount);
+  ASSERT_TRUE(outputs[0].empty());
+}
+
+TEST_F(MultiAccountScannerTest, scansBlocksInOrder)
+{
+  std::vector<block_complete_entry> blocks;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    Block b = AUTO_VAL_INIT(b);
+    b.majorVersion = BLOCK_MAJOR_VERSION_1;
+    b.minerTx = makeTransaction(1000 * i);
+
+    block_complete_entry bce;
+    bce.block = block_to_blob(b);
+    bce.txs.push_back(tx_to_blob(makeTransaction(1000 * i + 100)));
+    blocks.push_back(bce);
+  }
+
+  MultiAccountScanner scanner(m_accounts, 3);
+  std::vector<std::vector<ScannedOutput>> outputs;
+  ASSERT_TRUE(scanner.scanBlocks(blocks, 50, outputs));
+
+  ASSERT_EQ(12, outputs[1].size());
+  for (size_t i = 0; i < 3; ++i)
+  {
+    ASSERT_EQ(50 + i, outputs[1][4 * i].blockHeight);
+    ASSERT_EQ(1000 * i + 1, outputs[1][4 * i].amount);
+    ASSERT_EQ(1000 * i + 104, outputs[1][4 * i + 3].amount);
+  }
+  ASSERT_EQ(6, outputs[140].size());
+
+  MultiAccountScanner singleThreaded(m_accounts, 1);
+  std::vector<std::vector<ScannedOutput>> singleOutputs;
+  ASSERT_TRUE(singleThreaded.scanBlocks(blocks, 50, singleOutputs));
+  for (size_t a = 0; a < m_accounts.size(); ++a)
+  {
+    ASSERT_EQ(outputs[a].size(), singleOutputs[a].size());
+    for (size_t i = 0; i < outputs[a].size(); ++i)
+      ASSERT_EQ(outputs[a][i].transactionHash, singleOutputs[a][i].transactionHash);
+  }
+}
+
+TEST_F(MultiAccountScannerTest, failsOnBadBlob)
+{
+  std::vector<block_complete_entry> blocks(1);
+  blocks[0].block = "garbage";
+
+  MultiAccountScanner scanner(m_accounts);
+  std::vector<std::vector<ScannedOutput>> outputs;
+  ASSERT_FALSE(scanner.scanBlocks(blocks, 0, outputs));
+}
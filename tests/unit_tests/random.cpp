@@ -0,0 +1,82 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <future>
+#include <set>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "crypto/crypto.h"
+
+TEST(random, threadsDrawIndependentValues)
+{
+  const size_t threadCount = 4;
+  const size_t drawCount = 1000;
+
+  std::vector<std::future<std::vector<uint64_t>>> threads;
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.push_back(std::async(std::launch::async, [drawCount] {
+      std::vector<uint64_t> values;
+      for (size_t j = 0; j < drawCount; ++j) {
+        values.push_back(crypto::rand<uint64_t>());
+      }
+      return values;
+    }));
+  }
+
+  std::set<uint64_t> values;
+  for (auto& thread : threads) {
+    for (uint64_t value : thread.get()) {
+      values.insert(value);
+    }
+  }
+
+  ASSERT_EQ(threadCount * drawCount, values.size());
+}
+
+#if !defined(_WIN32)
+TEST(random, forkedChildDoesNotRepeatParent)
+{
+  crypto::rand<uint64_t>();
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    uint64_t value = crypto::rand<uint64_t>();
+    _exit(write(fds[1], &value, sizeof(value)) == sizeof(value) ? 0 : 1);
+  }
+
+  uint64_t parentValue = crypto::rand<uint64_t>();
+  uint64_t childValue = 0;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(childValue)), read(fds[0], &childValue, sizeof(childValue)));
+  int status;
+  waitpid(pid, &status, 0);
+  close(fds[0]);
+  close(fds[1]);
+
+  ASSERT_NE(parentValue, childValue);
+}
+#endif
@@ -0,0 +1,189 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <sstream>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include "wallet/WalletBlockchainHistory.h"
+
+namespace {
+
+crypto::hash blockId(uint64_t height) {
+  crypto::hash id = cryptonote::null_hash;
+  memcpy(&id, &height, sizeof(height));
+  return id;
+}
+
+uint64_t blockHeight(const crypto::hash& id) {
+  uint64_t height;
+  memcpy(&height, &id, sizeof(height));
+  return height;
+}
+
+void fillHistory(CryptoNote::WalletBlockchainHistory& history, size_t size) {
+  while (history.size() < size) {
+    history.push_back(blockId(history.size()));
+  }
+}
+
+}
+
+TEST(WalletBlockchainHistory, shortHistoryOfRecentBlocksIsDense) {
+  CryptoNote::WalletBlockchainHistory history;
+  fillHistory(history, 300);
+
+  std::list<crypto::hash> ids;
+  history.getShortChainHistory(ids);
+
+  std::vector<uint64_t> expected = { 299, 298, 297, 296, 295, 294, 293, 292, 291, 290, 289, 287, 283, 275, 259, 227, 163, 35, 0 };
+  ASSERT_EQ(expected.size(), ids.size());
+
+  auto it = ids.begin();
+  for (uint64_t height: expected) {
+    EXPECT_EQ(height, blockHeight(*it++));
+  }
+}
+
+TEST(WalletBlockchainHistory, keepsCheckpointsBelowRecentWindow) {
+  CryptoNote::WalletBlockchainHistory history(10, 5);
+  fillHistory(history, 50);
+
+  ASSERT_EQ(50, history.size());
+  ASSERT_EQ(40, history.recentStart());
+
+  crypto::hash id;
+  for (size_t height = 0; height < 50; ++height) {
+    bool kept = height >= 40 || height % 5 == 0;
+    ASSERT_EQ(kept, history.getBlockId(height, id));
+    if (kept) {
+      EXPECT_EQ(blockId(height), id);
+    }
+  }
+
+  EXPECT_FALSE(history.hasBlock(33, blockId(33)));
+  EXPECT_TRUE(history.hasBlock(35, blockId(35)));
+  EXPECT_FALSE(history.hasBlock(45, blockId(44)));
+}
+
+TEST(WalletBlockchainHistory, shortHistoryFallsBackToCheckpoints) {
+  CryptoNote::WalletBlockchainHistory history(10, 5);
+  fillHistory(history, 100);
+
+  std::list<crypto::hash> ids;
+  history.getShortChainHistory(ids);
+
+  ASSERT_FALSE(ids.empty());
+  EXPECT_EQ(99, blockHeight(ids.front()));
+  EXPECT_EQ(0, blockHeight(ids.back()));
+
+  uint64_t prevHeight = 100;
+  for (auto& id: ids) {
+    uint64_t height = blockHeight(id);
+    EXPECT_LT(height, prevHeight);
+    EXPECT_TRUE(history.hasBlock(height, id));
+    prevHeight = height;
+  }
+}
+
+TEST(WalletBlockchainHistory, shortHistoryWithAppendedBlocks) {
+  CryptoNote::WalletBlockchainHistory history(10, 5);
+  fillHistory(history, 100);
+
+  std::vector<crypto::hash> appended = { blockId(1000), blockId(1001) };
+  std::list<crypto::hash> ids;
+  history.getShortChainHistory(98, appended, ids);
+
+  ASSERT_GE(ids.size(), 3);
+  auto it = ids.begin();
+  EXPECT_EQ(1001, blockHeight(*it++));
+  EXPECT_EQ(1000, blockHeight(*it++));
+  EXPECT_EQ(97, blockHeight(*it++));
+  EXPECT_EQ(0, blockHeight(ids.back()));
+}
+
+TEST(WalletBlockchainHistory, detachBelowRecentWindow) {
+  CryptoNote::WalletBlockchainHistory history(10, 5);
+  fillHistory(history, 50);
+
+  history.detach(23);
+  EXPECT_EQ(23, history.size());
+  EXPECT_EQ(23, history.recentStart());
+
+  crypto::hash id;
+  EXPECT_TRUE(history.getBlockId(20, id));
+  EXPECT_FALSE(history.getBlockId(22, id));
+  EXPECT_FALSE(history.getBlockId(25, id));
+
+  fillHistory(history, 30);
+  EXPECT_TRUE(history.hasBlock(23, blockId(23)));
+  EXPECT_TRUE(history.hasBlock(25, blockId(25)));
+
+  history.detach(27);
+  EXPECT_EQ(27, history.size());
+  EXPECT_EQ(23, history.recentStart());
+}
+
+TEST(WalletBlockchainHistory, serialization) {
+  CryptoNote::WalletBlockchainHistory history(10, 5);
+  fillHistory(history, 57);
+
+  std::stringstream stream;
+  {
+    boost::archive::binary_oarchive ar(stream);
+    ar << history;
+  }
+
+  CryptoNote::WalletBlockchainHistory loaded(10, 5);
+  {
+    boost::archive::binary_iarchive ar(stream);
+    ar >> loaded;
+  }
+
+  ASSERT_EQ(history.size(), loaded.size());
+  ASSERT_EQ(history.recentStart(), loaded.recentStart());
+
+  for (size_t height = 0; height < history.size(); ++height) {
+    crypto::hash id;
+    bool kept = history.getBlockId(height, id);
+    EXPECT_EQ(kept, loaded.hasBlock(height, id));
+  }
+}
+
+TEST(WalletBlockchainHistory, loadingInconsistentCheckpointsThrows) {
+  CryptoNote::WalletBlockchainHistory history(10, 5);
+  fillHistory(history, 57);
+
+  std::stringstream stream;
+  {
+    boost::archive::binary_oarchive ar(stream);
+    ar << history;
+  }
+
+  //a checkpoint every block is expected, the stored history has one every 5 blocks
+  CryptoNote::WalletBlockchainHistory loaded(10, 1);
+  {
+    boost::archive::binary_iarchive ar(stream);
+    ASSERT_THROW(ar >> loaded, std::runtime_error);
+  }
+
+  EXPECT_TRUE(loaded.empty());
+}
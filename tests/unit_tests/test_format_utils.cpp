@@ -194,3 +194,124 @@ TEST(validate_parse_amount_case, validate_parse_amount)
   r = currency.parseAmount("1 00.00 00", res);
   ASSERT_FALSE(r);
 }
+
+namespace
+{
+  void checkLonghashBlobNoncePatching(uint8_t majorVersion, uint64_t timestamp)
+  {
+    cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+    cryptonote::account_base acc;
+    acc.generate();
+
+    cryptonote::Block b = AUTO_VAL_INIT(b);
+    b.majorVersion = majorVersion;
+    b.timestamp = timestamp;
+    if (majorVersion == cryptonote::BLOCK_MAJOR_VERSION_2)
+    {
+      b.parentBlock.majorVersion = cryptonote::BLOCK_MAJOR_VERSION_1;
+      b.parentBlock.numberOfTransactions = 1;
+      cryptonote::tx_extra_merge_mining_tag mm_tag = AUTO_VAL_INIT(mm_tag);
+      ASSERT_TRUE(cryptonote::append_mm_tag_to_extra(b.parentBlock.minerTx.extra, mm_tag));
+    }
+    ASSERT_TRUE(currency.constructMinerTx(0, 0, 0, 0, 0, acc.get_keys().m_account_address, b.minerTx));
+    b.txHashes.push_back(crypto::rand<crypto::hash>());
+
+    cryptonote::blobdata blob;
+    size_t nonceOffset;
+    ASSERT_TRUE(cryptonote::get_block_longhash_blob(b, blob, nonceOffset));
+
+    size_t offset;
+    ASSERT_TRUE(cryptonote::get_longhash_blob_nonce_offset(blob, offset));
+    ASSERT_EQ(nonceOffset, offset);
+
+    for (uint32_t nonce : {1u, 0x12345678u, 0xffffffffu})
+    {
+      b.nonce = nonce;
+      cryptonote::set_longhash_blob_nonce(blob, nonceOffset, nonce);
+      cryptonote::blobdata expected;
+      ASSERT_TRUE(cryptonote::get_block_longhash_blob(b, expected));
+      ASSERT_EQ(expected, blob);
+    }
+  }
+}
+
+TEST(get_block_longhash_blob, patched_nonce_gives_block_blob)
+{
+  for (uint64_t timestamp : {0ull, 128ull, 1400000000ull, 0xffffffffffffull})
+  {
+    checkLonghashBlobNoncePatching(cryptonote::BLOCK_MAJOR_VERSION_1, timestamp);
+    checkLonghashBlobNoncePatching(cryptonote::BLOCK_MAJOR_VERSION_2, timestamp);
+  }
+}
+
+TEST(get_block_longhash_blob, nonce_offset_rejects_truncated_blob)
+{
+  cryptonote::blobdata blob(3 + sizeof(crypto::hash) + sizeof(uint32_t), 1);
+  size_t offset;
+  ASSERT_TRUE(cryptonote::get_longhash_blob_nonce_offset(blob, offset));
+  ASSERT_EQ(3 + sizeof(crypto::hash), offset);
+
+  blob.pop_back();
+  ASSERT_FALSE(cryptonote::get_longhash_blob_nonce_offset(blob, offset));
+  blob.assign(2, '\x80');
+  ASSERT_FALSE(cryptonote::get_longhash_blob_nonce_offset(blob, offset));
+}
+
+TEST(construct_tx, signs_inputs_on_several_threads)
+{
+  const size_t inputCount = 8;
+  const size_t ringSize = 4;
+  const size_t realOutput = 1;
+
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  cryptonote::account_base sender;
+  sender.generate();
+
+  std::vector<cryptonote::tx_source_entry> sources;
+  uint64_t amount = 0;
+  for (size_t i = 0; i < inputCount; ++i)
+  {
+    cryptonote::tx_source_entry source;
+    for (size_t j = 0; j < ringSize; ++j)
+    {
+      cryptonote::account_base miner;
+      miner.generate();
+      const cryptonote::account_base& owner = j == realOutput ? sender : miner;
+
+      cryptonote::Transaction minerTx;
+      ASSERT_TRUE(currency.constructMinerTx(0, 0, 0, 2, 0, owner.get_keys().m_account_address, minerTx));
+      const cryptonote::TransactionOutputToKey& out = boost::get<cryptonote::TransactionOutputToKey>(minerTx.vout[0].target);
+      source.outputs.push_back(std::make_pair(i * ringSize + j, out.key));
+
+      if (j == realOutput)
+      {
+        source.amount = minerTx.vout[0].amount;
+        source.real_out_tx_key = cryptonote::get_tx_pub_key_from_extra(minerTx);
+      }
+    }
+    source.real_output = realOutput;
+    source.real_output_in_tx_index = 0;
+    amount += source.amount;
+    sources.push_back(source);
+  }
+
+  std::vector<cryptonote::tx_destination_entry> destinations;
+  destinations.push_back(cryptonote::tx_destination_entry(amount, sender.get_keys().m_account_address));
+
+  cryptonote::Transaction tx;
+  ASSERT_TRUE(cryptonote::construct_tx(sender.get_keys(), sources, destinations, std::vector<uint8_t>(), tx, 0, 4));
+  ASSERT_EQ(inputCount, tx.vin.size());
+  ASSERT_EQ(inputCount, tx.signatures.size());
+
+  crypto::hash prefixHash = cryptonote::get_transaction_prefix_hash(tx);
+  for (size_t i = 0; i < inputCount; ++i)
+  {
+    const cryptonote::TransactionInputToKey& in = boost::get<cryptonote::TransactionInputToKey>(tx.vin[i]);
+    std::vector<const crypto::public_key*> ring;
+    for (const auto& output : sources[i].outputs)
+      ring.push_back(&output.second);
+
+    ASSERT_EQ(ringSize, tx.signatures[i].size());
+    ASSERT_TRUE(crypto::check_ring_signature(prefixHash, in.keyImage, ring, tx.signatures[i].data()));
+  }
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "node_rpc_proxy/HttpClientPool.h"
+#include "node_rpc_proxy/NodeRpcProxy.h"
+
+namespace {
+
+//accepts connections and never answers, so every request sent to it stays in flight until its timeout
+class SilentServer {
+public:
+  SilentServer() : m_acceptor(m_ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)), m_accepted(0) {
+    accept();
+    m_thread = std::thread([this] { m_ioService.run(); });
+  }
+
+  ~SilentServer() {
+    m_ioService.stop();
+    m_thread.join();
+  }
+
+  unsigned short port() const { return m_acceptor.local_endpoint().port(); }
+
+  bool waitForConnections(size_t count) {
+    for (size_t i = 0; i < 500 && m_accepted < count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return m_accepted >= count;
+  }
+
+private:
+  void accept() {
+    m_sockets.emplace_back(new boost::asio::ip::tcp::socket(m_ioService));
+    m_acceptor.async_accept(*m_sockets.back(), [this](const boost::system::error_code& ec) {
+      if (!ec) {
+        ++m_accepted;
+        accept();
+      }
+    });
+  }
+
+  boost::asio::io_service m_ioService;
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  std::vector<std::unique_ptr<boost::asio::ip::tcp::socket> > m_sockets;
+  std::atomic<size_t> m_accepted;
+  std::thread m_thread;
+};
+
+}
+
+TEST(HttpClientPool, leaseReusesIdleClient) {
+  cryptonote::HttpClientPool pool;
+
+  cryptonote::HttpClientPool::Client* first;
+  {
+    cryptonote::HttpClientPool::Lease lease(pool);
+    first = &lease.client();
+  }
+  ASSERT_EQ(1, pool.idleCount());
+
+  cryptonote::HttpClientPool::Lease lease(pool);
+  EXPECT_EQ(first, &lease.client());
+  EXPECT_EQ(0, pool.idleCount());
+}
+
+TEST(HttpClientPool, newClientOnlyWhenAllAreLeased) {
+  cryptonote::HttpClientPool pool;
+
+  cryptonote::HttpClientPool::Client* first;
+  cryptonote::HttpClientPool::Client* second;
+  {
+    cryptonote::HttpClientPool::Lease firstLease(pool);
+    cryptonote::HttpClientPool::Lease secondLease(pool);
+    first = &firstLease.client();
+    second = &secondLease.client();
+    ASSERT_NE(first, second);
+  }
+  ASSERT_EQ(2, pool.idleCount());
+
+  {
+    cryptonote::HttpClientPool::Lease firstLease(pool);
+    cryptonote::HttpClientPool::Lease secondLease(pool);
+    EXPECT_TRUE(&firstLease.client() == first || &firstLease.client() == second);
+    EXPECT_TRUE(&secondLease.client() == first || &secondLease.client() == second);
+    EXPECT_EQ(0, pool.idleCount());
+  }
+  EXPECT_EQ(2, pool.idleCount());
+}
+
+TEST(HttpClientPool, clearDropsIdleClients) {
+  cryptonote::HttpClientPool pool;
+  {
+    cryptonote::HttpClientPool::Lease firstLease(pool);
+    cryptonote::HttpClientPool::Lease secondLease(pool);
+  }
+  ASSERT_EQ(2, pool.idleCount());
+
+  pool.clear();
+  EXPECT_EQ(0, pool.idleCount());
+
+  cryptonote::HttpClientPool::Lease lease(pool);
+  EXPECT_EQ(0, pool.idleCount());
+}
+
+TEST(NodeRpcProxy, shutdownJoinsRequestInFlight) {
+  SilentServer server;
+
+  cryptonote::NodeRpcProxy proxy("127.0.0.1", server.port());
+  proxy.rpcTimeout(1000);
+  proxy.requestThreadCount(2);
+
+  std::promise<std::error_code> initPromise;
+  proxy.init([&initPromise](std::error_code ec) { initPromise.set_value(ec); });
+  ASSERT_FALSE(initPromise.get_future().get());
+
+  std::list<cryptonote::block_complete_entry> newBlocks;
+  uint64_t startHeight;
+  std::atomic<bool> requestCompleted(false);
+  std::error_code requestResult;
+  proxy.getNewBlocks(std::list<crypto::hash>(), newBlocks, startHeight, [&](std::error_code ec) {
+    requestResult = ec;
+    requestCompleted = true;
+  });
+
+  //the status poll and the request both hold a connection the server never answers
+  ASSERT_TRUE(server.waitForConnections(2));
+  ASSERT_FALSE(requestCompleted);
+
+  ASSERT_TRUE(proxy.shutdown());
+  EXPECT_TRUE(requestCompleted);
+  EXPECT_TRUE(static_cast<bool>(requestResult));
+}
@@ -69,3 +69,93 @@ TEST(peer_list, merge_peer_lists)
 
 
 }
+
+TEST(peer_list, peer_metrics)
+{
+  nodetool::peerlist_manager plm;
+  plm.init(false);
+
+  nodetool::peerlist_entry fast = AUTO_VAL_INIT(fast);
+  fast.adr.ip = MAKE_IP(123,43,12,1);
+  fast.adr.port = 8080;
+  fast.id = 1;
+  plm.append_with_peer_white(fast);
+
+  nodetool::peerlist_entry slow = fast;
+  slow.adr.ip = MAKE_IP(123,43,12,2);
+  slow.id = 2;
+  plm.append_with_peer_white(slow);
+
+  nodetool::net_address unknown = fast.adr;
+  unknown.ip = MAKE_IP(123,43,12,3);
+
+  nodetool::peer_metrics metrics = AUTO_VAL_INIT(metrics);
+  ASSERT_FALSE(plm.get_peer_metrics(fast.adr, metrics));
+  ASSERT_EQ(plm.get_peer_cost(fast.adr), plm.get_peer_cost(slow.adr));
+
+  plm.add_rtt_sample(fast.adr, 40);
+  plm.add_rtt_sample(fast.adr, 80);
+  plm.add_delivery_sample(fast.adr, 1024 * 1024, 1000);
+  plm.add_connection_attempt(fast.adr, true);
+
+  plm.add_rtt_sample(slow.adr, 400);
+  plm.add_connection_attempt(slow.adr, false);
+  plm.add_connection_attempt(slow.adr, true);
+
+  plm.add_rtt_sample(unknown, 10);
+
+  ASSERT_TRUE(plm.get_peer_metrics(fast.adr, metrics));
+  ASSERT_EQ(50, metrics.rtt);
+  ASSERT_EQ(1024 * 1024, metrics.throughput);
+  ASSERT_EQ(1, metrics.attempts);
+  ASSERT_EQ(0, metrics.failures);
+
+  ASSERT_TRUE(plm.get_peer_metrics(slow.adr, metrics));
+  ASSERT_EQ(2, metrics.attempts);
+  ASSERT_EQ(1, metrics.failures);
+
+  ASSERT_FALSE(plm.get_peer_metrics(unknown, metrics));
+  ASSERT_LT(plm.get_peer_cost(fast.adr), plm.get_peer_cost(slow.adr));
+
+  std::list<std::pair<nodetool::net_address, nodetool::peer_metrics> > all;
+  plm.get_peer_metrics_all(all);
+  ASSERT_EQ(2, all.size());
+}
+
+TEST(peer_list, merge_trims_gray_list)
+{
+  nodetool::peerlist_manager plm;
+  plm.init(false);
+
+  std::list<nodetool::peerlist_entry> outer_bs;
+  for (uint32_t i = 0; i < cryptonote::P2P_LOCAL_GRAY_PEERLIST_LIMIT + 100; ++i)
+  {
+    nodetool::peerlist_entry ple = AUTO_VAL_INIT(ple);
+    uint32_t b = (i >> 16) & 0xff;
+    uint32_t c = (i >> 8) & 0xff;
+    uint32_t d = i & 0xff;
+    ple.adr.ip = MAKE_IP(100, b, c, d);
+    ple.adr.port = 8080;
+    ple.id = i;
+    ple.last_seen = i;
+    outer_bs.push_back(ple);
+  }
+
+  ASSERT_TRUE(plm.merge_peerlist(outer_bs));
+  ASSERT_EQ(cryptonote::P2P_LOCAL_GRAY_PEERLIST_LIMIT, plm.get_gray_peers_count());
+  ASSERT_EQ(0, plm.get_white_peers_count());
+
+  //the oldest entries are dropped
+  std::set<uint64_t> ids;
+  for (size_t i = 0; i < plm.get_gray_peers_count(); ++i)
+  {
+    nodetool::peerlist_entry ple;
+    ASSERT_TRUE(plm.get_gray_peer_by_random_index(ple, i));
+    ASSERT_LE(100, ple.last_seen);
+    ids.insert(ple.id);
+  }
+  ASSERT_EQ(cryptonote::P2P_LOCAL_GRAY_PEERLIST_LIMIT, ids.size());
+
+  nodetool::peerlist_entry ple;
+  ASSERT_FALSE(plm.get_gray_peer_by_random_index(ple, plm.get_gray_peers_count()));
+}
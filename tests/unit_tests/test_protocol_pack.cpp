@@ -42,3 +42,137 @@ TEST(protocol_pack, protocol_pack_command)
     ASSERT_TRUE(r.total_height == 3);
   }
 }
+
+namespace
+{
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request make_get_objects_response()
+  {
+    cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r;
+    r.current_blockchain_height = 12345;
+    r.txs.push_back(std::string(100, 't'));
+    for (size_t i = 0; i < 10; ++i)
+    {
+      cryptonote::block_complete_entry entry;
+      entry.block.assign(200 + i, 'b');
+      entry.txs.assign(i, std::string(50 + i, 'x'));
+      r.blocks.push_back(entry);
+    }
+    r.missed_ids.resize(3, boost::value_initialized<crypto::hash>());
+    return r;
+  }
+
+  bool is_equal(const cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request& a, const cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request& b)
+  {
+    if (a.current_blockchain_height != b.current_blockchain_height || a.txs != b.txs || a.missed_ids != b.missed_ids || a.blocks.size() != b.blocks.size())
+      return false;
+
+    auto it = b.blocks.begin();
+    for (const cryptonote::block_complete_entry& entry : a.blocks)
+    {
+      if (entry.block != it->block || entry.txs != it->txs)
+        return false;
+      ++it;
+    }
+    return true;
+  }
+}
+
+TEST(protocol_pack, bin_writer_output_is_readable_by_portable_storage)
+{
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r = make_get_objects_response();
+  std::string buff;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(r, buff));
+
+  epee::serialization::portable_storage ps;
+  ASSERT_TRUE(ps.load_from_binary(buff));
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r2;
+  ASSERT_TRUE(r2.load(ps));
+  ASSERT_TRUE(is_equal(r, r2));
+}
+
+TEST(protocol_pack, bin_reader_reads_portable_storage_output)
+{
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r = make_get_objects_response();
+  epee::serialization::portable_storage ps;
+  r.store(ps);
+  std::string buff;
+  ASSERT_TRUE(ps.store_to_binary(buff));
+
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r2;
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(r2, buff));
+  ASSERT_TRUE(is_equal(r, r2));
+}
+
+TEST(protocol_pack, bin_reader_rejects_truncated_blob)
+{
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r = make_get_objects_response();
+  std::string buff;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(r, buff));
+  buff.resize(buff.size() - 1);
+
+  cryptonote::NOTIFY_RESPONSE_GET_OBJECTS::request r2;
+  ASSERT_FALSE(epee::serialization::load_t_from_binary(r2, buff));
+}
+
+namespace
+{
+  struct nested_inner
+  {
+    uint64_t value;
+    std::list<std::string> names;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(value)
+      KV_SERIALIZE(names)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct nested_outer
+  {
+    nested_inner single;
+    std::list<nested_inner> items;
+    std::string tail;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(single)
+      KV_SERIALIZE(items)
+      KV_SERIALIZE(tail)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  nested_inner make_nested_inner(uint64_t value)
+  {
+    nested_inner inner;
+    inner.value = value;
+    inner.names.assign(value % 4, std::string(value, 'n'));
+    return inner;
+  }
+}
+
+TEST(protocol_pack, bin_reader_reads_nested_sections)
+{
+  nested_outer r;
+  r.single = make_nested_inner(7);
+  for (uint64_t i = 0; i < 5; ++i)
+    r.items.push_back(make_nested_inner(i));
+  r.tail = "tail";
+
+  epee::serialization::portable_storage ps;
+  r.store(ps);
+  std::string buff;
+  ASSERT_TRUE(ps.store_to_binary(buff));
+
+  nested_outer r2;
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(r2, buff));
+  ASSERT_EQ(r.single.value, r2.single.value);
+  ASSERT_EQ(r.single.names, r2.single.names);
+  ASSERT_EQ(r.items.size(), r2.items.size());
+  auto it = r2.items.begin();
+  for (const nested_inner& item : r.items)
+  {
+    ASSERT_EQ(item.value, it->value);
+    ASSERT_EQ(item.names, it->names);
+    ++it;
+  }
+  ASSERT_EQ(r.tail, r2.tail);
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <ctime>
+#include <set>
+
+// epee
+#include "misc_language.h"
+
+#include "wallet/WalletTransferDetails.h"
+
+class WalletTransferDetailsTest : public ::testing::Test
+{
+public:
+  WalletTransferDetailsTest() : m_currency(cryptonote::CurrencyBuilder().currency()), m_transfers(m_currency, m_blockchain), m_keyImagesCount(0) {
+  }
+
+protected:
+  void setBlockchainSize(size_t size) {
+    m_blockchain.detach(size);
+    while (m_blockchain.size() < size) {
+      m_blockchain.push_back(cryptonote::null_hash);
+    }
+  }
+
+  size_t addTransfer(uint64_t height, uint64_t amount, uint64_t unlockTime = 0) {
+    CryptoNote::TransferDetails td = AUTO_VAL_INIT(td);
+    td.blockHeight = height;
+    td.amount = amount;
+    td.unlockTime = unlockTime;
+    td.spent = false;
+    ++m_keyImagesCount;
+    memcpy(&td.keyImage, &m_keyImagesCount, sizeof(m_keyImagesCount));
+
+    m_transfers.addTransferDetails(td);
+
+    size_t idx;
+    EXPECT_TRUE(m_transfers.getTransferDetailsIdxByKeyImage(td.keyImage, idx));
+    return idx;
+  }
+
+  cryptonote::Currency m_currency;
+  CryptoNote::WalletBlockchainHistory m_blockchain;
+  CryptoNote::WalletTransferDetails m_transfers;
+  uint64_t m_keyImagesCount;
+};
+
+TEST_F(WalletTransferDetailsTest, balancesFollowBlockchainHeight) {
+  setBlockchainSize(5);
+  addTransfer(1, 100);
+  addTransfer(3, 200);
+
+  EXPECT_EQ(0, m_transfers.countActualBalance());
+  EXPECT_EQ(300, m_transfers.countPendingBalance());
+
+  setBlockchainSize(11);
+  EXPECT_EQ(100, m_transfers.countActualBalance());
+
+  setBlockchainSize(13);
+  EXPECT_EQ(300, m_transfers.countActualBalance());
+
+  setBlockchainSize(12);
+  EXPECT_EQ(100, m_transfers.countActualBalance());
+  EXPECT_EQ(300, m_transfers.countPendingBalance());
+}
+
+TEST_F(WalletTransferDetailsTest, spentTransfersLeaveBalances) {
+  setBlockchainSize(20);
+  size_t first = addTransfer(1, 100);
+  addTransfer(2, 200);
+
+  m_transfers.markTransferDetailsSpent(first);
+  m_transfers.markTransferDetailsSpent(first);
+
+  EXPECT_TRUE(m_transfers.getTransferDetails(first).spent);
+  EXPECT_EQ(200, m_transfers.countActualBalance());
+  EXPECT_EQ(200, m_transfers.countPendingBalance());
+
+  std::list<size_t> selected;
+  EXPECT_EQ(200, m_transfers.selectTransfersToSend(1000, false, 0, selected));
+  ASSERT_EQ(1, selected.size());
+  EXPECT_NE(first, selected.front());
+}
+
+TEST_F(WalletTransferDetailsTest, timeLockedTransfersAreNotSelected) {
+  setBlockchainSize(20);
+  addTransfer(1, 100, static_cast<uint64_t>(time(NULL)) + 24 * 60 * 60);
+  addTransfer(2, 200, 30);
+
+  EXPECT_EQ(0, m_transfers.countActualBalance());
+  EXPECT_EQ(300, m_transfers.countPendingBalance());
+
+  std::list<size_t> selected;
+  EXPECT_EQ(0, m_transfers.selectTransfersToSend(100, false, 0, selected));
+  EXPECT_TRUE(selected.empty());
+}
+
+TEST_F(WalletTransferDetailsTest, selectionPicksDistinctUnlockedTransfers) {
+  setBlockchainSize(100);
+  for (uint64_t i = 0; i < 80; ++i) {
+    addTransfer(i, (i % 7 + 1) * 1000);
+  }
+
+  for (size_t round = 0; round < 10; ++round) {
+    std::list<size_t> selected;
+    uint64_t found = m_transfers.selectTransfersToSend(50000, false, 0, selected);
+    EXPECT_LE(50000, found);
+
+    std::set<size_t> unique(selected.begin(), selected.end());
+    EXPECT_EQ(selected.size(), unique.size());
+
+    uint64_t sum = 0;
+    for (size_t idx: selected) {
+      const CryptoNote::TransferDetails& td = m_transfers.getTransferDetails(idx);
+      EXPECT_TRUE(m_transfers.isTransferUnlocked(td));
+      sum += td.amount;
+    }
+
+    EXPECT_EQ(found, sum);
+  }
+
+  std::list<size_t> selected;
+  m_transfers.selectTransfersToSend(std::numeric_limits<uint64_t>::max(), false, 0, selected);
+  EXPECT_EQ(80, selected.size());
+  EXPECT_EQ(m_transfers.countActualBalance(), m_transfers.selectTransfersToSend(std::numeric_limits<uint64_t>::max(), false, 0, selected));
+}
+
+TEST_F(WalletTransferDetailsTest, dustIsSelectedLast) {
+  setBlockchainSize(100);
+  size_t dust = addTransfer(1, 20);
+  size_t money = addTransfer(2, 70);
+  addTransfer(3, 5);
+
+  std::list<size_t> selected;
+  m_transfers.selectTransfersToSend(1, false, 50, selected);
+  ASSERT_EQ(1, selected.size());
+  EXPECT_EQ(money, selected.front());
+
+  selected.clear();
+  m_transfers.selectTransfersToSend(100, false, 50, selected);
+  ASSERT_EQ(3, selected.size());
+  EXPECT_EQ(money, selected.front());
+
+  selected.clear();
+  m_transfers.selectTransfersToSend(1, true, 10, selected);
+  ASSERT_EQ(1, selected.size());
+  EXPECT_NE(money, selected.front());
+  EXPECT_NE(dust, selected.front());
+}
+
+TEST_F(WalletTransferDetailsTest, detachRemovesTransfers) {
+  setBlockchainSize(30);
+  addTransfer(5, 100);
+  addTransfer(10, 200);
+  addTransfer(10, 300);
+  addTransfer(12, 400);
+
+  EXPECT_EQ(1000, m_transfers.countActualBalance());
+
+  m_transfers.detachTransferDetails(10);
+  setBlockchainSize(10);
+
+  EXPECT_EQ(100, m_transfers.countPendingBalance());
+  EXPECT_EQ(0, m_transfers.countActualBalance());
+
+  std::list<size_t> selected;
+  EXPECT_EQ(0, m_transfers.selectTransfersToSend(100, false, 0, selected));
+
+  addTransfer(10, 500);
+  setBlockchainSize(20);
+  EXPECT_EQ(600, m_transfers.countActualBalance());
+  EXPECT_EQ(600, m_transfers.selectTransfersToSend(1000, false, 0, selected));
+}
@@ -20,15 +20,22 @@
 #include <future>
 #include <chrono>
 #include <array>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 
 #include "INode.h"
 #include "wallet/Wallet.h"
 #include "cryptonote_core/account.h"
 #include "cryptonote_core/Currency.h"
 
+#include "wallet/WalletSerialization.h"
 #include "INodeStubs.h"
 #include "TestBlockchainGenerator.h"
 
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
 class TrivialWalletObserver : public CryptoNote::IWalletObserver
 {
 public:
@@ -116,6 +123,28 @@ public:
   std::promise<std::error_code> loadPromise;
 };
 
+class BatchSendWalletObserver : public CryptoNote::IWalletObserver
+{
+public:
+  BatchSendWalletObserver(size_t expectedCount) : expectedCount(expectedCount) {}
+
+  bool waitForSendEnd() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return condition.wait_for(lock, std::chrono::seconds(5), [this] { return results.size() >= expectedCount; });
+  }
+
+  virtual void sendTransactionCompleted(CryptoNote::TransactionId transactionId, std::error_code result) {
+    std::unique_lock<std::mutex> lock(mutex);
+    results[transactionId] = result;
+    condition.notify_all();
+  }
+
+  size_t expectedCount;
+  std::map<CryptoNote::TransactionId, std::error_code> results;
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+
 struct SaveOnInitWalletObserver: public CryptoNote::IWalletObserver {
   SaveOnInitWalletObserver(CryptoNote::Wallet* wallet) : wallet(wallet) {};
   virtual ~SaveOnInitWalletObserver() {}
@@ -349,6 +378,43 @@ TEST_F(WalletApi, refreshWithMoney) {
   alice->shutdown();
 }
 
+TEST_F(WalletApi, refreshInPortions) {
+  const size_t REWARDS_COUNT = 40;
+  const size_t PORTION_SIZE = 7;
+
+  aliceNode->setGetNewBlocksLimit(PORTION_SIZE);
+  alice->initAndGenerate("pass");
+
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  cryptonote::AccountPublicAddress address;
+  ASSERT_TRUE(m_currency.parseAccountAddressString(alice->getAddress(), address));
+  for (size_t i = 0; i < REWARDS_COUNT; ++i) {
+    generator.getBlockRewardForAddress(address);
+  }
+
+  alice->startRefresh();
+
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  ASSERT_EQ(alice->getTransactionCount(), REWARDS_COUNT);
+
+  //transactions are reported in the blockchain order whatever thread has found them
+  uint64_t prevHeight = 0;
+  int64_t received = 0;
+  for (size_t i = 0; i < REWARDS_COUNT; ++i) {
+    CryptoNote::TransactionInfo tx;
+    ASSERT_TRUE(alice->getTransaction(i, tx));
+    EXPECT_LT(prevHeight, tx.blockHeight);
+    prevHeight = tx.blockHeight;
+    received += tx.totalAmount;
+  }
+
+  EXPECT_EQ(alice->pendingBalance(), received);
+
+  alice->shutdown();
+}
+
 TEST_F(WalletApi, initWithMoney) {
   std::stringstream archive;
 
@@ -377,6 +443,120 @@ TEST_F(WalletApi, initWithMoney) {
   alice->shutdown();
 }
 
+TEST_F(WalletApi, saveChangesAndLoad) {
+  std::stringstream archive;
+
+  alice->initAndGenerate("pass");
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  EXPECT_THROW(alice->saveChanges(archive), std::system_error);
+  EXPECT_TRUE(alice->needsCompaction());
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  alice->save(archive, true, true);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+  size_t snapshotSize = archive.str().size();
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  alice->saveChanges(archive);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+  size_t changesSize = archive.str().size() - snapshotSize;
+
+  EXPECT_LT(changesSize, snapshotSize);
+  EXPECT_FALSE(alice->needsCompaction());
+
+  alice->shutdown();
+
+  prepareAliceWallet();
+  alice->initAndLoad(archive, "pass");
+
+  //nothing is left to synchronize, so both rewards come from the journal
+  std::error_code result;
+  ASSERT_NO_FATAL_FAILURE(WaitWalletLoad(aliceWalletObserver.get(), result));
+  ASSERT_EQ(result.value(), 0);
+
+  EXPECT_EQ(alice->getTransactionCount(), 2);
+  EXPECT_EQ(alice->pendingBalance(), 2 * TEST_BLOCK_REWARD);
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  EXPECT_EQ(alice->getTransactionCount(), 3);
+
+  alice->shutdown();
+}
+
+TEST_F(WalletApi, loadDropsTornChanges) {
+  std::stringstream archive;
+
+  alice->initAndGenerate("pass");
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  alice->save(archive, true, true);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  alice->saveChanges(archive);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+
+  alice->shutdown();
+
+  //a crash in the middle of the append
+  std::string saved = archive.str();
+  std::stringstream torn(saved.substr(0, saved.size() - 10));
+
+  prepareAliceWallet();
+  alice->initAndLoad(torn, "pass");
+
+  //the dropped changes are synchronized again
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+  EXPECT_EQ(alice->getTransactionCount(), 2);
+  EXPECT_EQ(alice->pendingBalance(), 2 * TEST_BLOCK_REWARD);
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  //changes appended after the torn record would never be read back
+  EXPECT_TRUE(alice->needsCompaction());
+  EXPECT_THROW(alice->saveChanges(torn), std::system_error);
+
+  std::stringstream rewritten;
+  alice->save(rewritten, true, true);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+  alice->shutdown();
+
+  prepareAliceWallet();
+  alice->initAndLoad(rewritten, "pass");
+
+  std::error_code result;
+  ASSERT_NO_FATAL_FAILURE(WaitWalletLoad(aliceWalletObserver.get(), result));
+  ASSERT_EQ(result.value(), 0);
+
+  EXPECT_EQ(alice->getTransactionCount(), 3);
+  EXPECT_EQ(alice->pendingBalance(), 3 * TEST_BLOCK_REWARD);
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  alice->shutdown();
+}
+
 TEST_F(WalletApi, TransactionsAndTransfersAfterSend) {
   prepareBobWallet();
   prepareCarolWallet();
@@ -578,6 +758,101 @@ TEST_F(WalletApi, sendMoneySuccessWithMixin) {
   ASSERT_NO_FATAL_FAILURE(TestSendMoney(10000000, 1000000, 3));
 }
 
+TEST_F(WalletApi, sendTransactionsBatch) {
+  prepareBobWallet();
+
+  alice->initAndGenerate("pass");
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  //each reward is a single output, so every transaction of the batch needs its own
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  }
+
+  //unblock Alice's money
+  generator.generateEmptyBlocks(10);
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  bob->initAndGenerate("pass2");
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(bobWalletObserver.get()));
+
+  const uint64_t fee = 1000000;
+  const int64_t amounts[] = { 10000000, 20000000, 30000000 };
+  const uint64_t mixIns[] = { 0, 2, 3 };
+
+  std::vector<CryptoNote::TransactionParameters> transactions;
+  for (size_t i = 0; i < 3; ++i) {
+    CryptoNote::TransactionParameters params;
+    params.transfers.push_back(CryptoNote::Transfer{ bob->getAddress(), amounts[i] });
+    params.fee = fee;
+    params.mixIn = mixIns[i];
+    params.unlockTimestamp = 0;
+    transactions.push_back(params);
+  }
+
+  //the trivial observer expects a single completed send
+  BatchSendWalletObserver batchObserver(transactions.size());
+  alice->removeObserver(aliceWalletObserver.get());
+  alice->addObserver(&batchObserver);
+
+  std::vector<CryptoNote::TransactionId> txIds = alice->sendTransactions(transactions);
+  ASSERT_EQ(transactions.size(), txIds.size());
+  ASSERT_TRUE(batchObserver.waitForSendEnd());
+
+  alice->removeObserver(&batchObserver);
+  alice->addObserver(aliceWalletObserver.get());
+
+  for (size_t i = 0; i < txIds.size(); ++i) {
+    ASSERT_EQ(1, batchObserver.results.count(txIds[i]));
+    EXPECT_FALSE(batchObserver.results[txIds[i]]);
+
+    CryptoNote::TransactionInfo tx;
+    ASSERT_TRUE(alice->getTransaction(txIds[i], tx));
+    EXPECT_EQ(amounts[i] + fee, tx.totalAmount);
+    EXPECT_EQ(1, tx.transferCount);
+  }
+
+  generator.generateEmptyBlocks(10);
+
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  bob->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(bobWalletObserver.get()));
+
+  uint64_t sent = amounts[0] + amounts[1] + amounts[2];
+  EXPECT_EQ(sent, bob->actualBalance());
+  EXPECT_EQ(3 * TEST_BLOCK_REWARD - sent - 3 * fee, alice->actualBalance());
+
+  alice->shutdown();
+  bob->shutdown();
+}
+
+TEST_F(WalletApi, sendTransactionsBatchWrongAmount) {
+  alice->initAndGenerate("pass");
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  ASSERT_NO_FATAL_FAILURE(GetOneBlockReward(*alice));
+  generator.generateEmptyBlocks(10);
+  alice->startRefresh();
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  //every transaction can be funded alone, the whole batch can't
+  std::vector<CryptoNote::TransactionParameters> transactions(2);
+  for (auto& params: transactions) {
+    params.transfers.push_back(CryptoNote::Transfer{ alice->getAddress(), static_cast<int64_t>(TEST_BLOCK_REWARD * 2 / 3) });
+    params.fee = 1000000;
+    params.mixIn = 0;
+    params.unlockTimestamp = 0;
+  }
+
+  EXPECT_THROW(alice->sendTransactions(transactions), std::system_error);
+  EXPECT_EQ(1, alice->getTransactionCount());
+
+  alice->shutdown();
+}
+
 TEST_F(WalletApi, getTransactionSuccess) {
   alice->initAndGenerate("pass");
 
@@ -673,6 +948,34 @@ TEST_F(WalletApi, wrongPassword) {
   EXPECT_EQ(result.value(), cryptonote::error::WRONG_PASSWORD);
 }
 
+TEST_F(WalletApi, saveAfterChangePasswordUsesNewPassword) {
+  alice->initAndGenerate("pass");
+
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSync(aliceWalletObserver.get()));
+
+  //the first save derives the key of the old password
+  std::stringstream oldArchive;
+  alice->save(oldArchive, true, false);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+
+  ASSERT_FALSE(alice->changePassword("pass", "newpass"));
+
+  std::stringstream archive;
+  alice->save(archive, true, false);
+  ASSERT_NO_FATAL_FAILURE(WaitWalletSave(aliceWalletObserver.get()));
+
+  alice->shutdown();
+
+  prepareAliceWallet();
+  alice->initAndLoad(archive, "newpass");
+
+  std::error_code result;
+  ASSERT_NO_FATAL_FAILURE(WaitWalletLoad(aliceWalletObserver.get(), result));
+  EXPECT_EQ(result.value(), 0);
+
+  alice->shutdown();
+}
+
 TEST_F(WalletApi, detachBlockchain) {
   alice->initAndGenerate("pass");
 
@@ -809,3 +1112,87 @@ TEST_F(WalletApi, saveAndLoadErroneousTxsCacheNoDetails) {
 
   alice->shutdown();
 }
+
+namespace {
+
+//layout of transfer details in the wallets saved before the compact format
+struct LegacyTransferDetails
+{
+  uint64_t blockHeight;
+  cryptonote::Transaction tx;
+  size_t internalOutputIndex;
+  uint64_t globalOutputIndex;
+  bool spent;
+  crypto::key_image keyImage;
+
+  template<class Archive>
+  void serialize(Archive& ar, const unsigned int version)
+  {
+    ar & blockHeight;
+    ar & tx;
+    ar & internalOutputIndex;
+    ar & globalOutputIndex;
+    ar & spent;
+    ar & keyImage;
+  }
+};
+
+}
+
+TEST(WalletSerialization, loadLegacyTransferDetails) {
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  cryptonote::account_base account;
+  account.generate();
+
+  LegacyTransferDetails legacy;
+  ASSERT_TRUE(currency.constructMinerTx(0, 0, 0, 2, 0, account.get_keys().m_account_address, legacy.tx));
+  legacy.blockHeight = 10;
+  legacy.internalOutputIndex = legacy.tx.vout.size() - 1;
+  legacy.globalOutputIndex = 25;
+  legacy.spent = true;
+  memset(&legacy.keyImage, 0x5a, sizeof(legacy.keyImage));
+
+  std::stringstream stream;
+  {
+    boost::archive::binary_oarchive ar(stream);
+    ar << std::vector<LegacyTransferDetails>(1, legacy);
+  }
+
+  std::vector<CryptoNote::TransferDetails> transfers;
+  {
+    boost::archive::binary_iarchive ar(stream);
+    ar >> transfers;
+  }
+
+  ASSERT_EQ(1, transfers.size());
+  const CryptoNote::TransferDetails& td = transfers.front();
+  const cryptonote::TransactionOutput& out = legacy.tx.vout[legacy.internalOutputIndex];
+
+  EXPECT_EQ(legacy.blockHeight, td.blockHeight);
+  EXPECT_EQ(out.amount, td.amount);
+  EXPECT_EQ(boost::get<cryptonote::TransactionOutputToKey>(out.target).key, td.outputKey);
+  EXPECT_EQ(cryptonote::get_tx_pub_key_from_extra(legacy.tx), td.transactionPublicKey);
+  EXPECT_EQ(legacy.tx.unlockTime, td.unlockTime);
+  EXPECT_EQ(legacy.internalOutputIndex, td.internalOutputIndex);
+  EXPECT_EQ(legacy.globalOutputIndex, td.globalOutputIndex);
+  EXPECT_EQ(legacy.spent, td.spent);
+  EXPECT_EQ(legacy.keyImage, td.keyImage);
+
+  std::stringstream compact;
+  {
+    boost::archive::binary_oarchive ar(compact);
+    ar << transfers;
+  }
+
+  std::vector<CryptoNote::TransferDetails> reloaded;
+  {
+    boost::archive::binary_iarchive ar(compact);
+    ar >> reloaded;
+  }
+
+  ASSERT_EQ(1, reloaded.size());
+  EXPECT_EQ(td.amount, reloaded.front().amount);
+  EXPECT_EQ(td.outputKey, reloaded.front().outputKey);
+  EXPECT_EQ(td.keyImage, reloaded.front().keyImage);
+  EXPECT_LT(compact.str().size(), stream.str().size());
+}
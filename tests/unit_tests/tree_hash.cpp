@@ -0,0 +1,122 @@
+// Copyright (c) 2012-2014, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/TreeHash.h"
+
+using namespace cryptonote;
+
+namespace
+{
+  crypto::hash fullTreeHash(const std::vector<crypto::hash>& hashes)
+  {
+    crypto::hash root;
+    crypto::tree_hash(hashes.data(), hashes.size(), root);
+    return root;
+  }
+
+  crypto::hash randomHash(std::mt19937& gen)
+  {
+    crypto::hash h;
+    for (size_t i = 0; i < sizeof(h); ++i)
+    {
+      reinterpret_cast<uint8_t*>(&h)[i] = static_cast<uint8_t>(gen());
+    }
+    return h;
+  }
+}
+
+TEST(TreeHash, rootMatchesTreeHashWhileGrowingAndShrinking)
+{
+  std::mt19937 gen(1);
+  TreeHash tree;
+  for (size_t i = 0; i < 300; ++i)
+  {
+    tree.push_back(randomHash(gen));
+    ASSERT_EQ(fullTreeHash(tree.hashes()), tree.root()) << "size " << tree.size();
+  }
+  while (tree.size() > 1)
+  {
+    tree.pop_back();
+    ASSERT_EQ(fullTreeHash(tree.hashes()), tree.root()) << "size " << tree.size();
+  }
+}
+
+TEST(TreeHash, rootMatchesTreeHashAfterRandomChanges)
+{
+  std::mt19937 gen(2);
+  TreeHash tree;
+  tree.push_back(randomHash(gen));
+  for (size_t step = 0; step < 3000; ++step)
+  {
+    // several changes between two roots, as between two block templates
+    size_t changes = 1 + gen() % 4;
+    for (size_t i = 0; i < changes; ++i)
+    {
+      switch (gen() % 4)
+      {
+      case 0:
+        tree.replace(gen() % tree.size(), randomHash(gen));
+        break;
+      case 1:
+        tree.insert(gen() % (tree.size() + 1), randomHash(gen));
+        break;
+      case 2:
+        if (tree.size() > 1)
+          tree.erase(gen() % tree.size());
+        break;
+      default:
+        tree.push_back(randomHash(gen));
+        break;
+      }
+    }
+    ASSERT_EQ(fullTreeHash(tree.hashes()), tree.root()) << "step " << step << ", size " << tree.size();
+  }
+}
+
+TEST(TreeHash, assignKeepsUnchangedHashes)
+{
+  std::mt19937 gen(3);
+  std::vector<crypto::hash> hashes;
+  TreeHash tree;
+  for (size_t step = 0; step < 200; ++step)
+  {
+    // a new miner transaction and a few transactions more or less at the end
+    if (hashes.empty())
+      hashes.push_back(randomHash(gen));
+    hashes[0] = randomHash(gen);
+    size_t added = gen() % 5;
+    for (size_t i = 0; i < added; ++i)
+      hashes.push_back(randomHash(gen));
+    size_t removed = std::min<size_t>(gen() % 3, hashes.size() - 1);
+    hashes.resize(hashes.size() - removed);
+
+    tree.assign(hashes);
+    ASSERT_EQ(hashes, tree.hashes());
+    ASSERT_EQ(fullTreeHash(hashes), tree.root()) << "step " << step << ", size " << hashes.size();
+  }
+
+  tree.clear();
+  ASSERT_TRUE(tree.empty());
+  tree.push_back(hashes[0]);
+  ASSERT_EQ(hashes[0], tree.root());
+}